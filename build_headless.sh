@@ -0,0 +1,13 @@
+#!/bin/sh
+# The command line half of the program, without the window: -benchmark, -import, -export,
+# -bulk-import, -export-calendar and -export-collisions. Builds on Linux with g++, or $CXX,
+# and puts the program in run_tree, next to save.bin, where the Visual Studio build goes.
+
+cd "$(dirname "$0")/src" || exit 1
+
+${CXX:-g++} -std=c++20 -O2 -Wno-write-strings -DHEADLESS=1 -o ../run_tree/vacation_headless \
+    main.cpp general.cpp os_linux.cpp \
+    vacation.cpp occupancy.cpp overlap_kernel.cpp string_pool.cpp job_system.cpp \
+    save_file.cpp journal.cpp text_file_handler.cpp bulk_import.cpp exporter.cpp \
+    benchmark.cpp \
+    -lpthread
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <new> // Placement new.
+
 template <typename Array>
 struct Array_Iterator {
     using Value_Type = typename Array::Value_Type;
@@ -55,23 +57,45 @@ struct Array_Iterator {
     Pointer_Type ptr;
 };
 
+// Adding grows the array to at least twice its size, so adding n items one at a time
+// copies O(n) of them; reserve is for when the final size is known, and gets exactly that.
+//
+// Items that can be copied as bytes are moved around with realloc and memmove, and
+// aren't initialized by resize and add_n(n). Anything else, like a struct with an
+// Array in it, is constructed, moved and destroyed one at a time, the way C++ wants.
+//
+// An Array can't be copied, since both would free the same items; moving it leaves the
+// old one empty.
 template <typename T>
 struct Array {
     using Value_Type = T;
     using Iterator = Array_Iterator<Array<T>>;
+
+    static const bool MOVED_AS_BYTES = __is_trivially_copyable(T);
     
     T *data = NULL;
     int allocated = 0;
     int count = 0;
 
+    Array() = default;
+    Array(Array const &other) = delete;
+    Array(Array &&other);
     ~Array();
 
+    Array &operator=(Array const &other) = delete;
+    Array &operator=(Array &&other);
+
     void reserve(int size);
     void resize(int size);
+    void shrink_to_fit();
     void add(T const &item);
     T *add();
+    T *add_n(int n); // The new items are only initialized if they have to be, see above.
+    void add_n(T const *items, int n);
+    void insert_range(int index, T const *items, int n); // 'items' can't be in this array.
     int find(T const &item);
     void ordered_remove_by_index(int n);
+    void unordered_remove_by_index(int n); // The last item takes its place.
 
     T *copy_to_array();
     
@@ -80,53 +104,166 @@ struct Array {
 
     inline Iterator begin() { return data; }
     inline Iterator end() { return data + count; }
+
+private:
+    void set_allocated(int new_allocated);
+    void grow(int size);
+    void destroy_items(int first, int last);
 };
 
+template <typename T>
+inline Array <T>::Array(Array &&other) {
+    data      = other.data;
+    allocated = other.allocated;
+    count     = other.count;
+
+    other.data      = NULL;
+    other.allocated = 0;
+    other.count     = 0;
+}
+
 template <typename T>
 inline Array <T>::~Array() {
     if (data) {
+        destroy_items(0, count);
         free(data);
         data = NULL;
     }
 }
 
 template <typename T>
-inline void Array <T>::reserve(int size) {
-    if (allocated >= size) return;
+inline Array <T> &Array <T>::operator=(Array &&other) {
+    if (this == &other) return *this;
 
-    int new_allocated = Max(allocated, size);
-    new_allocated = Max(new_allocated, 32);
+    this->~Array();
+    new (this) Array(static_cast<Array &&>(other));
+    return *this;
+}
 
-    int new_bytes = new_allocated * sizeof(T);
-    int old_bytes = allocated * sizeof(T);
+template <typename T>
+inline void Array <T>::destroy_items(int first, int last) {
+    if constexpr (MOVED_AS_BYTES) return;
+    for (int i = first; i < last; i++) data[i].~T();
+}
 
-    void *new_data = malloc(new_bytes);
-    if (data) {
-        memcpy(new_data, data, old_bytes);
-        free(data);
+template <typename T>
+inline void Array <T>::set_allocated(int new_allocated) {
+    assert(new_allocated >= count);
+
+    if (!new_allocated) {
+        if (data) free(data);
+        data = NULL;
+        allocated = 0;
+        return;
     }
 
-    data = (T *)new_data;
+    T *new_data;
+    if constexpr (MOVED_AS_BYTES) {
+        new_data = (T *)realloc(data, (size_t)new_allocated * sizeof(T));
+        assert(new_data);
+    } else {
+        new_data = (T *)malloc((size_t)new_allocated * sizeof(T));
+        assert(new_data);
+
+        for (int i = 0; i < count; i++) {
+            new (new_data + i) T(static_cast<T &&>(data[i]));
+            data[i].~T();
+        }
+        if (data) free(data);
+    }
+
+    data = new_data;
     allocated = new_allocated;
 }
 
+template <typename T>
+inline void Array <T>::reserve(int size) {
+    if (allocated >= size) return;
+    set_allocated(Max(size, 32));
+}
+
+template <typename T>
+inline void Array <T>::grow(int size) {
+    if (allocated >= size) return;
+
+    s64 doubled = Min((s64)allocated * 2, (s64)0x7fffffff);
+    set_allocated((int)Max((s64)Max(size, 32), doubled));
+}
+
 template <typename T>
 inline void Array <T>::resize(int size) {
-    reserve(size);
-    count = size;
+    if (size < count) {
+        destroy_items(size, count);
+        count = size;
+        return;
+    }
+
+    add_n(size - count);
+}
+
+template <typename T>
+inline void Array <T>::shrink_to_fit() {
+    if (allocated > count) set_allocated(count);
 }
 
 template <typename T>
 inline void Array <T>::add(T const &item) {
-    reserve(count+1);
-    data[count] = item;
+    if (count == allocated) {
+        T copy = item; // It could be in here.
+        grow(count+1);
+        new (data + count) T(static_cast<T &&>(copy));
+    } else {
+        new (data + count) T(item);
+    }
     count++;
 }
 
 template <typename T>
 inline T *Array <T>::add() {
-    add({});
-    return &data[count-1];
+    grow(count+1);
+    new (data + count) T();
+    return &data[count++];
+}
+
+template <typename T>
+inline T *Array <T>::add_n(int n) {
+    grow(count+n);
+    T *result = data + count;
+    if constexpr (!MOVED_AS_BYTES) {
+        for (int i = 0; i < n; i++) new (result + i) T();
+    }
+    count += n;
+    return result;
+}
+
+template <typename T>
+inline void Array <T>::add_n(T const *items, int n) {
+    grow(count+n);
+    if constexpr (MOVED_AS_BYTES) {
+        memcpy(data + count, items, (size_t)n * sizeof(T));
+    } else {
+        for (int i = 0; i < n; i++) new (data + count + i) T(items[i]);
+    }
+    count += n;
+}
+
+template <typename T>
+inline void Array <T>::insert_range(int index, T const *items, int n) {
+    assert(index >= 0);
+    assert(index <= count);
+
+    grow(count+n);
+    if constexpr (MOVED_AS_BYTES) {
+        memmove(data + index + n, data + index, (size_t)(count - index) * sizeof(T));
+        memcpy(data + index, items, (size_t)n * sizeof(T));
+    } else {
+        for (int i = count - 1; i >= index; i--) {
+            new (data + i + n) T(static_cast<T &&>(data[i]));
+            data[i].~T();
+        }
+        for (int i = 0; i < n; i++) new (data + index + i) T(items[i]);
+    }
+    count += n;
 }
 
 template <typename T>
@@ -139,12 +276,28 @@ inline int Array <T>::find(T const &item) {
 
 template <typename T>
 inline void Array <T>::ordered_remove_by_index(int n) {
-    for (int i = n; i < count-1; i++) {
-        data[i] = data[i+1];
+    assert(n >= 0);
+    assert(n < count);
+
+    if constexpr (MOVED_AS_BYTES) {
+        memmove(data + n, data + n + 1, (size_t)(count - n - 1) * sizeof(T));
+    } else {
+        for (int i = n; i < count-1; i++) data[i] = static_cast<T &&>(data[i+1]);
+        data[count-1].~T();
     }
     count--;
 }
 
+template <typename T>
+inline void Array <T>::unordered_remove_by_index(int n) {
+    assert(n >= 0);
+    assert(n < count);
+
+    if (n != count-1) data[n] = static_cast<T &&>(data[count-1]);
+    destroy_items(count-1, count);
+    count--;
+}
+
 template <typename T>
 inline T const &Array <T>::operator[](int index) const {
     assert(index >= 0);
@@ -162,6 +315,6 @@ inline T &Array <T>::operator[](int index) {
 template <typename T>
 inline T *Array <T>::copy_to_array() {
     T *result = new T[count];
-    memcpy(result, data, count * sizeof(T));
+    for (int i = 0; i < count; i++) result[i] = data[i];
     return result;
 }
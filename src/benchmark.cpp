@@ -0,0 +1,2935 @@
+#include "pch.h"
+#include "benchmark.h"
+#include "os_specific.h"
+#include "vacation.h"
+#include "overlap_kernel.h"
+#include "occupancy.h"
+#include "job_system.h"
+#include "save_file.h"
+#include "journal.h"
+#include "text_file_handler.h"
+#include "bulk_import.h"
+#include "exporter.h"
+
+#include <stdio.h>
+#include <vector> // Only to compare Array with.
+
+//
+// Run with: vacation.exe -benchmark [name]
+// Without a name every benchmark is run.
+//
+
+// Every check that fails goes through here, so that -benchmark can exit with an error.
+static int num_failed_checks = 0;
+
+static void report_failed_check(char *fmt, ...) {
+    char buf[4096];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    num_failed_checks += 1;
+    log_error("%s", buf);
+}
+
+static u64 random_state = 0x853c49e6748fea9bULL;
+
+static u32 random_u32() {
+    // xorshift64*
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (u32)((random_state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static int random_int(int min, int max) {
+    return min + (int)(random_u32() % (u32)(max - min + 1));
+}
+
+static void destroy_all_employees() {
+    for (auto employee : all_employees) {
+        if (!employee->name_is_borrowed) delete [] employee->name;
+        delete employee;
+    }
+    all_employees.count = 0;
+    vacation_store.clear();
+    forget_unloaded_vacations();
+
+    update_collding_for_all_infos(); // Forget about the vacations we just deleted.
+}
+
+// Roughly ten vacations per employee, spread over a few years, which is what
+// a real roster with some history looks like.
+static void generate_random_roster(int num_vacations) {
+    destroy_all_employees();
+
+    int num_employees = num_vacations / 10;
+    if (num_employees < 1) num_employees = 1;
+
+    for (int i = 0; i < num_employees; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "Employee %d", i);
+        add_employee(name);
+    }
+
+    for (int i = 0; i < num_vacations; i++) {
+        auto employee = all_employees[random_int(0, num_employees - 1)];
+
+        int year  = random_int(2020, 2025);
+        int month = random_int(1, 12);
+        int day   = random_int(1, 20);
+        int days  = random_int(1, 8);
+        
+        s32 from = date_to_day_number(day, month, year);
+        employee->add_vacation_info(from, from + days);
+    }
+}
+
+// Back to back one-day vacations, so nothing collides and the nested check can't stop early.
+static void generate_roster_without_collisions(int num_vacations) {
+    destroy_all_employees();
+
+    int num_employees = num_vacations / 10;
+    if (num_employees < 1) num_employees = 1;
+
+    for (int i = 0; i < num_employees; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "Employee %d", i);
+        add_employee(name);
+    }
+
+    s32 first_day = date_to_day_number(1, 1, 2020);
+    for (int i = 0; i < num_vacations; i++) {
+        auto employee = all_employees[random_int(0, num_employees - 1)];
+        employee->add_vacation_info(first_day + i, first_day + i + 1);
+    }
+}
+
+static Employee *random_employee_with_vacations() {
+    while (true) {
+        auto employee = all_employees[random_int(0, all_employees.count - 1)];
+        if (employee->num_vacations) return employee;
+    }
+}
+
+static void clear_collision_flags() {
+    for (auto employee : all_employees) {
+        employee->has_vacation_that_overlaps = false;
+    }
+    for (int row = 0; row < vacation_store.count; row++) {
+        vacation_store.flags[row] &= ~VACATION_IS_COLLIDING;
+    }
+}
+
+static void save_collision_flags(Array <bool> *flags) {
+    flags->count = 0;
+    flags->reserve(all_employees.count + vacation_store.count);
+    for (auto employee : all_employees) {
+        flags->add(employee->has_vacation_that_overlaps);
+    }
+    for (int row = 0; row < vacation_store.count; row++) {
+        flags->add((vacation_store.flags[row] & VACATION_IS_COLLIDING) != 0);
+    }
+}
+
+static bool collision_flags_match(Array <bool> *a, Array <bool> *b) {
+    if (a->count != b->count) return false;
+
+    for (int i = 0; i < a->count; i++) {
+        if ((*a)[i] != (*b)[i]) return false;
+    }
+    return true;
+}
+
+static void benchmark_collisions() {
+    int sizes[] = { 100, 1000, 10000, 100000 };
+
+    log("%-12s %14s %14s %14s %10s %12s\n", "vacations", "nested (ms)", "kernel (ms)", "sweep (ms)", "speedup", "pairs");
+    
+    for (int size : sizes) {
+        generate_random_roster(size);
+
+        clear_collision_flags();
+        double t0 = os_get_time();
+        bool brute_force_result = are_vacations_colliding_brute_force();
+        double t1 = os_get_time();
+
+        Array <bool> brute_force_flags;
+        save_collision_flags(&brute_force_flags);
+
+        clear_collision_flags();
+        double kernel_t0 = os_get_time();
+        bool kernel_result = are_vacations_colliding_with_kernel();
+        double kernel_t1 = os_get_time();
+
+        Array <bool> kernel_flags;
+        save_collision_flags(&kernel_flags);
+        
+        // The sweep is fast enough that a single run is too noisy.
+        int iterations = 0;
+        bool sweep_result = false;
+        double t2 = os_get_time();
+        double t3 = t2;
+        while (iterations < 5 || t3 - t2 < 0.25) {
+            clear_collision_flags();
+            sweep_result = sweep_for_colliding_vacations();
+            t3 = os_get_time();
+            iterations++;
+        }
+
+        Array <bool> sweep_flags;
+        save_collision_flags(&sweep_flags);
+
+        bool flags_match = (brute_force_result == sweep_result) && collision_flags_match(&brute_force_flags, &sweep_flags);
+        bool kernel_matches = (brute_force_result == kernel_result) && collision_flags_match(&brute_force_flags, &kernel_flags);
+        
+        Array <Vacation_Collision> collisions;
+        find_colliding_vacations(&collisions);
+        
+        double nested_ms = (t1 - t0) * 1000.0;
+        double kernel_ms = (kernel_t1 - kernel_t0) * 1000.0;
+        double sweep_ms  = (t3 - t2) * 1000.0 / iterations;
+        log("%-12d %14.3f %14.3f %14.3f %9.1fx %12d\n", size, nested_ms, kernel_ms, sweep_ms, nested_ms / sweep_ms, collisions.count);
+
+        if (!flags_match) {
+            report_failed_check("Sweep and nested loop disagree on the collision flags for %d vacations!\n", size);
+        }
+        if (!kernel_matches) {
+            report_failed_check("The overlap kernel and the nested loop disagree on the collision flags for %d vacations!\n", size);
+        }
+    }
+
+    destroy_all_employees();
+}
+
+static void benchmark_incremental_collisions() {
+    int sizes[] = { 1000, 10000, 100000 };
+    const int NUM_EDITS = 1000;
+
+    log("%-12s %16s %16s %16s %16s\n", "vacations", "rebuild (ms)", "add (us)", "edit (us)", "remove (us)");
+
+    for (int size : sizes) {
+        generate_random_roster(size);
+
+        double t0 = os_get_time();
+        update_collding_for_all_infos();
+        double t1 = os_get_time();
+
+        for (int i = 0; i < NUM_EDITS; i++) {
+            auto employee = random_employee_with_vacations();
+            int year  = random_int(2020, 2025);
+            int month = random_int(1, 12);
+            int day   = random_int(1, 20);
+            s32 from = date_to_day_number(day, month, year);
+            employee->add_vacation_info(from, from + random_int(1, 8));
+        }
+        double t2 = os_get_time();
+        
+        for (int i = 0; i < NUM_EDITS; i++) {
+            auto employee = random_employee_with_vacations();
+            int year  = random_int(2020, 2025);
+            int month = random_int(1, 12);
+            int day   = random_int(1, 20);
+            s32 from = date_to_day_number(day, month, year);
+            employee->edit_vacation_info(random_int(0, employee->num_vacations - 1), from, from + random_int(1, 8));
+        }
+        double t3 = os_get_time();
+
+        for (int i = 0; i < NUM_EDITS; i++) {
+            auto employee = random_employee_with_vacations();
+            employee->remove_vacation_info(random_int(0, employee->num_vacations - 1));
+        }
+        double t4 = os_get_time();
+
+        log("%-12d %16.3f %16.3f %16.3f %16.3f\n", size,
+            (t1 - t0) * 1000.0,
+            (t2 - t1) * 1000000.0 / NUM_EDITS,
+            (t3 - t2) * 1000000.0 / NUM_EDITS,
+            (t4 - t3) * 1000000.0 / NUM_EDITS);
+
+        // Some employees going away leaves rows behind that belong to nobody, and sooner or later packs the table.
+        for (int i = 0; i < all_employees.count / 20; i++) {
+            remove_employee(all_employees[random_int(0, all_employees.count - 1)]);
+        }
+
+        // Whatever the index ended up with has to be what a full sweep says.
+        Array <bool> incremental_flags;
+        save_collision_flags(&incremental_flags);
+
+        clear_collision_flags();
+        sweep_for_colliding_vacations();
+
+        Array <bool> sweep_flags;
+        save_collision_flags(&sweep_flags);
+
+        if (!collision_flags_match(&incremental_flags, &sweep_flags)) {
+            report_failed_check("Incremental collision flags disagree with the sweep for %d vacations!\n", size);
+        }
+
+        update_collding_for_all_infos();
+    }
+
+    destroy_all_employees();
+}
+
+//
+// How dates used to be compared, before they became day numbers. Only here to
+// have something to compare the day numbers against.
+//
+struct Triple_Date {
+    int year;
+    int month;
+    int day;
+};
+
+static inline bool operator<(Triple_Date a, Triple_Date b) {
+    if (a.day == b.day && a.month == b.month && a.year == b.year)
+        return false;
+
+    if (a.year > b.year || a.year == b.year && a.month > b.month ||
+        a.year == b.year && a.month == b.month && a.day > b.day)
+        return false;
+
+    return true;
+}
+
+static inline bool operator>(Triple_Date a, Triple_Date b) {
+    if (a.day == b.day && a.month == b.month && a.year == b.year)
+        return false;
+
+    if (a.year > b.year || a.year == b.year && a.month > b.month ||
+        a.year == b.year && a.month == b.month && a.day > b.day)
+        return true;
+
+    return false;
+}
+
+struct Triple_Vacation {
+    Triple_Date from;
+    Triple_Date to;
+};
+
+struct Packed_Vacation {
+    s32 from;
+    s32 to;
+};
+
+static void benchmark_overlap_kernel() {
+    const int NUM_VACATIONS = 4096;
+    const int NUM_PASSES    = 64;
+
+    Array <Triple_Vacation> triples;
+    Array <Packed_Vacation> packed;
+    triples.resize(NUM_VACATIONS);
+    packed.resize(NUM_VACATIONS);
+
+    for (int i = 0; i < NUM_VACATIONS; i++) {
+        s32 from = date_to_day_number(random_int(1, 28), random_int(1, 12), random_int(2020, 2025));
+        s32 to   = from + random_int(1, 14);
+
+        Date a = day_number_to_date(from);
+        Date b = day_number_to_date(to);
+        triples[i].from = { a.year, a.month, a.day };
+        triples[i].to   = { b.year, b.month, b.day };
+
+        packed[i].from = from;
+        packed[i].to   = to;
+    }
+
+    // Every vacation against a sliding window of the others, like the inner loop of the nested check.
+    const int WINDOW = 256;
+    s64 num_tests = (s64)NUM_PASSES * NUM_VACATIONS * WINDOW;
+    
+    int triple_overlaps = 0;
+    double t0 = os_get_time();
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        for (int i = 0; i < NUM_VACATIONS; i++) {
+            auto a = &triples[i];
+            for (int j = 0; j < WINDOW; j++) {
+                auto b = &triples[(i + pass + j) & (NUM_VACATIONS - 1)];
+                if (Max(a->from, b->from) < Min(a->to, b->to)) triple_overlaps++;
+            }
+        }
+    }
+    double t1 = os_get_time();
+
+    int packed_overlaps = 0;
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        for (int i = 0; i < NUM_VACATIONS; i++) {
+            auto a = &packed[i];
+            for (int j = 0; j < WINDOW; j++) {
+                auto b = &packed[(i + pass + j) & (NUM_VACATIONS - 1)];
+                if (Max(a->from, b->from) < Min(a->to, b->to)) packed_overlaps++;
+            }
+        }
+    }
+    double t2 = os_get_time();
+
+    log("%-16s %12s %12s\n", "representation", "ns/test", "overlaps");
+    log("%-16s %12.3f %12d\n", "day.month.year", (t1 - t0) * 1e9 / num_tests, triple_overlaps);
+    log("%-16s %12.3f %12d\n", "day number",     (t2 - t1) * 1e9 / num_tests, packed_overlaps);
+
+    if (triple_overlaps != packed_overlaps) {
+        report_failed_check("The two representations disagree on the number of overlaps!\n");
+    }
+}
+
+// Random intervals, including empty and inverted ones, against batches of every
+// length around the vector widths, so that the tails get tested too.
+static bool overlap_kernels_agree(Overlap_Kernel_Type type) {
+    const int MAX_BATCH = 64;
+    const int NUM_TRIALS = 100000;
+    
+    s32 starts[MAX_BATCH];
+    s32 ends[MAX_BATCH];
+    s32 employee_ids[MAX_BATCH];
+
+    auto scalar = get_overlap_kernel(OVERLAP_KERNEL_SCALAR);
+    auto kernel = get_overlap_kernel(type);
+
+    for (int trial = 0; trial < NUM_TRIALS; trial++) {
+        int count = random_int(0, MAX_BATCH);
+        for (int i = 0; i < count; i++) {
+            starts[i]       = random_int(0, 400);
+            ends[i]         = starts[i] + random_int(-2, 10);
+            employee_ids[i] = random_int(0, 3);
+        }
+
+        s32 start = random_int(0, 400);
+        s32 end   = start + random_int(-2, 10);
+        s32 id    = random_int(0, 3);
+
+        bool expected = scalar(start, end, id, starts, ends, employee_ids, count);
+        bool result   = kernel(start, end, id, starts, ends, employee_ids, count);
+        if (expected != result) return false;
+    }
+
+    return true;
+}
+
+static void benchmark_simd_overlap() {
+    Overlap_Kernel_Type types[] = { OVERLAP_KERNEL_SCALAR, OVERLAP_KERNEL_SSE2, OVERLAP_KERNEL_AVX2 };
+    int sizes[] = { 1000, 10000, 30000 };
+
+    log("Selected kernel: %s\n", get_overlap_kernel_name(overlap_kernel_type));
+    
+    for (auto type : types) {
+        if (!is_overlap_kernel_supported(type)) continue;
+        if (!overlap_kernels_agree(type)) {
+            report_failed_check("The %s overlap kernel disagrees with the scalar one!\n", get_overlap_kernel_name(type));
+        }
+    }
+
+    log("%-12s", "vacations");
+    for (auto type : types) {
+        if (!is_overlap_kernel_supported(type)) continue;
+        
+        char header[32];
+        snprintf(header, sizeof(header), "%s (ms)", get_overlap_kernel_name(type));
+        log(" %12s", header);
+    }
+    log("\n");
+    
+    auto selected = overlaps_any_other_employee;
+
+    // With the random roster almost every vacation collides with something early on,
+    // so the second half is the worst case, where every test has to go through everything.
+    for (int i = 0; i < 2 * (int)ArrayCount(sizes); i++) {
+        int size = sizes[i % ArrayCount(sizes)];
+        bool worst_case = i >= (int)ArrayCount(sizes);
+        if (worst_case) generate_roster_without_collisions(size);
+        else            generate_random_roster(size);
+
+        char label[32];
+        snprintf(label, sizeof(label), worst_case ? "%d*" : "%d", size);
+        log("%-12s", label);
+        
+        Array <bool> scalar_flags;
+        for (auto type : types) {
+            if (!is_overlap_kernel_supported(type)) continue;
+            overlaps_any_other_employee = get_overlap_kernel(type);
+
+            clear_collision_flags();
+            double t0 = os_get_time();
+            are_vacations_colliding_with_kernel();
+            double t1 = os_get_time();
+            log(" %12.3f", (t1 - t0) * 1000.0);
+
+            Array <bool> flags;
+            save_collision_flags(&flags);
+            if (type == OVERLAP_KERNEL_SCALAR) {
+                save_collision_flags(&scalar_flags);
+            } else if (!collision_flags_match(&scalar_flags, &flags)) {
+                report_failed_check("\nThe %s overlap kernel disagrees with the scalar one for %d vacations!\n", get_overlap_kernel_name(type), size);
+            }
+        }
+        log("\n");
+    }
+    log("* no collisions\n");
+
+    overlaps_any_other_employee = selected;
+    destroy_all_employees();
+}
+
+// What answering "who is away between these dates" took before there was an index.
+static void find_employees_off_between_by_scanning(s32 from, s32 to, Array <Employee *> *employees) {
+    for (auto employee : all_employees) {
+        int first = employee->first_vacation;
+        for (int row = first; row < first + employee->num_vacations; row++) {
+            s32 start = vacation_store.start_day[row];
+            s32 end   = vacation_store.end_day[row];
+            if (start < end && Max(start, from) < Min(end, to)) {
+                employees->add(employee);
+                break;
+            }
+        }
+    }
+}
+
+static void benchmark_range_queries() {
+    int sizes[] = { 1000, 10000, 100000 };
+    const int NUM_QUERIES = 1000;
+
+    log("%-12s %8s %14s %14s %10s %12s\n", "vacations", "days", "scan (us)", "index (us)", "speedup", "avg found");
+
+    s32 first_day = date_to_day_number(1, 1, 2020);
+    s32 last_day  = date_to_day_number(1, 1, 2026);
+    int lengths[] = { 1, 7, 30 };
+    
+    Array <s32> query_starts;
+    query_starts.resize(NUM_QUERIES);
+    
+    for (int size : sizes) {
+        generate_random_roster(size);
+
+        for (int length : lengths) {
+            for (auto &start : query_starts) start = random_int(first_day, last_day);
+
+            Array <Employee *> scanned;
+            Array <Employee *> indexed;
+            scanned.reserve(all_employees.count);
+            indexed.reserve(all_employees.count);
+
+            bool results_match = true;
+            s64 total_found = 0;
+            double scan_time  = 0;
+            double index_time = 0;
+            
+            for (auto start : query_starts) {
+                scanned.count = 0;
+                indexed.count = 0;
+                
+                double t0 = os_get_time();
+                find_employees_off_between_by_scanning(start, start + length, &scanned);
+                double t1 = os_get_time();
+                if (length == 1) find_employees_off_on(start, &indexed);
+                else             find_employees_off_between(start, start + length, &indexed);
+                double t2 = os_get_time();
+
+                scan_time  += t1 - t0;
+                index_time += t2 - t1;
+                total_found += indexed.count;
+
+                if (scanned.count != indexed.count) {
+                    results_match = false;
+                } else {
+                    for (int i = 0; i < scanned.count; i++) {
+                        if (scanned[i] != indexed[i]) results_match = false;
+                    }
+                }
+            }
+
+            log("%-12d %8d %14.3f %14.3f %9.1fx %12.1f\n", size, length,
+                scan_time  * 1000000.0 / NUM_QUERIES,
+                index_time * 1000000.0 / NUM_QUERIES,
+                scan_time / index_time,
+                (double)total_found / NUM_QUERIES);
+
+            if (!results_match) {
+                report_failed_check("The index and the scan disagree on who is away for %d vacations!\n", size);
+            }
+        }
+    }
+
+    destroy_all_employees();
+}
+
+// Every day against every vacation of every employee, which is what it took without the calendar.
+static void find_days_with_more_absent_than_by_scanning(int max_absent, s32 from, s32 to, Array <s32> *days) {
+    for (s32 day = from; day < to; day++) {
+        int num_absent = 0;
+        for (auto employee : all_employees) {
+            int first = employee->first_vacation;
+            for (int row = first; row < first + employee->num_vacations; row++) {
+                if (vacation_store.start_day[row] <= day && day < vacation_store.end_day[row]) {
+                    num_absent += 1;
+                    break;
+                }
+            }
+        }
+
+        if (num_absent > max_absent) days->add(day);
+    }
+}
+
+static void save_absent_counts(s32 from, s32 to, Array <int> *counts) {
+    counts->count = 0;
+    counts->reserve(to - from);
+    for (s32 day = from; day < to; day++) {
+        counts->add(get_num_absent_on(day));
+    }
+}
+
+static void benchmark_occupancy() {
+    int sizes[] = { 1000, 10000, 100000 };
+    const int NUM_EDITS = 1000;
+
+    s32 from = date_to_day_number(1, 1, 2020);
+    s32 to   = date_to_day_number(1, 1, 2026);
+
+    log("%-12s %14s %14s %14s %14s %10s\n", "vacations", "build (ms)", "edit (us)", "query (us)", "scan (ms)", "days");
+
+    for (int size : sizes) {
+        generate_random_roster(size);
+        int max_absent = size / 1000; // A bit more than the average day.
+
+        Array <s32> days;
+        Array <s32> scanned_days;
+        days.reserve(to - from);
+        scanned_days.reserve(to - from);
+        
+        double t0 = os_get_time();
+        invalidate_occupancy();
+        get_num_absent_on(from);
+        double t1 = os_get_time();
+
+        // Edits update the calendar in place; this includes keeping the collision index up to date.
+        for (int i = 0; i < NUM_EDITS; i++) {
+            auto employee = random_employee_with_vacations();
+            s32 start = random_int(from, to - 10);
+            employee->edit_vacation_info(random_int(0, employee->num_vacations - 1), start, start + random_int(1, 8));
+        }
+        double t2 = os_get_time();
+
+        const int NUM_QUERIES = 100;
+        for (int i = 0; i < NUM_QUERIES; i++) {
+            days.count = 0;
+            find_days_with_more_absent_than(max_absent, from, to, &days);
+        }
+        double t3 = os_get_time();
+        
+        find_days_with_more_absent_than_by_scanning(max_absent, from, to, &scanned_days);
+        double t4 = os_get_time();
+
+        log("%-12d %14.3f %14.3f %14.3f %14.3f %10d\n", size,
+            (t1 - t0) * 1000.0,
+            (t2 - t1) * 1000000.0 / NUM_EDITS,
+            (t3 - t2) * 1000000.0 / NUM_QUERIES,
+            (t4 - t3) * 1000.0,
+            days.count);
+
+        bool days_match = days.count == scanned_days.count;
+        for (int i = 0; days_match && i < days.count; i++) {
+            if (days[i] != scanned_days[i]) days_match = false;
+        }
+
+        // What the edits left behind has to be what a rebuild comes up with.
+        Array <int> incremental_counts;
+        Array <int> rebuilt_counts;
+        save_absent_counts(from, to, &incremental_counts);
+        invalidate_occupancy();
+        save_absent_counts(from, to, &rebuilt_counts);
+        
+        bool counts_match = incremental_counts.count == rebuilt_counts.count;
+        for (int i = 0; counts_match && i < incremental_counts.count; i++) {
+            if (incremental_counts[i] != rebuilt_counts[i]) counts_match = false;
+        }
+
+        // And who is away has to agree with the vacations themselves.
+        bool bits_match = true;
+        for (int i = 0; i < NUM_QUERIES; i++) {
+            auto employee = all_employees[random_int(0, all_employees.count - 1)];
+            s32 day = random_int(from, to - 1);
+
+            bool expected = false;
+            int first = employee->first_vacation;
+            for (int row = first; row < first + employee->num_vacations; row++) {
+                if (vacation_store.start_day[row] <= day && day < vacation_store.end_day[row]) expected = true;
+            }
+
+            if (is_absent_on(employee, day) != expected) bits_match = false;
+        }
+
+        if (!days_match || !counts_match || !bits_match) {
+            report_failed_check("The occupancy calendar disagrees with the vacations for %d vacations!\n", size);
+        }
+    }
+
+    // Typos in the year mustn't make the calendar span centuries; the days out there are
+    // answered from the index instead.
+    {
+        s32 typo_from = date_to_day_number(1, 1, 2205);
+        s32 typo_to   = date_to_day_number(1, 1, 2206);
+        for (int i = 0; i < 50; i++) {
+            auto employee = all_employees[random_int(0, all_employees.count - 1)];
+            s32 start = random_int(typo_from, typo_to - 10);
+            employee->add_vacation_info(start, start + random_int(1, 8));
+        }
+        all_employees[0]->add_vacation_info(date_to_day_number(1, 6, 9999), date_to_day_number(10, 6, 9999));
+
+        invalidate_occupancy();
+        double t0 = os_get_time();
+        get_num_absent_on(from);
+        double t1 = os_get_time();
+
+        Array <s32> days;
+        Array <s32> scanned_days;
+        find_days_with_more_absent_than(0, typo_from, typo_to, &days);
+        find_days_with_more_absent_than_by_scanning(0, typo_from, typo_to, &scanned_days);
+
+        bool days_match = days.count == scanned_days.count;
+        for (int i = 0; days_match && i < days.count; i++) {
+            if (days[i] != scanned_days[i]) days_match = false;
+        }
+
+        s32 far_day = date_to_day_number(5, 6, 9999);
+        bool far_day_matches = get_num_absent_on(far_day) == 1 && is_absent_on(all_employees[0], far_day);
+
+        log("With typo years: build %.3f ms, calendar %.1f MB, %d days in 2205\n",
+            (t1 - t0) * 1000.0, get_occupancy_bytes() / (1024.0 * 1024.0), days.count);
+
+        if (!days_match || !far_day_matches || get_occupancy_bytes() > (s64)Megabytes(256)) {
+            report_failed_check("The occupancy calendar is wrong or too big with vacations far in the future!\n");
+        }
+    }
+
+    destroy_all_employees();
+}
+
+static void benchmark_teams() {
+    const int NUM_VACATIONS = 30000;
+    int team_counts[] = { 1, 10, 100 };
+
+    log("%-8s %14s %14s %14s %12s\n", "teams", "nested (ms)", "sweep (ms)", "rebuild (ms)", "pairs");
+
+    for (int num_teams : team_counts) {
+        generate_random_roster(NUM_VACATIONS);
+
+        for (auto employee : all_employees) {
+            char team[32];
+            snprintf(team, sizeof(team), "Team %d", random_int(1, num_teams));
+            set_employee_team(employee, team);
+        }
+
+        clear_collision_flags();
+        double t0 = os_get_time();
+        are_vacations_colliding_brute_force();
+        double t1 = os_get_time();
+
+        Array <bool> brute_force_flags;
+        save_collision_flags(&brute_force_flags);
+
+        clear_collision_flags();
+        double t2 = os_get_time();
+        sweep_for_colliding_vacations();
+        double t3 = os_get_time();
+
+        Array <bool> sweep_flags;
+        save_collision_flags(&sweep_flags);
+
+        double t4 = os_get_time();
+        update_collding_for_all_infos();
+        double t5 = os_get_time();
+
+        Array <bool> index_flags;
+        save_collision_flags(&index_flags);
+
+        Array <Vacation_Collision> collisions;
+        find_colliding_vacations(&collisions);
+
+        bool pairs_in_same_team = true;
+        for (auto collision : collisions) {
+            if (vacation_store.team_id[collision.a] != vacation_store.team_id[collision.b]) pairs_in_same_team = false;
+        }
+        
+        log("%-8d %14.3f %14.3f %14.3f %12d\n", num_teams,
+            (t1 - t0) * 1000.0, (t3 - t2) * 1000.0, (t5 - t4) * 1000.0, collisions.count);
+
+        if (!collision_flags_match(&brute_force_flags, &sweep_flags) || !collision_flags_match(&brute_force_flags, &index_flags) || !pairs_in_same_team) {
+            report_failed_check("The collision checks disagree with %d teams!\n", num_teams);
+        }
+    }
+
+    destroy_all_employees();
+}
+
+static void benchmark_parallel_collisions() {
+    const int NUM_VACATIONS = 200000;
+    int team_counts[] = { 1, 100 };
+    int thread_counts[] = { 1, 2, 4, 8 };
+
+    log("%d vacations, %d processors\n", NUM_VACATIONS, os_get_number_of_processors());
+    log("%-8s %8s %14s %10s %14s %10s\n", "teams", "threads", "sweep (ms)", "speedup", "rebuild (ms)", "speedup");
+
+    for (int num_teams : team_counts) {
+        generate_random_roster(NUM_VACATIONS);
+        if (num_teams > 1) {
+            for (auto employee : all_employees) {
+                char team[32];
+                snprintf(team, sizeof(team), "Team %d", random_int(1, num_teams));
+                set_employee_team(employee, team);
+            }
+        }
+
+        Array <bool> single_threaded_sweep_flags;
+        Array <bool> single_threaded_index_flags;
+        double single_threaded_sweep   = 0;
+        double single_threaded_rebuild = 0;
+
+        for (int num_threads : thread_counts) {
+            init_job_system(num_threads);
+
+            const int NUM_RUNS = 5;
+            
+            double sweep_time = 0;
+            for (int run = 0; run < NUM_RUNS; run++) {
+                clear_collision_flags();
+                double t0 = os_get_time();
+                sweep_for_colliding_vacations();
+                sweep_time += os_get_time() - t0;
+            }
+            sweep_time /= NUM_RUNS;
+
+            Array <bool> sweep_flags;
+            save_collision_flags(&sweep_flags);
+
+            double rebuild_time = 0;
+            for (int run = 0; run < NUM_RUNS; run++) {
+                double t0 = os_get_time();
+                update_collding_for_all_infos();
+                rebuild_time += os_get_time() - t0;
+            }
+            rebuild_time /= NUM_RUNS;
+
+            Array <bool> index_flags;
+            save_collision_flags(&index_flags);
+
+            if (num_threads == 1) {
+                save_collision_flags(&single_threaded_index_flags);
+                
+                clear_collision_flags();
+                sweep_for_colliding_vacations();
+                save_collision_flags(&single_threaded_sweep_flags);
+                
+                single_threaded_sweep   = sweep_time;
+                single_threaded_rebuild = rebuild_time;
+            }
+
+            log("%-8d %8d %14.3f %9.2fx %14.3f %9.2fx\n", num_teams, num_threads,
+                sweep_time * 1000.0, single_threaded_sweep / sweep_time,
+                rebuild_time * 1000.0, single_threaded_rebuild / rebuild_time);
+
+            if (!collision_flags_match(&sweep_flags, &single_threaded_sweep_flags) ||
+                !collision_flags_match(&index_flags, &single_threaded_index_flags) ||
+                !collision_flags_match(&sweep_flags, &index_flags)) {
+                report_failed_check("Collision flags with %d threads differ from the single threaded ones!\n", num_threads);
+            }
+        }
+    }
+
+    init_job_system(os_get_number_of_processors());
+    destroy_all_employees();
+}
+
+static bool buffers_match(Array <u8> *a, Array <u8> *b) {
+    if (a->count != b->count) return false;
+    return memcmp(a->data, b->data, a->count) == 0;
+}
+
+static void benchmark_save_load() {
+    const int NUM_VACATIONS = 100000; // 10000 employees.
+    const int NUM_RUNS = 5;
+
+    char *text_path   = "benchmark_save.txt";
+    char *binary_path = "benchmark_save.bin";
+    defer { remove(text_path); remove(binary_path); };
+
+    generate_random_roster(NUM_VACATIONS);
+    for (auto employee : all_employees) {
+        char team[32];
+        snprintf(team, sizeof(team), "Team %d", random_int(1, 20));
+        set_employee_team(employee, team);
+        employee->draw_all_vacations_on_hud = random_int(0, 3) != 0;
+    }
+
+    Save_Settings settings;
+    settings.window_width  = 1600;
+    settings.window_height = 900;
+
+    // Both formats have to give back exactly what was saved.
+    Array <u8> original;
+    serialize_snapshot(&original, &settings);
+
+    double text_save_time = 0;
+    double text_load_time = 0;
+    double binary_save_time = 0;
+    double binary_load_time = 0;
+    double binary_read_time = 0;
+
+    // Every load ends with a collision rebuild of what it brought in. Batching the changes
+    // puts it off until end_batched_changes, so it can be timed on its own.
+    double text_rebuild_time = 0;
+    double binary_rebuild_time = 0;
+    double binary_read_rebuild_time = 0;
+
+    bool text_matches = true;
+    bool binary_matches = true;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+        double t0 = os_get_time();
+        export_text(text_path, &settings);
+        double t1 = os_get_time();
+        save_snapshot(binary_path, &settings);
+        double t2 = os_get_time();
+
+        destroy_all_employees();
+        Save_Settings text_settings;
+        begin_batched_changes();
+        double t3 = os_get_time();
+        import_text(text_path, &text_settings);
+        double t4 = os_get_time();
+        end_batched_changes();
+        text_rebuild_time += os_get_time() - t4;
+
+        Array <u8> loaded;
+        serialize_snapshot(&loaded, &text_settings);
+        if (!buffers_match(&original, &loaded)) text_matches = false;
+
+        destroy_all_employees();
+        Save_Settings binary_settings;
+        begin_batched_changes();
+        double t5 = os_get_time();
+        load_snapshot(binary_path, &binary_settings);
+        double t6 = os_get_time();
+        end_batched_changes();
+        binary_rebuild_time += os_get_time() - t6;
+
+        serialize_snapshot(&loaded, &binary_settings);
+        if (!buffers_match(&original, &loaded)) binary_matches = false;
+
+        // Reading the whole file and copying the names, instead of mapping it.
+        destroy_all_employees();
+        begin_batched_changes();
+        double t9 = os_get_time();
+        {
+            s64 length = 0;
+            u8 *data = (u8 *)os_read_entire_file(binary_path, &length);
+            load_snapshot_from_memory(data, length, &binary_settings, binary_path);
+            delete [] data;
+        }
+        double t10 = os_get_time();
+        end_batched_changes();
+        binary_read_rebuild_time += os_get_time() - t10;
+
+        serialize_snapshot(&loaded, &binary_settings);
+        if (!buffers_match(&original, &loaded)) binary_matches = false;
+
+        text_save_time   += t1 - t0;
+        binary_save_time += t2 - t1;
+        text_load_time   += t4 - t3;
+        binary_load_time += t6 - t5;
+        binary_read_time += t10 - t9;
+    }
+
+    text_save_time   /= NUM_RUNS;
+    text_load_time   /= NUM_RUNS;
+    binary_save_time /= NUM_RUNS;
+    binary_load_time /= NUM_RUNS;
+    binary_read_time /= NUM_RUNS;
+    text_rebuild_time        /= NUM_RUNS;
+    binary_rebuild_time      /= NUM_RUNS;
+    binary_read_rebuild_time /= NUM_RUNS;
+
+    s64 text_size = 0, binary_size = 0;
+    delete [] os_read_entire_file(text_path, &text_size);
+    delete [] os_read_entire_file(binary_path, &binary_size);
+
+    // The mapped snapshot only loads the last few years, so its rebuild is the smallest.
+    log("%d employees, %d vacations\n", all_employees.count, vacation_store.count);
+    log("%-14s %12s %12s %12s %18s\n", "format", "size (KB)", "save (ms)", "load (ms)", "load - rebuild (ms)");
+    log("%-14s %12lld %12.3f %12.3f %18.3f\n", "text",          (long long)text_size / 1024,   text_save_time * 1000.0,   (text_load_time + text_rebuild_time) * 1000.0,          text_load_time * 1000.0);
+    log("%-14s %12lld %12.3f %12.3f %18.3f\n", "binary",        (long long)binary_size / 1024, binary_save_time * 1000.0, (binary_load_time + binary_rebuild_time) * 1000.0,      binary_load_time * 1000.0);
+    log("%-14s %12s %12s %12.3f %18.3f\n",     "binary, read",  "", "", (binary_read_time + binary_read_rebuild_time) * 1000.0, binary_read_time * 1000.0);
+
+    if (!text_matches)   report_failed_check("Loading the text save didn't give back what was saved!\n");
+    if (!binary_matches) report_failed_check("Loading the snapshot didn't give back what was saved!\n");
+
+    // Renaming a mapped name and then saving over the mapped file must not lose any names.
+    {
+        destroy_all_employees();
+        Save_Settings mapped_settings;
+        load_snapshot(binary_path, &mapped_settings);
+        set_employee_name(all_employees[0], copy_string(all_employees[0]->name));
+        save_snapshot(binary_path, &mapped_settings);
+
+        Array <u8> loaded;
+        serialize_snapshot(&loaded, &mapped_settings);
+        if (!buffers_match(&original, &loaded)) report_failed_check("Saving over the mapped snapshot lost names!\n");
+    }
+
+    // Team names longer than any buffer come back whole, or two of them would end up one team.
+    {
+        destroy_all_employees();
+
+        const int LONG_LENGTH = 999;
+        char long_team[LONG_LENGTH + 2];
+        memset(long_team, 'x', LONG_LENGTH);
+        long_team[LONG_LENGTH + 1] = 0;
+
+        long_team[LONG_LENGTH] = 'a';
+        set_employee_team(add_employee("First"), long_team);
+        long_team[LONG_LENGTH] = 'b';
+        set_employee_team(add_employee("Second"), long_team);
+
+        Save_Settings long_settings;
+        export_text(text_path, &long_settings);
+        destroy_all_employees();
+        import_text(text_path, &long_settings);
+
+        bool ok = all_employees.count == 2 && all_employees[0]->team_id != all_employees[1]->team_id;
+        ok = ok && strings_match(get_team_name(all_employees[1]->team_id), long_team);
+        if (!ok) report_failed_check("Loading the text save cut a long team name short!\n");
+    }
+
+    // A flipped byte has to be caught by the checksums; what it damaged is left out.
+    {
+        s64 length = 0;
+        u8 *data = (u8 *)os_read_entire_file(binary_path, &length);
+        defer { delete [] data; };
+        data[length / 2] ^= 0x10;
+
+        destroy_all_employees();
+        Save_Settings damaged_settings;
+        bool loaded = load_snapshot_from_memory(data, length, &damaged_settings, binary_path);
+        if (loaded && !damaged_settings.snapshot_was_repaired) {
+            report_failed_check("A damaged snapshot was loaded as if nothing was wrong with it!\n");
+        }
+    }
+
+    destroy_all_employees();
+}
+
+static void make_random_change() {
+    auto employee = all_employees[random_int(0, all_employees.count - 1)];
+
+    int kind = random_int(0, 99);
+    if (kind < 40 || !employee->num_vacations) {
+        s32 from = date_to_day_number(random_int(1, 28), random_int(1, 12), random_int(2020, 2025));
+        employee->add_vacation_info(from, from + random_int(1, 8));
+    } else if (kind < 65) {
+        s32 from = date_to_day_number(random_int(1, 28), random_int(1, 12), random_int(2020, 2025));
+        employee->edit_vacation_info(random_int(0, employee->num_vacations - 1), from, from + random_int(1, 8));
+    } else if (kind < 80) {
+        employee->remove_vacation_info(random_int(0, employee->num_vacations - 1));
+    } else if (kind < 85) {
+        char name[64];
+        snprintf(name, sizeof(name), "Renamed %d", random_int(0, 1000000));
+        set_employee_name(employee, copy_string(name));
+    } else if (kind < 90) {
+        char team[32];
+        snprintf(team, sizeof(team), "Team %d", random_int(1, 20));
+        set_employee_team(employee, team);
+    } else if (kind < 95) {
+        set_employee_shown_on_hud(employee, !employee->draw_all_vacations_on_hud);
+    } else if (kind < 98) {
+        char name[64];
+        snprintf(name, sizeof(name), "New employee %d", random_int(0, 1000000));
+        add_employee(name);
+    } else {
+        remove_employee(employee);
+        if (!employee->name_is_borrowed) delete [] employee->name;
+        delete employee;
+    }
+}
+
+static void benchmark_journal() {
+    const int NUM_VACATIONS = 100000;
+    const int NUM_CHANGES = 2000;
+
+    char *snapshot_path = "benchmark_journal.bin";
+    char *journal_path  = "benchmark_journal.journal";
+    defer { close_journal(); remove(snapshot_path); remove(journal_path); };
+
+    generate_random_roster(NUM_VACATIONS);
+
+    // The same kind of changes with and without a journal, to see what writing it adds.
+    double t0 = os_get_time();
+    for (int i = 0; i < NUM_CHANGES; i++) make_random_change();
+    double t1 = os_get_time();
+
+    Save_Settings settings;
+    settings.window_width  = 1600;
+    settings.window_height = 900;
+
+    double t2 = os_get_time();
+    save_snapshot(snapshot_path, &settings);
+    double t3 = os_get_time();
+
+    remove(journal_path);
+    open_journal(journal_path, &settings);
+
+    double t4 = os_get_time();
+    for (int i = 0; i < NUM_CHANGES; i++) make_random_change();
+    double t5 = os_get_time();
+
+    journal_window_size(1280, 720);
+    close_journal();
+
+    Save_Settings expected_settings = settings;
+    expected_settings.window_width  = 1280;
+    expected_settings.window_height = 720;
+
+    Array <u8> expected;
+    serialize_snapshot(&expected, &expected_settings);
+
+    destroy_all_employees();
+    Save_Settings loaded_settings;
+    double t6 = os_get_time();
+    load_snapshot(snapshot_path, &loaded_settings);
+    double t7 = os_get_time();
+
+    // Load it back the way main() does.
+    destroy_all_employees();
+    loaded_settings = {};
+    double t8 = os_get_time();
+    begin_batched_changes();
+    load_snapshot(snapshot_path, &loaded_settings);
+    open_journal(journal_path, &loaded_settings);
+    end_batched_changes();
+    double t9 = os_get_time();
+    close_journal();
+
+    Array <u8> loaded;
+    serialize_snapshot(&loaded, &loaded_settings);
+
+    s64 journal_bytes = 0;
+    u8 *journal_data = (u8 *)os_read_entire_file(journal_path, &journal_bytes);
+    defer { delete [] journal_data; };
+
+    log("%d employees, %d vacations, %d changes\n", all_employees.count, vacation_store.count, NUM_CHANGES);
+    log("change without journal %10.3f us\n", (t1 - t0) * 1000000.0 / NUM_CHANGES);
+    log("change with journal    %10.3f us\n", (t5 - t4) * 1000000.0 / NUM_CHANGES);
+    log("journal size           %10.3f KB (%.1f bytes per change)\n", journal_bytes / 1024.0, (double)journal_bytes / NUM_CHANGES);
+    log("writing a snapshot     %10.3f ms\n", (t3 - t2) * 1000.0);
+    log("loading the snapshot   %10.3f ms\n", (t7 - t6) * 1000.0);
+    log("... and the journal    %10.3f ms\n", (t9 - t8) * 1000.0);
+
+    if (!buffers_match(&expected, &loaded)) report_failed_check("Replaying the journal didn't give back the changes!\n");
+
+    // A record cut off by a crash gets dropped, and only that one.
+    {
+        FILE *file = fopen(journal_path, "wb");
+        fwrite(journal_data, 1, journal_bytes - 3, file);
+        fclose(file);
+
+        destroy_all_employees();
+        Save_Settings cut_settings;
+        load_snapshot(snapshot_path, &cut_settings);
+        open_journal(journal_path, &cut_settings);
+        close_journal();
+
+        // The window size was the last record.
+        Array <u8> cut;
+        cut_settings.window_width  = 1280;
+        cut_settings.window_height = 720;
+        serialize_snapshot(&cut, &cut_settings);
+
+        s64 cut_bytes = 0;
+        delete [] os_read_entire_file(journal_path, &cut_bytes);
+
+        const int WINDOW_SIZE_RECORD_BYTES = 8 + 1 + 8;
+        if (!buffers_match(&expected, &cut) || cut_bytes != journal_bytes - WINDOW_SIZE_RECORD_BYTES) {
+            report_failed_check("A journal with a cut off record didn't replay up to that record!\n");
+        }
+    }
+
+    destroy_all_employees();
+}
+
+static void benchmark_background_save() {
+    const int NUM_VACATIONS = 100000;
+    const int NUM_RUNS = 5;
+
+    char *snapshot_path = "benchmark_background.bin";
+    char *journal_path  = "benchmark_background.journal";
+    defer { shutdown_background_saves(); close_journal(); remove(snapshot_path); remove(journal_path); };
+
+    generate_random_roster(NUM_VACATIONS);
+
+    Save_Settings settings;
+    settings.window_width  = 1600;
+    settings.window_height = 900;
+
+    double save_time = 0;
+    double blocking_time = 0;
+    double background_time = 0;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+        double t0 = os_get_time();
+        save_snapshot(snapshot_path, &settings);
+        double t1 = os_get_time();
+
+        start_background_save(snapshot_path, &settings);
+        double t2 = os_get_time();
+        finish_background_save();
+        double t3 = os_get_time();
+
+        save_time       += t1 - t0;
+        blocking_time   += t2 - t1;
+        background_time += t3 - t1;
+    }
+
+    // Changes keep coming in while the snapshot is being written, and have to end up in
+    // the restarted journal; the ones from before are in the snapshot.
+    save_snapshot(snapshot_path, &settings);
+    remove(journal_path);
+    open_journal(journal_path, &settings);
+
+    for (int i = 0; i < 1000; i++) make_random_change();
+
+    Save_Settings autosave_settings = settings;
+    note_journal_position(&autosave_settings);
+    start_background_save(snapshot_path, &autosave_settings);
+
+    for (int i = 0; i < 100; i++) make_random_change();
+
+    auto state = finish_background_save();
+    double t4 = os_get_time();
+    restart_journal(journal_path, &autosave_settings);
+    double t5 = os_get_time();
+
+    for (int i = 0; i < 100; i++) make_random_change();
+    close_journal();
+
+    Array <u8> expected;
+    serialize_snapshot(&expected, &autosave_settings);
+
+    destroy_all_employees();
+    Save_Settings loaded_settings;
+    begin_batched_changes();
+    load_snapshot(snapshot_path, &loaded_settings);
+    open_journal(journal_path, &loaded_settings);
+    end_batched_changes();
+    close_journal();
+
+    Array <u8> loaded;
+    serialize_snapshot(&loaded, &autosave_settings);
+
+    log("%d employees, %d vacations\n", all_employees.count, vacation_store.count);
+    log("save on the main thread    %10.3f ms\n", save_time / NUM_RUNS * 1000.0);
+    log("main thread blocked for    %10.3f ms\n", blocking_time / NUM_RUNS * 1000.0);
+    log("background save took       %10.3f ms\n", background_time / NUM_RUNS * 1000.0);
+    log("restarting the journal     %10.3f ms\n", (t5 - t4) * 1000.0);
+
+    if (state != BACKGROUND_SAVE_SUCCEEDED) report_failed_check("The background save failed!\n");
+    if (!buffers_match(&expected, &loaded)) report_failed_check("Changes made during the background save were lost!\n");
+
+    destroy_all_employees();
+}
+
+// What Text_File_Handler did before it streamed: read the whole file, then cut it up
+// in place with a strlen or two per line.
+static void parse_lines_in_place(char *path, int *num_lines, u64 *hash) {
+    char *orig_file_data = os_read_entire_file(path);
+    defer { delete [] orig_file_data; };
+
+    char *file_data = orig_file_data;
+    while (true) {
+        char *line = consume_next_line(&file_data);
+        if (!line) break;
+
+        line = eat_spaces(line);
+        if (line[0] == 0) continue;
+
+        char *rhs = strchr(line, '#');
+        if (rhs) {
+            line[strlen(line) - strlen(rhs)] = 0;
+            if (strlen(line) == 0) continue;
+        }
+
+        line = eat_trailing_spaces(line);
+
+        *num_lines += 1;
+        *hash = (*hash ^ compute_checksum((u8 *)line, strlen(line))) * 1099511628211ULL;
+    }
+}
+
+static void parse_lines_streaming(char *path, char *data, s64 size, int *num_lines, u64 *hash) {
+    Text_File_Handler handler;
+    handler.do_version_number = false;
+    if (data) handler.start_memory(path, data, size, "benchmark");
+    else      handler.start_file(path, path, "benchmark");
+
+    while (true) {
+        String line = handler.consume_next_line();
+        if (!line.data) break;
+
+        *num_lines += 1;
+        *hash = (*hash ^ compute_checksum((u8 *)line.data, line.count)) * 1099511628211ULL;
+    }
+}
+
+static void benchmark_text_parse() {
+    const int NUM_VACATIONS = 500000;
+    const int NUM_RUNS = 5;
+
+    char *path = "benchmark_text_parse.txt";
+    defer { remove(path); };
+
+    generate_random_roster(NUM_VACATIONS);
+    Save_Settings settings;
+    export_text(path, &settings);
+    destroy_all_employees();
+
+    s64 size = 0;
+    char *data = os_read_entire_file(path, &size);
+    defer { delete [] data; };
+
+    double in_place_time = 0;
+    double streaming_time = 0;
+    double memory_time = 0;
+
+    int in_place_lines = 0, streaming_lines = 0, memory_lines = 0;
+    u64 in_place_hash = 0, streaming_hash = 0, memory_hash = 0;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+        in_place_lines = streaming_lines = memory_lines = 0;
+        in_place_hash = streaming_hash = memory_hash = 0;
+
+        double t0 = os_get_time();
+        parse_lines_in_place(path, &in_place_lines, &in_place_hash);
+        double t1 = os_get_time();
+        parse_lines_streaming(path, NULL, 0, &streaming_lines, &streaming_hash);
+        double t2 = os_get_time();
+        parse_lines_streaming(path, data, size, &memory_lines, &memory_hash);
+        double t3 = os_get_time();
+
+        in_place_time  += t1 - t0;
+        streaming_time += t2 - t1;
+        memory_time    += t3 - t2;
+    }
+
+    double megabytes = (double)size / (1024.0 * 1024.0) * NUM_RUNS;
+
+    log("%.1f MB, %d lines\n", (double)size / (1024.0 * 1024.0), in_place_lines);
+    log("%-22s %10s %10s\n", "", "ms", "MB/s");
+    log("%-22s %10.3f %10.1f\n", "read whole, in place", in_place_time  / NUM_RUNS * 1000.0, megabytes / in_place_time);
+    log("%-22s %10.3f %10.1f\n", "streaming",            streaming_time / NUM_RUNS * 1000.0, megabytes / streaming_time);
+    log("%-22s %10.3f %10.1f\n", "streaming, memory",    memory_time    / NUM_RUNS * 1000.0, megabytes / memory_time);
+
+    if (streaming_lines != in_place_lines || streaming_hash != in_place_hash) report_failed_check("Streaming gave different lines than reading it whole!\n");
+    if (memory_lines    != in_place_lines || memory_hash    != in_place_hash) report_failed_check("Reading from memory gave different lines than reading it whole!\n");
+
+    // Lines and comments that go over the end of a chunk.
+    {
+        const int NUM_LINES = 10000;
+
+        char *chunks_path = "benchmark_text_parse_chunks.txt";
+        defer { remove(chunks_path); };
+
+        FILE *file = fopen(chunks_path, "wb");
+        for (int i = 0; i < NUM_LINES; i++) {
+            int length = random_int(0, 200);
+            for (int j = 0; j < length; j++) fputc('a' + random_int(0, 25), file);
+            fprintf(file, " %d", i);
+            if (random_int(0, 1)) {
+                fputs(" # ", file);
+                int comment_length = random_int(0, 5000);
+                for (int j = 0; j < comment_length; j++) fputc('x', file);
+            }
+            fputs(random_int(0, 1) ? "\r\n" : "\n", file);
+        }
+        fclose(file);
+
+        in_place_lines = streaming_lines = 0;
+        in_place_hash = streaming_hash = 0;
+        parse_lines_in_place(chunks_path, &in_place_lines, &in_place_hash);
+        parse_lines_streaming(chunks_path, NULL, 0, &streaming_lines, &streaming_hash);
+
+        if (streaming_lines != NUM_LINES || streaming_lines != in_place_lines || streaming_hash != in_place_hash) {
+            report_failed_check("Lines going over the end of a chunk didn't come out right!\n");
+        }
+    }
+}
+
+static void benchmark_field_parse() {
+    const int NUM_LINES = 1000000;
+
+    char *path = "benchmark_field_parse.txt";
+    defer { remove(path); };
+
+    FILE *file = fopen(path, "wb");
+    for (int i = 0; i < NUM_LINES; i++) {
+        s32 from = random_int(date_to_day_number(1, 1, 2000), date_to_day_number(31, 12, 2030));
+        Date a = day_number_to_date(from);
+        Date b = day_number_to_date(from + random_int(0, 30));
+        fprintf(file, "%d.%d.%d %d.%d.%d # StartDate EndDate\n", a.day, a.month, a.year, b.day, b.month, b.year);
+        fprintf(file, "%d # A count\n", (int)random_u32() - 0x7fffffff);
+    }
+    fclose(file);
+
+    s64 size = 0;
+    char *data = os_read_entire_file(path, &size);
+    defer { delete [] data; };
+
+    // Take the splitting into lines out of it.
+    Array <String> date_lines;
+    Array <String> int_lines;
+    date_lines.reserve(NUM_LINES);
+    int_lines.reserve(NUM_LINES);
+    {
+        Text_File_Handler handler;
+        handler.do_version_number = false;
+        handler.start_memory(path, data, size, "benchmark");
+        while (true) {
+            String line = handler.consume_next_line();
+            if (!line.data) break;
+            if (date_lines.count == int_lines.count) date_lines.add(line);
+            else                                     int_lines.add(line);
+        }
+    }
+
+    Text_File_Handler handler;
+    handler.do_version_number = false;
+    handler.start_memory(path, data, size, "benchmark");
+
+    s64 sscanf_sum = 0, parsed_sum = 0;
+    s64 atoi_sum = 0, parse_int_sum = 0;
+    bool all_parsed = true;
+
+    double t0 = os_get_time();
+    for (auto line : date_lines) {
+        char buffer[128];
+        Date from = {}, to = {};
+        sscanf(to_c_string(line, buffer, sizeof(buffer)), "%d.%d.%d %d.%d.%d", &from.day, &from.month, &from.year, &to.day, &to.month, &to.year);
+        sscanf_sum += from.day + from.month * 31 + from.year * 372 + to.day + to.month * 31 + to.year * 372;
+    }
+    double t1 = os_get_time();
+    for (auto line : date_lines) {
+        Date from, to;
+        if (!handler.parse_date_range(line, &from, &to)) { all_parsed = false; continue; }
+        parsed_sum += from.day + from.month * 31 + from.year * 372 + to.day + to.month * 31 + to.year * 372;
+    }
+    double t2 = os_get_time();
+    for (auto line : int_lines) {
+        char buffer[128];
+        atoi_sum += atoi(to_c_string(line, buffer, sizeof(buffer)));
+    }
+    double t3 = os_get_time();
+    for (auto line : int_lines) {
+        int value;
+        if (!handler.parse_int(line, &value)) { all_parsed = false; continue; }
+        parse_int_sum += value;
+    }
+    double t4 = os_get_time();
+
+    log("%d date lines and %d number lines\n", date_lines.count, int_lines.count);
+    log("%-24s %10s %14s\n", "", "ms", "lines/s");
+    log("%-24s %10.3f %14.0f\n", "dates, sscanf",   (t1 - t0) * 1000.0, date_lines.count / (t1 - t0));
+    log("%-24s %10.3f %14.0f\n", "dates, parse_date_range", (t2 - t1) * 1000.0, date_lines.count / (t2 - t1));
+    log("%-24s %10.3f %14.0f\n", "numbers, atoi",   (t3 - t2) * 1000.0, int_lines.count / (t3 - t2));
+    log("%-24s %10.3f %14.0f\n", "numbers, parse_int", (t4 - t3) * 1000.0, int_lines.count / (t4 - t3));
+    log("dates %.1fx, numbers %.1fx\n", (t1 - t0) / (t2 - t1), (t3 - t2) / (t4 - t3));
+
+    if (!all_parsed || sscanf_sum != parsed_sum || atoi_sum != parse_int_sum) report_failed_check("The parsers don't agree with sscanf and atoi!\n");
+
+    // What sscanf and atoi would let through has to be turned down.
+    char *bad_dates[] = { "", "1.2", "1.2.", "1..2024", "x.2.2024", "32.1.2024", "29.2.2023", "0.1.2024", "1.13.2024", "1.0.2024", "1.1.0", "1.1.10000", "-1.1.2024", "1. 1.2024", "123.1.2024" };
+    for (auto text : bad_dates) {
+        String s = make_string(text);
+        Date date;
+        if (parse_date(&s, &date)) report_failed_check("'%s' was taken as a date!\n", text);
+    }
+
+    char *good_dates[] = { "29.2.2024", "29.2.2000", "31.12.9999", "01.01.2024", "1.1.1" };
+    for (auto text : good_dates) {
+        String s = make_string(text);
+        Date date;
+        if (!parse_date(&s, &date) || s.count) report_failed_check("'%s' wasn't taken as a date!\n", text);
+    }
+
+    char *bad_ints[] = { "", "-", "+", "2147483648", "-2147483649", "99999999999", "x1" };
+    for (auto text : bad_ints) {
+        String s = make_string(text);
+        int value;
+        if (parse_int(&s, &value)) report_failed_check("'%s' was taken as a number!\n", text);
+    }
+
+    String s = make_string("-2147483648");
+    int value = 0;
+    if (!parse_int(&s, &value) || value != (-2147483647 - 1)) report_failed_check("The smallest int wasn't read right!\n");
+}
+
+struct Import_Test_Row {
+    char name[64];
+    int team; // -1 for none.
+    s32 start, end;
+};
+
+// Returns how many bad lines went in.
+static int write_import_csv(char *path, Array <Import_Test_Row> *rows, int max_bad_lines) {
+    int num_bad_lines = 0;
+    FILE *file = fopen(path, "wb");
+    fputs("\xEF\xBB\xBFName;From;To;Team\r\n", file);
+
+    for (auto &row : *rows) {
+        Date a = day_number_to_date(row.start);
+        Date b = day_number_to_date(row.end);
+
+        if (strchr(row.name, ',')) fprintf(file, "\"%s\";", row.name);
+        else                       fprintf(file, "%s;", row.name);
+
+        if (random_int(0, 1)) fprintf(file, "%d.%d.%d;%04d-%02d-%02d", a.day, a.month, a.year, b.year, b.month, b.day);
+        else                  fprintf(file, "%04d-%02d-%02d;%d.%d.%d", a.year, a.month, a.day, b.day, b.month, b.year);
+
+        if (row.team >= 0) fprintf(file, ";Team %d\r\n", row.team);
+        else               fprintf(file, "\r\n");
+
+        if (num_bad_lines < max_bad_lines && random_int(0, 1000) == 0) {
+            fprintf(file, "%s;31.2.2024;1.3.2024\r\n", row.name);
+            num_bad_lines += 1;
+        }
+    }
+    fclose(file);
+
+    return num_bad_lines;
+}
+
+static void write_import_ics(char *path, Array <Import_Test_Row> *rows) {
+    FILE *file = fopen(path, "wb");
+    fputs("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//HR//Absences//EN\r\n", file);
+
+    for (auto &row : *rows) {
+        Date a = day_number_to_date(row.start);
+        Date b = day_number_to_date(row.end);
+
+        fputs("BEGIN:VEVENT\r\n", file);
+        fprintf(file, "UID:%p@hr\r\n", &row);
+
+        // Long names get folded, like calendar programs do.
+        char summary[128];
+        int length = 0;
+        for (char *at = row.name; *at; at++) {
+            if (*at == ',') summary[length++] = '\\';
+            summary[length++] = *at;
+        }
+        summary[length] = 0;
+        if (length > 10) fprintf(file, "SUMMARY:%.10s\r\n %s\r\n", summary, summary + 10);
+        else             fprintf(file, "SUMMARY:%s\r\n", summary);
+
+        fprintf(file, "DTSTART;VALUE=DATE:%04d%02d%02d\r\n", a.year, a.month, a.day);
+        fprintf(file, "DTEND;VALUE=DATE:%04d%02d%02d\r\n", b.year, b.month, b.day);
+        if (row.team >= 0) fprintf(file, "CATEGORIES:Team %d,Vacation\r\n", row.team);
+        fputs("END:VEVENT\r\n", file);
+    }
+
+    fputs("END:VCALENDAR\r\n", file);
+    fclose(file);
+}
+
+// What bulk_import has to end up with, one vacation at a time.
+static void import_one_by_one(Array <Import_Test_Row> *rows) {
+    begin_batched_changes();
+    for (auto &row : *rows) {
+        Employee *employee = NULL;
+        for (auto e : all_employees) {
+            if (strings_match(e->name, row.name)) { employee = e; break; }
+        }
+        if (!employee) employee = add_employee(row.name);
+
+        if (row.team >= 0) {
+            char team[32];
+            snprintf(team, sizeof(team), "Team %d", row.team);
+            if (!strings_match(get_team_name(employee->team_id), team)) set_employee_team(employee, team);
+        }
+
+        bool is_there = false;
+        for (int i = 0; i < employee->num_vacations; i++) {
+            int r = employee->first_vacation + i;
+            if (vacation_store.start_day[r] == row.start && vacation_store.end_day[r] == row.end) is_there = true;
+        }
+        if (!is_there) employee->add_vacation_info(row.start, row.end);
+    }
+    end_batched_changes();
+}
+
+static void benchmark_bulk_import() {
+    const int NUM_EXISTING = 20000;
+    const int NUM_ROWS = 50000;
+    const int NUM_BAD_LINES = 10;
+
+    char *csv_path = "benchmark_bulk_import.csv";
+    char *ics_path = "benchmark_bulk_import.ics";
+    defer { remove(csv_path); remove(ics_path); };
+
+    // Mostly people who are there already, some new ones, and some vacations twice.
+    generate_random_roster(NUM_EXISTING);
+    int num_existing_employees = all_employees.count;
+
+    Array <Import_Test_Row> rows;
+    rows.reserve(NUM_ROWS);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        auto row = rows.add();
+        int kind = random_int(0, 9);
+        if (kind == 0) {
+            snprintf(row->name, sizeof(row->name), "New, Employee %d", random_int(0, num_existing_employees / 10));
+        } else {
+            snprintf(row->name, sizeof(row->name), "Employee %d", random_int(0, num_existing_employees - 1));
+        }
+        row->team = random_int(0, 3) ? -1 : random_int(0, 4);
+
+        if (kind == 1 && i) {
+            auto previous = &rows[random_int(0, i - 1)];
+            row->start = previous->start;
+            row->end   = previous->end;
+            memcpy(row->name, previous->name, sizeof(row->name));
+        } else {
+            row->start = date_to_day_number(random_int(1, 28), random_int(1, 12), random_int(2020, 2026));
+            row->end   = row->start + random_int(1, 14);
+        }
+    }
+
+    Save_Settings settings;
+    Array <u8> before;
+    serialize_snapshot(&before, &settings);
+
+    double t0 = os_get_time();
+    import_one_by_one(&rows);
+    double t1 = os_get_time();
+
+    Array <u8> expected;
+    serialize_snapshot(&expected, &settings);
+
+    int num_bad_lines = write_import_csv(csv_path, &rows, NUM_BAD_LINES);
+    write_import_ics(ics_path, &rows);
+
+    // Back to what was there before.
+    destroy_all_employees();
+    load_snapshot_from_memory(before.data, before.count, &settings, "benchmark");
+
+    Bulk_Import_Result result;
+    double t2 = os_get_time();
+    bulk_import(csv_path, &result);
+    double t3 = os_get_time();
+
+    Array <u8> imported;
+    serialize_snapshot(&imported, &settings);
+
+    Bulk_Import_Result again;
+    bulk_import(csv_path, &again);
+
+    log("%d vacations there, %d in the file\n", NUM_EXISTING, NUM_ROWS);
+    log("%-24s %10.3f ms\n", "one at a time", (t1 - t0) * 1000.0);
+    log("%-24s %10.3f ms\n", "bulk_import, csv", (t3 - t2) * 1000.0);
+    log("%.1fx\n", (t1 - t0) / (t3 - t2));
+
+    if (!buffers_match(&expected, &imported)) report_failed_check("bulk_import didn't add the same as adding them one at a time!\n");
+    if (result.num_read != NUM_ROWS || result.num_errors != num_bad_lines) report_failed_check("Expected %d vacations and %d errors, but got %d and %d!\n", NUM_ROWS, num_bad_lines, result.num_read, result.num_errors);
+    if (result.num_added + result.num_duplicates != result.num_read) report_failed_check("Vacations went missing in bulk_import!\n");
+    if (again.num_added || again.num_new_employees) report_failed_check("Importing the same file again added %d vacations!\n", again.num_added);
+
+    destroy_all_employees();
+    load_snapshot_from_memory(before.data, before.count, &settings, "benchmark");
+
+    double t4 = os_get_time();
+    bulk_import(ics_path, &result);
+    double t5 = os_get_time();
+
+    serialize_snapshot(&imported, &settings);
+    log("%-24s %10.3f ms\n", "bulk_import, ics", (t5 - t4) * 1000.0);
+
+    if (!buffers_match(&expected, &imported)) report_failed_check("bulk_import of the .ics file didn't add the same as adding them one at a time!\n");
+    if (result.num_errors) report_failed_check("There were %d errors in the .ics file!\n", result.num_errors);
+
+    // Names and teams come in whole, however long they are.
+    {
+        char long_name[1000];
+        char long_team[1000];
+        memset(long_name, 'n', sizeof(long_name) - 1);
+        memset(long_team, 't', sizeof(long_team) - 1);
+        long_name[sizeof(long_name) - 1] = 0;
+        long_team[sizeof(long_team) - 1] = 0;
+
+        FILE *file = fopen(csv_path, "wb");
+        fprintf(file, "%s,1.7.2024,5.7.2024,%s\n", long_name, long_team);
+        fclose(file);
+
+        destroy_all_employees();
+        bulk_import(csv_path, &result);
+
+        auto employee = all_employees.count ? all_employees[all_employees.count - 1] : NULL;
+        if (!employee || !strings_match(employee->name, long_name) || !strings_match(get_team_name(employee->team_id), long_team)) {
+            report_failed_check("A long name or team didn't come through bulk_import whole!\n");
+        }
+    }
+
+    destroy_all_employees();
+}
+
+// What the exports would be with an mprintf per line, going through everything and
+// leaving out what the filter doesn't want by hand. The exporter has to write the same bytes.
+static char *mprintf_date(s32 day_number) {
+    Date date = day_number_to_date(day_number);
+    return mprintf("%04d-%02d-%02d", date.year, date.month, date.day);
+}
+
+static bool passes_filter(int row, Export_Filter *filter) {
+    auto store = &vacation_store;
+    if (store->employee_id[row] < 0) return false; // Nobody's.
+    if (filter->team_id >= 0 && store->team_id[row] != filter->team_id) return false;
+    if (filter->only_colliding && !(store->flags[row] & VACATION_IS_COLLIDING)) return false;
+    if (filter->by_date) {
+        if (store->end_day[row] <= store->start_day[row]) return false; // Never in the index.
+        if (store->end_day[row] <= filter->from || store->start_day[row] >= filter->to) return false;
+    }
+    return true;
+}
+
+static void export_calendar_with_mprintf(char *path, Export_Filter *filter) {
+    FILE *file = fopen(path, "wb");
+    fputs("employee,team,from,to,days,colliding\r\n", file);
+
+    auto store = &vacation_store;
+    for (int row = 0; row < store->count; row++) {
+        if (!passes_filter(row, filter)) continue;
+
+        char *from = mprintf_date(store->start_day[row]);
+        char *to   = mprintf_date(store->end_day[row]);
+        char *line = mprintf("%s,%s,%s,%s,%d,%d\r\n", all_employees[store->employee_id[row]]->name, get_team_name(store->team_id[row]),
+                             from, to, store->end_day[row] - store->start_day[row], (store->flags[row] & VACATION_IS_COLLIDING) ? 1 : 0);
+        fputs(line, file);
+
+        delete [] from;
+        delete [] to;
+        delete [] line;
+    }
+    fclose(file);
+}
+
+static int compare_collision_pairs(const void *a, const void *b) {
+    auto pair_a = (Vacation_Collision *)a;
+    auto pair_b = (Vacation_Collision *)b;
+    if (pair_a->a != pair_b->a) return (pair_a->a > pair_b->a) ? 1 : -1;
+    return (pair_a->b > pair_b->b) - (pair_a->b < pair_b->b);
+}
+
+static void export_collisions_with_mprintf(char *path, Export_Filter *filter) {
+    auto store = &vacation_store;
+
+    Array <Vacation_Collision> all;
+    find_colliding_vacations(&all);
+
+    Array <Vacation_Collision> collisions;
+    for (auto collision : all) {
+        int a = Min(collision.a, collision.b);
+        int b = Max(collision.a, collision.b);
+
+        s32 overlap_start = Max(store->start_day[a], store->start_day[b]);
+        s32 overlap_end   = Min(store->end_day[a],   store->end_day[b]);
+        if (filter->team_id >= 0 && store->team_id[a] != filter->team_id) continue;
+        if (filter->by_date && (overlap_end <= filter->from || overlap_start >= filter->to)) continue;
+
+        collisions.add({ a, b });
+    }
+    qsort(collisions.data, collisions.count, sizeof(Vacation_Collision), compare_collision_pairs);
+
+    FILE *file = fopen(path, "wb");
+    fputs("team,employee_a,from_a,to_a,employee_b,from_b,to_b,overlap_from,overlap_to,overlap_days\r\n", file);
+    for (auto collision : collisions) {
+        int a = collision.a, b = collision.b;
+        s32 overlap_start = Max(store->start_day[a], store->start_day[b]);
+        s32 overlap_end   = Min(store->end_day[a],   store->end_day[b]);
+
+        char *dates[6] = {
+            mprintf_date(store->start_day[a]), mprintf_date(store->end_day[a]),
+            mprintf_date(store->start_day[b]), mprintf_date(store->end_day[b]),
+            mprintf_date(overlap_start),       mprintf_date(overlap_end),
+        };
+        char *line = mprintf("%s,%s,%s,%s,%s,%s,%s,%s,%s,%d\r\n", get_team_name(store->team_id[a]),
+                             all_employees[store->employee_id[a]]->name, dates[0], dates[1],
+                             all_employees[store->employee_id[b]]->name, dates[2], dates[3],
+                             dates[4], dates[5], overlap_end - overlap_start);
+        fputs(line, file);
+
+        for (auto date : dates) delete [] date;
+        delete [] line;
+    }
+    fclose(file);
+}
+
+static bool files_match(char *path_a, char *path_b) {
+    s64 size_a = 0, size_b = 0;
+    char *a = os_read_entire_file(path_a, &size_a);
+    char *b = os_read_entire_file(path_b, &size_b);
+    defer { delete [] a; delete [] b; };
+
+    return a && b && size_a == size_b && memcmp(a, b, size_a) == 0;
+}
+
+static s64 get_file_size(char *path) {
+    s64 size = 0;
+    char *data = os_read_entire_file(path, &size);
+    delete [] data;
+    return size;
+}
+
+static void benchmark_export() {
+    const int NUM_VACATIONS = 1000000;
+    const int NUM_TEAMS = 2000; // Small teams, or there would be tens of millions of collisions.
+
+    char *path          = "benchmark_export.csv";
+    char *json_path     = "benchmark_export.json";
+    char *expected_path = "benchmark_export_expected.csv";
+    defer { remove(path); remove(json_path); remove(expected_path); };
+
+    // Like generate_random_roster, but all at once, since a million vacations one at a time take a while.
+    destroy_all_employees();
+    begin_batched_changes();
+    for (int i = 0; i < NUM_VACATIONS / 10; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "Employee %d", i);
+        auto employee = add_employee(name);
+
+        char team[32];
+        snprintf(team, sizeof(team), "Team %d", random_int(1, NUM_TEAMS));
+        set_employee_team(employee, team);
+    }
+
+    Array <New_Vacation> vacations;
+    vacations.reserve(NUM_VACATIONS);
+    for (int i = 0; i < NUM_VACATIONS; i++) {
+        s32 from = date_to_day_number(random_int(1, 20), random_int(1, 12), random_int(2020, 2025));
+        vacations.add({ random_int(0, all_employees.count - 1), from, from + random_int(1, 8) });
+    }
+    add_vacations(&vacations);
+    end_batched_changes();
+
+    Export_Filter everything;
+
+    double t0 = os_get_time();
+    export_calendar_with_mprintf(expected_path, &everything);
+    double t1 = os_get_time();
+    export_calendar(path, EXPORT_CSV, &everything);
+    double t2 = os_get_time();
+    export_calendar(json_path, EXPORT_JSON, &everything);
+    double t3 = os_get_time();
+
+    double megabytes = (double)get_file_size(path) / (1024.0 * 1024.0);
+    double json_megabytes = (double)get_file_size(json_path) / (1024.0 * 1024.0);
+
+    log("%d vacations in %d teams\n", vacation_store.count, NUM_TEAMS);
+    log("%-28s %10s %10s\n", "", "ms", "MB/s");
+    log("%-28s %10.3f %10.1f\n", "calendar, mprintf per line", (t1 - t0) * 1000.0, megabytes / (t1 - t0));
+    log("%-28s %10.3f %10.1f\n", "calendar, csv",              (t2 - t1) * 1000.0, megabytes / (t2 - t1));
+    log("%-28s %10.3f %10.1f\n", "calendar, json",             (t3 - t2) * 1000.0, json_megabytes / (t3 - t2));
+
+    if (!files_match(path, expected_path)) report_failed_check("The calendar isn't what mprintf would have written!\n");
+
+    double t4 = os_get_time();
+    export_collisions_with_mprintf(expected_path, &everything);
+    double t5 = os_get_time();
+    export_collision_report(path, EXPORT_CSV, &everything);
+    double t6 = os_get_time();
+
+    log("%-28s %10.3f\n", "collisions, mprintf per line", (t5 - t4) * 1000.0);
+    log("%-28s %10.3f\n", "collisions, csv",              (t6 - t5) * 1000.0);
+
+    if (!files_match(path, expected_path)) report_failed_check("The collision report isn't what mprintf would have written!\n");
+
+    // Narrow exports only look at what the index gives them.
+    Export_Filter filters[4];
+    filters[0].by_date = true;
+    filters[0].from = date_to_day_number(1, 7, 2024);
+    filters[0].to   = date_to_day_number(1, 8, 2024);
+
+    filters[1] = filters[0];
+    filters[1].team_id = get_team_id("Team 7");
+
+    filters[2].team_id = get_team_id("Team 3");
+    filters[2].only_colliding = true;
+
+    filters[3] = filters[1];
+    filters[3].only_colliding = true;
+
+    char *filter_names[] = { "July 2024", "July 2024, one team", "one team, colliding", "July, team, colliding" };
+
+    for (int i = 0; i < ArrayCount(filters); i++) {
+        auto filter = &filters[i];
+
+        export_calendar_with_mprintf(expected_path, filter);
+        double t7 = os_get_time();
+        export_calendar(path, EXPORT_CSV, filter);
+        double t8 = os_get_time();
+        bool calendar_matches = files_match(path, expected_path);
+
+        export_collisions_with_mprintf(expected_path, filter);
+        double t9 = os_get_time();
+        export_collision_report(path, EXPORT_CSV, filter);
+        double t10 = os_get_time();
+        bool collisions_match = files_match(path, expected_path);
+
+        log("%-24s calendar %8.3f ms, collisions %8.3f ms\n", filter_names[i], (t8 - t7) * 1000.0, (t10 - t9) * 1000.0);
+
+        if (!calendar_matches) report_failed_check("The calendar for '%s' isn't what it should be!\n", filter_names[i]);
+        if (!collisions_match) report_failed_check("The collision report for '%s' isn't what it should be!\n", filter_names[i]);
+    }
+
+    // Names that need quoting or escaping.
+    {
+        destroy_all_employees();
+        auto employee = add_employee("Doe, \"Jo\"\\\t");
+        employee->add_vacation_info(date_to_day_number(1, 7, 2024), date_to_day_number(5, 7, 2024));
+
+        export_calendar(path, EXPORT_CSV, &everything);
+        export_calendar(json_path, EXPORT_JSON, &everything);
+
+        s64 size = 0;
+        char *csv = os_read_entire_file(path, &size);
+        char *json = os_read_entire_file(json_path, &size);
+        defer { delete [] csv; delete [] json; };
+
+        if (!csv || !strstr(csv, "\"Doe, \"\"Jo\"\"\\\t\",,2024-07-01,2024-07-05,4,0\r\n")) report_failed_check("The CSV doesn't quote names right!\n");
+        if (!json || !strstr(json, "\"employee\": \"Doe, \\\"Jo\\\"\\\\\\t\"")) report_failed_check("The JSON doesn't escape names right!\n");
+    }
+
+    destroy_all_employees();
+}
+
+// What the loaded rows take up, not counting what the arrays have room for.
+static s64 get_vacation_store_bytes() {
+    s64 bytes_per_row = 5 * sizeof(s32) + sizeof(u8);
+    return vacation_store.count * bytes_per_row;
+}
+
+static void benchmark_partitioned_load() {
+    const int NUM_EMPLOYEES = 20000;
+    const int NUM_YEARS = 20;
+    const int VACATIONS_PER_YEAR = 3; // Per employee, so 1.2M in all.
+    const int NUM_TEAMS = 2000;
+    const int NUM_RUNS = 5;
+
+    char *snapshot_path = "benchmark_partitioned.bin";
+    char *journal_path  = "benchmark_partitioned.journal";
+    defer { close_journal(); remove(snapshot_path); remove(journal_path); };
+
+    // Twenty years of history up to next year, of which startup only needs the last few.
+    int last_year  = os_get_local_time().year + 1;
+    int first_year = last_year - NUM_YEARS + 1;
+
+    destroy_all_employees();
+    begin_batched_changes();
+    for (int i = 0; i < NUM_EMPLOYEES; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "Employee %d", i);
+        auto employee = add_employee(name);
+
+        char team[32];
+        snprintf(team, sizeof(team), "Team %d", random_int(1, NUM_TEAMS));
+        set_employee_team(employee, team);
+    }
+
+    Array <New_Vacation> vacations;
+    vacations.reserve(NUM_EMPLOYEES * NUM_YEARS * VACATIONS_PER_YEAR);
+    for (int i = 0; i < NUM_EMPLOYEES * NUM_YEARS * VACATIONS_PER_YEAR; i++) {
+        s32 from = date_to_day_number(random_int(1, 28), random_int(1, 12), random_int(first_year, last_year));
+        vacations.add({ random_int(0, NUM_EMPLOYEES - 1), from, from + random_int(1, 14) });
+    }
+    add_vacations(&vacations);
+    end_batched_changes();
+
+    Save_Settings settings;
+    settings.window_width  = 1600;
+    settings.window_height = 900;
+    save_snapshot(snapshot_path, &settings);
+
+    Array <u8> original;
+    serialize_snapshot(&original, &settings);
+
+    s32 old_from = date_to_day_number(1, 3, first_year + 2);
+    s32 old_to   = date_to_day_number(1, 4, first_year + 2);
+    Array <int> expected_rows;
+    find_vacations_between(old_from, old_to, &expected_rows);
+
+    double full_time = 0;
+    double window_time = 0;
+    double page_in_time = 0;
+    int window_rows = 0;
+    s64 window_bytes = 0;
+    s64 full_bytes = 0;
+    bool matches = true;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+        // Everything, which is what startup used to do.
+        destroy_all_employees();
+        Save_Settings full_settings;
+        double t0 = os_get_time();
+        {
+            s64 length = 0;
+            u8 *data = (u8 *)os_read_entire_file(snapshot_path, &length);
+            load_snapshot_from_memory(data, length, &full_settings, snapshot_path);
+            delete [] data;
+        }
+        double t1 = os_get_time();
+
+        full_bytes = get_vacation_store_bytes();
+
+        Array <u8> loaded;
+        serialize_snapshot(&loaded, &full_settings);
+        if (!buffers_match(&original, &loaded)) matches = false;
+
+        // Only the window; what is left out still has to be saved as it was.
+        destroy_all_employees();
+        Save_Settings window_settings;
+        double t2 = os_get_time();
+        load_snapshot(snapshot_path, &window_settings);
+        double t3 = os_get_time();
+
+        window_rows  = vacation_store.count;
+        window_bytes = get_vacation_store_bytes();
+
+        serialize_snapshot(&loaded, &window_settings);
+        if (!buffers_match(&original, &loaded)) matches = false;
+
+        // Asking about an old month brings in what it needs.
+        Array <int> rows;
+        double t4 = os_get_time();
+        find_vacations_between(old_from, old_to, &rows);
+        double t5 = os_get_time();
+        if (rows.count != expected_rows.count) matches = false;
+
+        serialize_snapshot(&loaded, &window_settings);
+        if (!buffers_match(&original, &loaded)) matches = false;
+
+        load_all_vacations();
+        if (vacation_store.count != vacations.count) matches = false;
+
+        serialize_snapshot(&loaded, &window_settings);
+        if (!buffers_match(&original, &loaded)) matches = false;
+
+        full_time    += t1 - t0;
+        window_time  += t3 - t2;
+        page_in_time += t5 - t4;
+    }
+
+    log("%d employees, %d vacations in %d years; %d of them (%.1f%%) are loaded at startup\n", all_employees.count, vacations.count, NUM_YEARS, window_rows, 100.0 * window_rows / vacations.count);
+    log("%-26s %12s %14s\n", "", "load (ms)", "vacations (MB)");
+    log("%-26s %12.3f %14.2f\n", "everything", full_time / NUM_RUNS * 1000.0, full_bytes / (1024.0 * 1024.0));
+    log("%-26s %12.3f %14.2f\n", "the window", window_time / NUM_RUNS * 1000.0, window_bytes / (1024.0 * 1024.0));
+    log("%-26s %12.3f\n", "a month from long ago", page_in_time / NUM_RUNS * 1000.0);
+
+    if (!matches) report_failed_check("Loading only the window lost or changed vacations!\n");
+
+    // Changes to years that aren't loaded have to come back the same from the journal.
+    {
+        destroy_all_employees();
+        Save_Settings journal_settings;
+        load_snapshot(snapshot_path, &journal_settings);
+        remove(journal_path);
+        open_journal(journal_path, &journal_settings);
+
+        s32 day = date_to_day_number(10, 6, first_year + 1);
+        auto employee = all_employees[0];
+        int index = employee->add_vacation_info(day, day + 5);
+        employee->edit_vacation_info(index, day + 1, day + 6);
+        employee->add_vacation_info(day, day + 5);
+
+        // The oldest vacation of some employee, which isn't loaded yet when the journal is replayed.
+        auto other = all_employees[1];
+        int oldest = 0;
+        for (int i = 1; i < other->num_vacations; i++) {
+            if (vacation_store.start_day[other->first_vacation + i] < vacation_store.start_day[other->first_vacation + oldest]) oldest = i;
+        }
+        other->remove_vacation_info(oldest);
+        close_journal();
+
+        Array <u8> expected;
+        serialize_snapshot(&expected, &journal_settings);
+
+        destroy_all_employees();
+        Save_Settings replayed_settings;
+        begin_batched_changes();
+        load_snapshot(snapshot_path, &replayed_settings);
+        open_journal(journal_path, &replayed_settings);
+        end_batched_changes();
+        close_journal();
+
+        Array <u8> replayed;
+        serialize_snapshot(&replayed, &journal_settings);
+        if (!buffers_match(&expected, &replayed)) report_failed_check("Replaying changes to years that weren't loaded didn't give them back!\n");
+    }
+
+    destroy_all_employees();
+}
+
+static u8 *find_bytes(u8 *data, s64 size, void *bytes, s64 length) {
+    for (s64 i = 0; i + length <= size; i++) {
+        if (memcmp(data + i, bytes, length) == 0) return data + i;
+    }
+    return NULL;
+}
+
+static int get_start_year(int row) {
+    return day_number_to_date(vacation_store.start_day[row]).year;
+}
+
+static void benchmark_snapshot_recovery() {
+    const int NUM_VACATIONS = 100000; // 10000 employees.
+    const int NUM_RUNS = 5;
+
+    char *snapshot_path = "benchmark_recovery.bin";
+    defer { remove(snapshot_path); };
+
+    generate_random_roster(NUM_VACATIONS);
+
+    Save_Settings settings;
+    Array <u8> original;
+    serialize_snapshot(&original, &settings);
+
+    // What should be left after the damage below: one employee's name, all of 2022, and
+    // the last part of 2025.
+    const int DAMAGED_EMPLOYEE = 300;
+    const int DAMAGED_YEAR = 2022;
+    const int LAST_YEAR = 2025;
+    int first_in_last_part = (all_employees.count - 1) / 256 * 256; // EMPLOYEES_PER_PART in save_file.cpp.
+
+    u32 num_in_damaged_year = 0;
+    Array <int> expected_counts;
+    expected_counts.resize(all_employees.count);
+    for (auto employee : all_employees) {
+        int count = 0;
+        for (int i = 0; i < employee->num_vacations; i++) {
+            int year = get_start_year(employee->first_vacation + i);
+            if (year == DAMAGED_YEAR) num_in_damaged_year += 1;
+
+            if (year == DAMAGED_YEAR) continue;
+            if (year == LAST_YEAR && employee->id >= first_in_last_part) continue;
+            count += 1;
+        }
+        expected_counts[employee->id] = count;
+    }
+
+    Array <u8> damaged;
+    damaged.resize(original.count);
+    memcpy(damaged.data, original.data, original.count);
+
+    bool found = true;
+    {
+        char name[64];
+        int length = snprintf(name, sizeof(name), "Employee %d", DAMAGED_EMPLOYEE) + 1;
+        u8 *at = find_bytes(damaged.data, damaged.count, name, length);
+        if (at) at[0] ^= 0x20;
+        else    found = false;
+
+        // The year's entry starts with the year and the number of its vacations.
+        s32 entry[2] = { DAMAGED_YEAR, (s32)num_in_damaged_year };
+        at = find_bytes(damaged.data, damaged.count, entry, sizeof(entry));
+        if (at) at[4] ^= 0x01;
+        else    found = false;
+
+        // The end days of the newest year are at the end of the file, with maybe 4 bytes of padding after them.
+        damaged[damaged.count - 1] ^= 0x40;
+        damaged[damaged.count - 5] ^= 0x40;
+    }
+    if (!found) report_failed_check("Couldn't find the pieces of the snapshot to damage!\n");
+
+    double clean_time = 0;
+    double damaged_time = 0;
+    bool recovered = true;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+        destroy_all_employees();
+        Save_Settings clean_settings;
+        double t0 = os_get_time();
+        load_snapshot_from_memory(original.data, original.count, &clean_settings, snapshot_path);
+        double t1 = os_get_time();
+        if (clean_settings.snapshot_was_repaired) recovered = false;
+
+        destroy_all_employees();
+        Save_Settings damaged_settings;
+        double t2 = os_get_time();
+        bool loaded = load_snapshot_from_memory(damaged.data, damaged.count, &damaged_settings, snapshot_path);
+        double t3 = os_get_time();
+
+        if (!loaded || !damaged_settings.snapshot_was_repaired) recovered = false;
+        if (all_employees.count != expected_counts.count) recovered = false;
+
+        for (auto employee : all_employees) {
+            if (employee->num_vacations != expected_counts[employee->id]) recovered = false;
+
+            // The made up name isn't in English, and the damaged one would start with 'e'.
+            bool is_placeholder = employee->name[0] != 'E' && employee->name[0] != 'e';
+            if (is_placeholder != (employee->id == DAMAGED_EMPLOYEE)) recovered = false;
+        }
+
+        clean_time   += t1 - t0;
+        damaged_time += t3 - t2;
+    }
+
+    log("%d employees, %d vacations, %d KB\n", all_employees.count, NUM_VACATIONS, original.count / 1024);
+    log("%-26s %12s\n", "", "load (ms)");
+    log("%-26s %12.3f\n", "whole", clean_time / NUM_RUNS * 1000.0);
+    log("%-26s %12.3f\n", "damaged in three places", damaged_time / NUM_RUNS * 1000.0);
+
+    if (!recovered) report_failed_check("Loading the damaged snapshot didn't keep exactly what wasn't damaged!\n");
+
+    // Saved again, it has to load without complaining and give back the same.
+    {
+        Save_Settings repaired_settings;
+        save_snapshot(snapshot_path, &repaired_settings);
+
+        Array <u8> expected;
+        serialize_snapshot(&expected, &repaired_settings);
+
+        destroy_all_employees();
+        Save_Settings reloaded_settings;
+        load_snapshot(snapshot_path, &reloaded_settings);
+        load_all_vacations();
+
+        Array <u8> reloaded;
+        serialize_snapshot(&reloaded, &reloaded_settings);
+        if (reloaded_settings.snapshot_was_repaired || !buffers_match(&expected, &reloaded)) report_failed_check("The repaired snapshot didn't load back the same!\n");
+    }
+
+    // Without the header nothing can be found, so that is the end of it.
+    {
+        memcpy(damaged.data, original.data, original.count);
+        damaged[8] ^= 0x01;
+
+        destroy_all_employees();
+        Save_Settings header_settings;
+        if (load_snapshot_from_memory(damaged.data, damaged.count, &header_settings, snapshot_path) || all_employees.count) {
+            report_failed_check("A snapshot with a damaged header was loaded!\n");
+        }
+    }
+
+    destroy_all_employees();
+}
+
+// What Array costs next to std::vector, which grows the same way.
+struct Array_Timings {
+    double push = 0;
+    double iterate = 0;
+    double remove = 0;
+    u64 sum = 0;
+};
+
+static void time_array(int num_items, int num_runs, u32 *removals, Array_Timings *timings) {
+    for (int run = 0; run < num_runs; run++) {
+        Array <u32> array;
+
+        double t0 = os_get_time();
+        for (int i = 0; i < num_items; i++) array.add((u32)i);
+        double t1 = os_get_time();
+        u64 sum = 0;
+        for (auto item : array) sum += item;
+        double t2 = os_get_time();
+        for (int i = 0; i < num_items; i++) array.unordered_remove_by_index(removals[i] % array.count);
+        double t3 = os_get_time();
+
+        timings->push    += t1 - t0;
+        timings->iterate += t2 - t1;
+        timings->remove  += t3 - t2;
+        timings->sum     += sum;
+    }
+}
+
+static void time_vector(int num_items, int num_runs, u32 *removals, Array_Timings *timings) {
+    for (int run = 0; run < num_runs; run++) {
+        std::vector <u32> vector;
+
+        double t0 = os_get_time();
+        for (int i = 0; i < num_items; i++) vector.push_back((u32)i);
+        double t1 = os_get_time();
+        u64 sum = 0;
+        for (auto item : vector) sum += item;
+        double t2 = os_get_time();
+        for (int i = 0; i < num_items; i++) {
+            vector[removals[i] % vector.size()] = vector.back();
+            vector.pop_back();
+        }
+        double t3 = os_get_time();
+
+        timings->push    += t1 - t0;
+        timings->iterate += t2 - t1;
+        timings->remove  += t3 - t2;
+        timings->sum     += sum;
+    }
+}
+
+static bool array_matches(Array <int> *array, int *expected, int count) {
+    if (array->count != count) return false;
+    return memcmp(array->data, expected, count * sizeof(int)) == 0;
+}
+
+static void benchmark_array() {
+    const int MAX_ITEMS = 10000000;
+    const int ITEMS_PER_SIZE = 20000000; // Smaller sizes are run more times.
+
+    Array <u32> removals;
+    removals.resize(MAX_ITEMS);
+    for (auto &removal : removals) removal = random_u32();
+
+    log("%-10s %-8s %12s %12s %12s   (ns per item)\n", "items", "", "push", "iterate", "remove");
+
+    bool sums_match = true;
+    for (int num_items = 1000; num_items <= MAX_ITEMS; num_items *= 10) {
+        int num_runs = Max(ITEMS_PER_SIZE / num_items, 1);
+
+        Array_Timings array_timings, vector_timings;
+        time_array(num_items, num_runs, removals.data, &array_timings);
+        time_vector(num_items, num_runs, removals.data, &vector_timings);
+        if (array_timings.sum != vector_timings.sum) sums_match = false;
+
+        double scale = 1e9 / ((double)num_items * num_runs);
+        log("%-10d %-8s %12.3f %12.3f %12.3f\n", num_items, "Array", array_timings.push * scale, array_timings.iterate * scale, array_timings.remove * scale);
+        log("%-10s %-8s %12.3f %12.3f %12.3f\n", "", "vector", vector_timings.push * scale, vector_timings.iterate * scale, vector_timings.remove * scale);
+    }
+
+    if (!sums_match) report_failed_check("Array and std::vector didn't add up to the same!\n");
+
+    // The ones that move items around.
+    {
+        Array <int> array;
+        int first[] = { 0, 1, 2, 3 };
+        array.add_n(first, 4);
+
+        int middle[] = { 10, 11 };
+        array.insert_range(2, middle, 2);
+        array.insert_range(array.count, middle, 1);
+        array.insert_range(0, middle + 1, 1);
+        int after_insert[] = { 11, 0, 1, 10, 11, 2, 3, 10 };
+        bool ok = array_matches(&array, after_insert, 8);
+
+        array.ordered_remove_by_index(0);
+        array.unordered_remove_by_index(1);
+        int after_remove[] = { 0, 10, 10, 11, 2, 3 };
+        ok = ok && array_matches(&array, after_remove, 6);
+
+        // Adding one of its own items while it grows.
+        array.shrink_to_fit();
+        ok = ok && array.allocated == array.count;
+        array.add(array[1]);
+        int after_add[] = { 0, 10, 10, 11, 2, 3, 10 };
+        ok = ok && array_matches(&array, after_add, 7);
+
+        array.count = 0;
+        array.shrink_to_fit();
+        ok = ok && array.data == NULL;
+        array.add(5);
+        ok = ok && array.count == 1 && array[0] == 5;
+
+        if (!ok) report_failed_check("Array didn't move its items where they should go!\n");
+    }
+}
+
+// Counts how many are alive, to check Array constructs and destroys what it has to.
+static int num_tracked_alive = 0;
+
+struct Tracked {
+    Array <int> values; // Owns memory, so it can't be moved as bytes.
+
+    Tracked() { num_tracked_alive += 1; }
+    Tracked(Tracked const &other) {
+        num_tracked_alive += 1;
+        values.add_n(other.values.data, other.values.count);
+    }
+    Tracked(Tracked &&other) : values(static_cast<Array <int> &&>(other.values)) { num_tracked_alive += 1; }
+    ~Tracked() { num_tracked_alive -= 1; }
+
+    Tracked &operator=(Tracked &&other) {
+        values = static_cast<Array <int> &&>(other.values);
+        return *this;
+    }
+};
+
+static Tracked make_tracked(int value) {
+    Tracked tracked;
+    tracked.values.add(value);
+    tracked.values.add(-value);
+    return tracked;
+}
+
+static bool tracked_match(Array <Tracked> *array, int *expected, int count) {
+    if (array->count != count) return false;
+    for (int i = 0; i < count; i++) {
+        auto values = &(*array)[i].values;
+        if (values->count != 2 || (*values)[0] != expected[i] || (*values)[1] != -expected[i]) return false;
+    }
+    return num_tracked_alive == count;
+}
+
+// Every run mixes its own number in, or the compiler sees that the sum is the same
+// each time and works it out once.
+static u64 sum_shown_vacations(Array <Employee> *employees, u64 run) {
+    u64 sum = 0;
+    for (auto &employee : *employees) {
+        if (employee.draw_all_vacations_on_hud) sum += (u64)(employee.num_vacations + employee.team_id) ^ run;
+    }
+    return sum;
+}
+
+static u64 sum_shown_vacations(Array <Employee *> *employees, u64 run) {
+    u64 sum = 0;
+    for (auto employee : *employees) {
+        if (employee->draw_all_vacations_on_hud) sum += (u64)(employee->num_vacations + employee->team_id) ^ run;
+    }
+    return sum;
+}
+
+static void benchmark_inline_array() {
+    const int MAX_EMPLOYEES = 1000000;
+    const int ITEMS_PER_SIZE = 50000000;
+
+    log("%-10s %14s %14s %14s   (ns per employee)\n", "employees", "inline", "pointers", "scattered");
+
+    bool sums_match = true;
+    for (int num_employees = 1000; num_employees <= MAX_EMPLOYEES; num_employees *= 10) {
+        int num_runs = Max(ITEMS_PER_SIZE / num_employees, 1);
+
+        // Like add_employee does it: the name, then the employee.
+        Array <Employee> inline_employees;
+        Array <Employee *> pointers;
+        Array <char *> names;
+        for (int i = 0; i < num_employees; i++) {
+            char *name = mprintf("Employee %d", i);
+            names.add(name);
+
+            Employee employee;
+            employee.name = name;
+            employee.id = i;
+            employee.team_id = random_int(0, 20);
+            employee.num_vacations = random_int(0, 30);
+            employee.draw_all_vacations_on_hud = random_int(0, 3) != 0;
+
+            inline_employees.add(employee);
+            pointers.add(new Employee(employee));
+        }
+
+        // After a while of adding and removing, they end up all over the heap.
+        Array <Employee *> scattered;
+        scattered.add_n(pointers.data, pointers.count);
+        for (int i = scattered.count - 1; i > 0; i--) {
+            int j = random_int(0, i);
+            Employee *swap = scattered[i];
+            scattered[i] = scattered[j];
+            scattered[j] = swap;
+        }
+
+        u64 inline_sum = 0, pointers_sum = 0, scattered_sum = 0;
+
+        double t0 = os_get_time();
+        for (int run = 0; run < num_runs; run++) inline_sum += sum_shown_vacations(&inline_employees, run);
+        double t1 = os_get_time();
+        for (int run = 0; run < num_runs; run++) pointers_sum += sum_shown_vacations(&pointers, run);
+        double t2 = os_get_time();
+        for (int run = 0; run < num_runs; run++) scattered_sum += sum_shown_vacations(&scattered, run);
+        double t3 = os_get_time();
+
+        if (inline_sum != pointers_sum || inline_sum != scattered_sum) sums_match = false;
+
+        double scale = 1e9 / ((double)num_employees * num_runs);
+        log("%-10d %14.3f %14.3f %14.3f\n", num_employees, (t1 - t0) * scale, (t2 - t1) * scale, (t3 - t2) * scale);
+
+        for (auto employee : pointers) delete employee;
+        for (auto name : names) delete [] name;
+    }
+
+    if (!sums_match) report_failed_check("Employees stored inline and through pointers didn't add up to the same!\n");
+
+    // Items that can't be moved as bytes.
+    {
+        bool ok = true;
+        {
+            Array <Tracked> array;
+            for (int i = 0; i < 1000; i++) array.add(make_tracked(i));
+            ok = ok && num_tracked_alive == 1000 && array[999].values[0] == 999;
+
+            array.resize(3);
+            int after_resize[] = { 0, 1, 2 };
+            ok = ok && tracked_match(&array, after_resize, 3);
+
+            {
+                Tracked inserted[] = { make_tracked(10), make_tracked(11) };
+                array.insert_range(1, inserted, 2);
+            }
+            int after_insert[] = { 0, 10, 11, 1, 2 };
+            ok = ok && tracked_match(&array, after_insert, 5);
+
+            array.ordered_remove_by_index(1);
+            array.unordered_remove_by_index(0);
+            int after_remove[] = { 2, 11, 1 };
+            ok = ok && tracked_match(&array, after_remove, 3);
+
+            // Adding one of its own items while it grows.
+            array.shrink_to_fit();
+            ok = ok && array.allocated == 3;
+            array.add(array[0]);
+            int after_add[] = { 2, 11, 1, 2 };
+            ok = ok && tracked_match(&array, after_add, 4);
+
+            Array <Tracked> moved = static_cast<Array <Tracked> &&>(array);
+            ok = ok && !array.count && tracked_match(&moved, after_add, 4);
+        }
+        ok = ok && num_tracked_alive == 0;
+
+        if (!ok) report_failed_check("Array didn't construct and destroy its items the way it should!\n");
+    }
+}
+
+// The table from before the control bytes, to compare with: linear probing, a bool per
+// slot, and growing only once it is full.
+static int old_hash(int x) {
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = (x >> 16) ^ x;
+    return x;
+}
+
+struct Old_Hash_Table {
+    struct Bucket {
+        int key;
+        int value;
+    };
+
+    Bucket *buckets = nullptr;
+    bool *occupancy_mask = nullptr;
+    int allocated = 0;
+    int count = 0;
+
+    void grow() {
+        if (!buckets) {
+            buckets = (Bucket *)calloc(256, sizeof(Bucket));
+            occupancy_mask = (bool *)calloc(256, sizeof(bool));
+            allocated = 256;
+            count = 0;
+        } else {
+            Old_Hash_Table new_hash_table = {
+                (Bucket *)calloc(allocated * 2, sizeof(Bucket)),
+                (bool *)calloc(allocated * 2, sizeof(bool)),
+                allocated * 2,
+                0,
+            };
+
+            for (int i = 0; i < count; i++) {
+                if (occupancy_mask[i]) new_hash_table.add(buckets[i].key, buckets[i].value);
+            }
+
+            free(buckets);
+            free(occupancy_mask);
+            *this = new_hash_table;
+        }
+    }
+
+    void add(int key, int value) {
+        if (count >= allocated) grow();
+
+        auto hk = old_hash(key) & (allocated - 1);
+        while (occupancy_mask[hk] && buckets[hk].key != key) hk = (hk + 1) & (allocated - 1);
+
+        occupancy_mask[hk] = true;
+        buckets[hk].key = key;
+        buckets[hk].value = value;
+        count++;
+    }
+
+    int *find(int key) {
+        auto hk = old_hash(key) & (allocated - 1);
+        for (int i = 0; i < allocated && occupancy_mask[hk] && buckets[hk].key != key; i++) hk = (hk + 1) & (allocated - 1);
+
+        if (buckets && occupancy_mask[hk] && buckets[hk].key == key) return &buckets[hk].value;
+        return nullptr;
+    }
+
+    void deinit() {
+        free(buckets);
+        free(occupancy_mask);
+        *this = {};
+    }
+};
+
+struct Hash_Table_Timings {
+    double insert = 0;
+    double hit = 0;
+    double miss = 0;
+    s64 found = 0;
+};
+
+template <typename Table>
+static void time_hash_table(Table *table, Array <int> *keys, Array <int> *missing, Hash_Table_Timings *timings) {
+    double t0 = os_get_time();
+    for (int i = 0; i < keys->count; i++) table->add((*keys)[i], i);
+    double t1 = os_get_time();
+    for (auto key : *keys) {
+        if (table->find(key)) timings->found += 1;
+    }
+    double t2 = os_get_time();
+    for (auto key : *missing) {
+        if (table->find(key)) timings->found += 1;
+    }
+    double t3 = os_get_time();
+
+    timings->insert += t1 - t0;
+    timings->hit    += t2 - t1;
+    timings->miss   += t3 - t2;
+}
+
+static void benchmark_hash_table() {
+    const int MAX_KEYS = 1000000;
+    const int KEYS_PER_SIZE = 4000000;
+
+    log("%-10s %-8s %12s %12s %12s   (ns per key)\n", "keys", "", "insert", "find", "find missing");
+
+    bool found_match = true;
+    for (int num_keys = 1000; num_keys <= MAX_KEYS; num_keys *= 10) {
+        int num_runs = Max(KEYS_PER_SIZE / num_keys, 1);
+
+        // Odd keys are in, even ones aren't.
+        Array <int> keys, missing;
+        for (int i = 0; i < num_keys; i++) {
+            int key = (int)(random_u32() | 1);
+            keys.add(key);
+            missing.add(key ^ 1);
+        }
+
+        Hash_Table_Timings old_timings, new_timings;
+        for (int run = 0; run < num_runs; run++) {
+            Old_Hash_Table old_table;
+            time_hash_table(&old_table, &keys, &missing, &old_timings);
+            old_table.deinit();
+
+            Hash_Table <int, int> new_table;
+            time_hash_table(&new_table, &keys, &missing, &new_timings);
+            new_table.deinit();
+        }
+        if (old_timings.found != new_timings.found) found_match = false;
+
+        double scale = 1e9 / ((double)num_keys * num_runs);
+        log("%-10d %-8s %12.3f %12.3f %12.3f\n", num_keys, "before", old_timings.insert * scale, old_timings.hit * scale, old_timings.miss * scale);
+        log("%-10s %-8s %12.3f %12.3f %12.3f\n", "", "now", new_timings.insert * scale, new_timings.hit * scale, new_timings.miss * scale);
+    }
+
+    if (!found_match) report_failed_check("The old and the new table didn't find the same keys!\n");
+
+    // Adding, replacing and removing at random, checked against a plain array.
+    {
+        const int NUM_POSSIBLE_KEYS = 50000;
+        const int NUM_CHANGES = 2000000;
+
+        Array <int> expected;
+        expected.resize(NUM_POSSIBLE_KEYS);
+        for (auto &value : expected) value = -1;
+
+        Hash_Table <int, int> table;
+        bool ok = true;
+        int num_in = 0;
+        for (int i = 0; i < NUM_CHANGES && ok; i++) {
+            int key = random_int(0, NUM_POSSIBLE_KEYS - 1);
+            if (random_int(0, 2)) {
+                if (expected[key] < 0) num_in += 1;
+                table.add(key, i);
+                expected[key] = i;
+            } else {
+                bool removed = table.remove(key);
+                if (removed != (expected[key] >= 0)) ok = false;
+                if (removed) num_in -= 1;
+                expected[key] = -1;
+            }
+
+            int probe = random_int(0, NUM_POSSIBLE_KEYS - 1);
+            int *value = table.find(probe);
+            if (value ? *value != expected[probe] : expected[probe] >= 0) ok = false;
+        }
+        ok = ok && table.count == num_in;
+        for (int key = 0; key < NUM_POSSIBLE_KEYS && ok; key++) {
+            int *value = table.find(key);
+            if (value ? *value != expected[key] : expected[key] >= 0) ok = false;
+        }
+        table.deinit();
+
+        String_Hash_Table <int> names;
+        for (int i = 0; i < 10000; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "Employee %d", i);
+            names.add(name, i);
+        }
+        for (int i = 0; i < 10000; i += 2) {
+            char name[32];
+            snprintf(name, sizeof(name), "Employee %d", i);
+            ok = ok && names.remove(name);
+        }
+        for (int i = 0; i < 10000; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "Employee %d", i);
+            int *value = names.find(name);
+            ok = ok && (i % 2 ? value && *value == i : !value);
+        }
+        ok = ok && names.table.count == 5000;
+        names.deinit();
+
+        if (!ok) report_failed_check("The hash table lost or made up keys!\n");
+    }
+}
+
+// What get_team_id did before the names were interned.
+static int find_team_id_by_scanning(char *name) {
+    for (int i = 1; i < team_names.count; i++) {
+        if (strings_match(team_names[i], name)) return i;
+    }
+    return 0;
+}
+
+static void benchmark_string_pool() {
+    const int NUM_LOOKUPS = 10000000;
+    const int NUM_TEAMS = 2000;
+    const int NUM_TEAM_LOOKUPS = 1000000;
+
+    // A catalog's worth of names, looked up every frame.
+    char *names[] = { "white", "black", "button", "checkbox", "arrow_left", "arrow_right", "calendar", "close" };
+
+    String_Hash_Table <int> by_text;
+    Hash_Table <Interned_String, int> by_handle;
+    Interned_String handles[ArrayCount(names)];
+    for (int i = 0; i < ArrayCount(names); i++) {
+        by_text.add(names[i], i);
+        handles[i] = intern_string(names[i]);
+        by_handle.add(handles[i], i);
+    }
+    defer { by_text.deinit(); by_handle.deinit(); };
+
+    s64 text_sum = 0, interning_sum = 0, handle_sum = 0;
+
+    double t0 = os_get_time();
+    for (int i = 0; i < NUM_LOOKUPS; i++) text_sum += *by_text.find(names[i % ArrayCount(names)]);
+    double t1 = os_get_time();
+    for (int i = 0; i < NUM_LOOKUPS; i++) interning_sum += *by_handle.find(intern_string(names[i % ArrayCount(names)]));
+    double t2 = os_get_time();
+    for (int i = 0; i < NUM_LOOKUPS; i++) handle_sum += *by_handle.find(handles[i % ArrayCount(names)]);
+    double t3 = os_get_time();
+
+    double scale = 1e9 / NUM_LOOKUPS;
+    log("%-34s %10s\n", "", "ns each");
+    log("%-34s %10.3f\n", "catalog lookup, by text",            (t1 - t0) * scale);
+    log("%-34s %10.3f\n", "catalog lookup, interning the text", (t2 - t1) * scale);
+    log("%-34s %10.3f\n", "catalog lookup, by handle",          (t3 - t2) * scale);
+
+    if (text_sum != interning_sum || text_sum != handle_sum) report_failed_check("Looking up by handle didn't find the same as by text!\n");
+
+    // Teams, which used to be found by going through all of their names.
+    {
+        Array <char *> team_lookups;
+        for (int i = 0; i < NUM_TEAMS; i++) get_team_id(mprintf("Pool team %d", i));
+        for (int i = 0; i < NUM_TEAM_LOOKUPS; i++) team_lookups.add(get_team_name(random_int(1, team_names.count - 1)));
+
+        s64 scanned_sum = 0, interned_sum = 0;
+
+        double t4 = os_get_time();
+        for (auto name : team_lookups) scanned_sum += find_team_id_by_scanning(name);
+        double t5 = os_get_time();
+        for (auto name : team_lookups) interned_sum += get_team_id(name);
+        double t6 = os_get_time();
+
+        double team_scale = 1e9 / NUM_TEAM_LOOKUPS;
+        log("%-34s %10.3f\n", "team id, going through every team", (t5 - t4) * team_scale);
+        log("%-34s %10.3f\n", "team id, interned",                 (t6 - t5) * team_scale);
+
+        if (scanned_sum != interned_sum) report_failed_check("Interned team names didn't give the same ids!\n");
+    }
+
+    // Handles have to stay the same, and their text where it is, however many come after them.
+    {
+        Interned_String first = intern_string("Pool check");
+        char *first_text = get_string(first);
+
+        bool ok = intern_string("Pool check") == first && intern_string("Pool check ", 10) == first;
+        ok = ok && intern_string("Pool checK") != first;
+        ok = ok && intern_string("") == Interned_String{} && intern_string(NULL) == Interned_String{};
+
+        for (int i = 0; i < 100000; i++) {
+            char text[64];
+            int length = snprintf(text, sizeof(text), "Pool string %d", i);
+            Interned_String s = intern_string(text);
+            ok = ok && get_length(s) == length && get_hash(s) == hash(text) && strings_match(get_string(s), text);
+        }
+
+        Interned_String found;
+        ok = ok && find_interned_string("Pool string 500", &found) && strings_match(get_string(found), "Pool string 500");
+        ok = ok && !find_interned_string("Pool string -1", &found);
+        ok = ok && get_string(first) == first_text && intern_string("Pool check") == first;
+
+        if (!ok) report_failed_check("The string pool gave back the wrong strings!\n");
+    }
+}
+
+static void benchmark_arena() {
+    const int NUM_FRAMES = 20000;
+    const int STRINGS_PER_FRAME = 200; // About what a screen full of vacations prints.
+
+    s64 heap_length = 0, arena_length = 0;
+
+    // Every string of a frame from the heap and freed right away, the way draw.cpp did it.
+    double t0 = os_get_time();
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        for (int i = 0; i < STRINGS_PER_FRAME; i++) {
+            char *text = mprintf("От %d.%d.%dг. до %d.%d.%dг.", i % 28 + 1, frame % 12 + 1, 2024, i % 28 + 1, frame % 12 + 1, 2025);
+            heap_length += strlen(text);
+            delete [] text;
+        }
+    }
+    double t1 = os_get_time();
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        temporary_storage.reset();
+        for (int i = 0; i < STRINGS_PER_FRAME; i++) {
+            char *text = tprintf("От %d.%d.%dг. до %d.%d.%dг.", i % 28 + 1, frame % 12 + 1, 2024, i % 28 + 1, frame % 12 + 1, 2025);
+            arena_length += strlen(text);
+        }
+    }
+    double t2 = os_get_time();
+    temporary_storage.reset();
+
+    double scale = 1e9 / ((double)NUM_FRAMES * STRINGS_PER_FRAME);
+    log("%-34s %10s\n", "", "ns each");
+    log("%-34s %10.3f\n", "frame string, mprintf + delete", (t1 - t0) * scale);
+    log("%-34s %10.3f\n", "frame string, tprintf + reset",  (t2 - t1) * scale);
+
+    if (heap_length != arena_length) report_failed_check("tprintf didn't print the same as mprintf!\n");
+
+    // Strings that don't fit in what is left of the block, or in a block at all, get printed again.
+    {
+        const int LONG_LENGTH = 100000;
+        char *long_text = new char[LONG_LENGTH + 1];
+        defer { delete [] long_text; };
+        memset(long_text, 'x', LONG_LENGTH);
+        long_text[LONG_LENGTH] = 0;
+
+        bool ok = true;
+        for (int i = 0; i < 5000; i++) {
+            char *tail = long_text + (i % 1000 == 999 ? 0 : LONG_LENGTH); // Or just the 0 at the end.
+            char *text = tprintf("%d %s", i, tail);
+            char *expected = mprintf("%d %s", i, tail);
+            ok = ok && strings_match(text, expected);
+            delete [] expected;
+        }
+        temporary_storage.reset();
+
+        if (!ok) report_failed_check("tprintf cut a string short when it didn't fit!\n");
+    }
+
+    // Past the end of the first block, with things bigger than a block, and back to marks.
+    {
+        Memory_Arena arena;
+        arena.init(Kilobytes(64));
+        defer { arena.deinit(); };
+
+        bool ok = true;
+
+        Array <u32 *> small;
+        for (u32 i = 0; i < 100000; i++) {
+            u32 *p = (u32 *)arena.get(sizeof(u32) * 3);
+            ok = ok && p && ((uintptr_t)p % 16) == 0;
+            p[0] = i; p[1] = ~i; p[2] = i * 7;
+            small.add(p);
+        }
+
+        Arena_Mark mark = arena.mark();
+
+        u8 *big = (u8 *)arena.get(Megabytes(1));
+        ok = ok && big;
+        memset(big, 0xab, Megabytes(1));
+
+        for (u32 i = 0; i < small.count; i++) {
+            ok = ok && small[i][0] == i && small[i][1] == ~i && small[i][2] == i * 7;
+        }
+
+        // What comes after the mark lands where it did the first time, in the blocks that are kept.
+        arena.reset_to(mark);
+        u8 *again = (u8 *)arena.get(Megabytes(1));
+        ok = ok && again == big;
+
+        arena.reset_to(mark);
+        u32 *after_mark = (u32 *)arena.get(sizeof(u32) * 3);
+        ok = ok && small[small.count - 1][0] == small.count - 1;
+
+        int num_blocks = 0;
+        for (auto block = arena.first; block; block = block->next) num_blocks++;
+
+        arena.reset();
+        u32 *first = (u32 *)arena.get(sizeof(u32) * 3);
+        ok = ok && first == small[0];
+
+        int num_blocks_after_reset = 0;
+        for (auto block = arena.first; block; block = block->next) num_blocks_after_reset++;
+        ok = ok && num_blocks == num_blocks_after_reset && after_mark;
+
+        log("%-34s %10d\n", "64KB blocks for 1.6MB + a 1MB one", num_blocks);
+
+        if (!ok) report_failed_check("The arena gave back memory that wasn't where it should be!\n");
+    }
+}
+
+struct Benchmark {
+    char *name;
+    void (*proc)();
+};
+
+static Benchmark benchmarks[] = {
+    { "collisions", benchmark_collisions },
+    { "incremental_collisions", benchmark_incremental_collisions },
+    { "overlap_kernel", benchmark_overlap_kernel },
+    { "simd_overlap", benchmark_simd_overlap },
+    { "range_queries", benchmark_range_queries },
+    { "occupancy", benchmark_occupancy },
+    { "teams", benchmark_teams },
+    { "parallel_collisions", benchmark_parallel_collisions },
+    { "save_load", benchmark_save_load },
+    { "journal", benchmark_journal },
+    { "background_save", benchmark_background_save },
+    { "text_parse", benchmark_text_parse },
+    { "field_parse", benchmark_field_parse },
+    { "bulk_import", benchmark_bulk_import },
+    { "export", benchmark_export },
+    { "partitioned_load", benchmark_partitioned_load },
+    { "snapshot_recovery", benchmark_snapshot_recovery },
+    { "array", benchmark_array },
+    { "inline_array", benchmark_inline_array },
+    { "hash_table", benchmark_hash_table },
+    { "string_pool", benchmark_string_pool },
+    { "arena", benchmark_arena },
+};
+
+int run_benchmarks(int argc, char **argv) {
+    char *only = (argc > 0) ? argv[0] : NULL;
+
+    init_overlap_kernel();
+
+    bool found = false;
+    for (auto &benchmark : benchmarks) {
+        if (only && !strings_match(only, benchmark.name)) continue;
+        found = true;
+
+        log("\n[benchmark] %s\n", benchmark.name);
+        benchmark.proc();
+    }
+
+    if (!found) {
+        log_error("Unknown benchmark '%s'.\n", only);
+        return 1;
+    }
+
+    if (num_failed_checks) {
+        log_error("\n%d of the checks failed.\n", num_failed_checks);
+        return 1;
+    }
+    return 0;
+}
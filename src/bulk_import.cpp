@@ -0,0 +1,659 @@
+#include "pch.h"
+#include "bulk_import.h"
+#include "vacation.h"
+#include "save_file.h"
+#include "text_file_handler.h"
+#include "job_system.h"
+#include "os_specific.h"
+
+#include <limits.h>
+#include <string.h>
+
+// What a chunk gets parsed into. Names and teams are copied into the chunk's 'text',
+// since quotes and escapes have to come out of them, each with a 0 after it.
+struct Import_Row {
+    s32 start;
+    s32 end;
+
+    s32 name_offset;
+    s32 team_offset; // -1 if there is no team.
+};
+
+struct Import_Chunk {
+    String data;
+    int num_lines_before = 0; // In the whole file.
+
+    Array <Import_Row> rows;
+    Array <char> text;
+    int num_errors = 0;
+};
+
+enum Import_Format {
+    IMPORT_CSV,
+    IMPORT_ICS,
+};
+
+const int CSV_MAX_COLUMNS = 32;
+
+struct Csv_Columns {
+    char separator = ',';
+    int name = 0;
+    int from = 1;
+    int to   = 2;
+    int team = 3; // Optional; a line with fewer columns just has no team.
+};
+
+// Chunks are at least this big, so that small files don't get spread out for nothing.
+const s64 MIN_CHUNK_SIZE = 64 * 1024;
+
+static s32 add_text(Array <char> *text, String s, bool unescape_quotes) {
+    s32 offset = text->count;
+    text->add_n((int)s.count); // Room for all of it; unescaping only makes it shorter.
+    text->count = offset;
+
+    for (s64 i = 0; i < s.count; i++) {
+        if (unescape_quotes && s.data[i] == '"' && i + 1 < s.count && s.data[i + 1] == '"') i += 1;
+        text->data[text->count++] = s.data[i];
+    }
+    return offset;
+}
+
+static String trim(String s) {
+    return eat_trailing_spaces(eat_spaces(s));
+}
+
+static bool strings_match_ignoring_case(String a, char *b) {
+    for (s64 i = 0; i < a.count; i++) {
+        if (!b[i]) return false;
+
+        char ca = a.data[i], cb = b[i];
+        if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+        if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+        if (ca != cb) return false;
+    }
+    return b[a.count] == 0;
+}
+
+static bool matches_any(String s, char **names, int num_names) {
+    for (int i = 0; i < num_names; i++) {
+        if (strings_match_ignoring_case(s, names[i])) return true;
+    }
+    return false;
+}
+
+//
+// Dates
+//
+
+// YYYY-MM-DD, or YYYYMMDD like in .ics files.
+static bool parse_iso_date(String *s, Date *date) {
+    String at = *s;
+    int fields[3];
+    int lengths[3] = { 4, 2, 2 };
+
+    bool dashes = at.count > 4 && at.data[4] == '-';
+    for (int i = 0; i < 3; i++) {
+        if (i && dashes) {
+            if (!at.count || at.data[0] != '-') return false;
+            at = advance(at, 1);
+        }
+
+        if (at.count < lengths[i]) return false;
+
+        int value = 0;
+        for (int j = 0; j < lengths[i]; j++) {
+            if ((u8)(at.data[j] - '0') > 9) return false;
+            value = value * 10 + (at.data[j] - '0');
+        }
+        fields[i] = value;
+        at = advance(at, lengths[i]);
+    }
+
+    if (!is_valid_date(fields[2], fields[1], fields[0])) return false;
+
+    date->day   = fields[2];
+    date->month = fields[1];
+    date->year  = fields[0];
+    *s = at;
+    return true;
+}
+
+static bool parse_import_date(String field, s32 *day_number) {
+    Date date;
+
+    String at = field;
+    if (!parse_date(&at, &date) || at.count) {
+        at = field;
+        if (!parse_iso_date(&at, &date) || at.count) return false;
+    }
+
+    *day_number = date_to_day_number(date.day, date.month, date.year);
+    return true;
+}
+
+//
+// CSV
+//
+
+// Fields that were in quotes come back without them, but with any "" inside still doubled.
+// Returns how many fields there are, or -1 if a quote isn't closed.
+static int split_csv_line(String line, char separator, String *fields, bool *quoted, int max_fields) {
+    int num_fields = 0;
+    s64 at = 0;
+
+    while (num_fields < max_fields) {
+        while (at < line.count && (line.data[at] == ' ' || (line.data[at] == '\t' && separator != '\t'))) at += 1;
+
+        String field;
+        bool is_quoted = at < line.count && line.data[at] == '"';
+        if (is_quoted) {
+            s64 start = at + 1;
+            at = start;
+            while (true) {
+                if (at >= line.count) return -1;
+                if (line.data[at] == '"') {
+                    if (at + 1 < line.count && line.data[at + 1] == '"') { at += 2; continue; }
+                    break;
+                }
+                at += 1;
+            }
+            field = make_string(line.data + start, at - start);
+            at += 1;
+
+            while (at < line.count && line.data[at] != separator) at += 1; // Whatever is after the quote is dropped.
+        } else {
+            s64 start = at;
+            while (at < line.count && line.data[at] != separator) at += 1;
+            field = trim(make_string(line.data + start, at - start));
+        }
+
+        fields[num_fields] = field;
+        quoted[num_fields] = is_quoted;
+        num_fields += 1;
+
+        if (at >= line.count) break;
+        at += 1; // The separator.
+    }
+
+    return num_fields;
+}
+
+static char guess_csv_separator(String line) {
+    int num_commas = 0, num_semicolons = 0, num_tabs = 0;
+    bool in_quotes = false;
+    for (s64 i = 0; i < line.count; i++) {
+        char c = line.data[i];
+        if (c == '"') in_quotes = !in_quotes;
+        if (in_quotes) continue;
+
+        if (c == ',')  num_commas += 1;
+        if (c == ';')  num_semicolons += 1;
+        if (c == '\t') num_tabs += 1;
+    }
+
+    if (num_semicolons > num_commas && num_semicolons >= num_tabs) return ';';
+    if (num_tabs > num_commas) return '\t';
+    return ',';
+}
+
+// Returns true if 'line' is a header, and sets the columns from it.
+static bool read_csv_header(String line, Csv_Columns *columns) {
+    static char *name_names[] = { "name", "employee", "employee name", "име", "служител" };
+    static char *from_names[] = { "from", "start", "start date", "begin", "от", "начало" };
+    static char *to_names[]   = { "to", "end", "end date", "until", "до", "край" };
+    static char *team_names[] = { "team", "department", "group", "екип", "отдел" };
+
+    String fields[CSV_MAX_COLUMNS];
+    bool quoted[CSV_MAX_COLUMNS];
+    int num_fields = split_csv_line(line, columns->separator, fields, quoted, CSV_MAX_COLUMNS);
+
+    Csv_Columns header = *columns;
+    header.name = header.from = header.to = header.team = -1;
+
+    for (int i = 0; i < num_fields; i++) {
+        String field = trim(fields[i]);
+        if      (header.name < 0 && matches_any(field, name_names, ArrayCount(name_names))) header.name = i;
+        else if (header.from < 0 && matches_any(field, from_names, ArrayCount(from_names))) header.from = i;
+        else if (header.to   < 0 && matches_any(field, to_names,   ArrayCount(to_names)))   header.to   = i;
+        else if (header.team < 0 && matches_any(field, team_names, ArrayCount(team_names))) header.team = i;
+    }
+
+    if (header.name < 0 || header.from < 0 || header.to < 0) return false;
+
+    *columns = header;
+    return true;
+}
+
+static void parse_csv_chunk(Import_Chunk *chunk, Csv_Columns *columns, char *path) {
+    Text_File_Handler handler;
+    handler.do_version_number = false;
+    handler.strip_comments_from_end_of_lines = false;
+    handler.comment_character = 0; // No comments in CSV.
+    handler.start_memory(path, chunk->data.data, chunk->data.count, "import");
+    handler.line_number = chunk->num_lines_before;
+
+    int num_needed = Max(Max(columns->name, columns->from), columns->to) + 1;
+
+    while (true) {
+        String line = handler.consume_next_line();
+        if (!line.data) break;
+
+        String fields[CSV_MAX_COLUMNS];
+        bool quoted[CSV_MAX_COLUMNS];
+        int num_fields = split_csv_line(line, columns->separator, fields, quoted, CSV_MAX_COLUMNS);
+        if (num_fields < 0) {
+            handler.report_error("A quote isn't closed.");
+            chunk->num_errors += 1;
+            continue;
+        }
+
+        if (num_fields < num_needed) {
+            handler.report_error("Expected at least %d columns, but there are %d.", num_needed, num_fields);
+            chunk->num_errors += 1;
+            continue;
+        }
+
+        String name = fields[columns->name];
+        if (!name.count) {
+            handler.report_error("The name in column %d is empty.", columns->name + 1);
+            chunk->num_errors += 1;
+            continue;
+        }
+
+        Import_Row row = {};
+        row.team_offset = -1;
+        if (!parse_import_date(fields[columns->from], &row.start)) {
+            handler.report_error("Expected a date like 1.7.2024 or 2024-07-01 in column %d, but found '%.*s'.", columns->from + 1, (int)fields[columns->from].count, fields[columns->from].data);
+            chunk->num_errors += 1;
+            continue;
+        }
+        if (!parse_import_date(fields[columns->to], &row.end)) {
+            handler.report_error("Expected a date like 1.7.2024 or 2024-07-01 in column %d, but found '%.*s'.", columns->to + 1, (int)fields[columns->to].count, fields[columns->to].data);
+            chunk->num_errors += 1;
+            continue;
+        }
+        if (row.end < row.start) {
+            handler.report_error("The vacation ends before it starts.");
+            chunk->num_errors += 1;
+            continue;
+        }
+
+        row.name_offset = add_text(&chunk->text, name, quoted[columns->name]);
+        chunk->text.add(0);
+
+        if (columns->team >= 0 && columns->team < num_fields && fields[columns->team].count) {
+            row.team_offset = add_text(&chunk->text, fields[columns->team], quoted[columns->team]);
+            chunk->text.add(0);
+        }
+
+        chunk->rows.add(row);
+    }
+}
+
+//
+// iCalendar
+//
+
+// Undoes \, \; \\ and \n in a value; line breaks become spaces.
+static s32 add_ics_text(Array <char> *text, String s) {
+    s32 offset = text->count;
+    text->add_n((int)s.count); // Room for all of it; unescaping only makes it shorter.
+    text->count = offset;
+
+    for (s64 i = 0; i < s.count; i++) {
+        char c = s.data[i];
+        if (c == '\\' && i + 1 < s.count) {
+            i += 1;
+            c = s.data[i];
+            if (c == 'n' || c == 'N') c = ' ';
+        }
+        text->data[text->count++] = c;
+    }
+    return offset;
+}
+
+// The date of a DTSTART or DTEND value: YYYYMMDD, maybe followed by THHMMSS and a Z.
+static bool parse_ics_date(String value, s32 *day_number, bool *has_time) {
+    Date date;
+    if (!parse_iso_date(&value, &date)) return false;
+
+    *has_time = false;
+    if (value.count) {
+        if (value.data[0] != 'T') return false;
+        for (s64 i = 1; i < value.count; i++) {
+            if (value.data[i] != '0' && value.data[i] != 'Z') *has_time = true;
+        }
+    }
+
+    *day_number = date_to_day_number(date.day, date.month, date.year);
+    return true;
+}
+
+struct Ics_Event {
+    int first_line;
+
+    String summary;
+    String category;
+    s32 start, end;
+    bool has_start, has_end;
+    bool failed;
+};
+
+static void handle_ics_property(Text_File_Handler *handler, Import_Chunk *chunk, Ics_Event *event, bool *in_event, String property, int line_number) {
+    s64 colon = 0;
+    while (colon < property.count && property.data[colon] != ':') colon += 1;
+    if (colon == property.count) return; // Not something we know.
+
+    s64 name_end = 0;
+    while (name_end < colon && property.data[name_end] != ';') name_end += 1;
+
+    String name  = make_string(property.data, name_end);
+    String value = advance(property, colon + 1);
+
+    if (strings_match(name, "BEGIN")) {
+        if (strings_match(value, "VEVENT")) {
+            *event = {};
+            event->first_line = line_number;
+            *in_event = true;
+        }
+        return;
+    }
+
+    if (!*in_event) return;
+
+    if (strings_match(name, "END")) {
+        if (!strings_match(value, "VEVENT")) return;
+        *in_event = false;
+        if (event->failed) return;
+
+        if (!event->summary.count || !event->has_start) {
+            handler->report_error_at(event->first_line, "The event has no %s.", event->summary.count ? "DTSTART" : "SUMMARY");
+            chunk->num_errors += 1;
+            return;
+        }
+
+        Import_Row row = {};
+        row.team_offset = -1;
+        row.start = event->start;
+        row.end   = event->has_end ? event->end : event->start + 1; // Like an all day event.
+        if (row.end < row.start) {
+            handler->report_error_at(event->first_line, "The event ends before it starts.");
+            chunk->num_errors += 1;
+            return;
+        }
+
+        row.name_offset = add_ics_text(&chunk->text, event->summary);
+        chunk->text.add(0);
+
+        if (event->category.count) {
+            row.team_offset = add_ics_text(&chunk->text, event->category);
+            chunk->text.add(0);
+        }
+
+        chunk->rows.add(row);
+    } else if (strings_match(name, "SUMMARY")) {
+        event->summary = trim(value);
+    } else if (strings_match(name, "CATEGORIES")) {
+        s64 comma = 0;
+        while (comma < value.count && !(value.data[comma] == ',' && (comma == 0 || value.data[comma - 1] != '\\'))) comma += 1;
+        event->category = trim(make_string(value.data, comma));
+    } else if (strings_match(name, "DTSTART") || strings_match(name, "DTEND")) {
+        bool is_start = name.count == 7;
+
+        s32 day_number;
+        bool has_time;
+        if (!parse_ics_date(value, &day_number, &has_time)) {
+            handler->report_error_at(line_number, "Expected a date like 20240701 in %.*s, but found '%.*s'.", (int)name.count, name.data, (int)value.count, value.data);
+            chunk->num_errors += 1;
+            event->failed = true;
+            return;
+        }
+
+        if (is_start) {
+            event->start = day_number;
+            event->has_start = true;
+        } else {
+            // The end of an all day event is already the day after; one that ends during
+            // the day still takes that day.
+            event->end = has_time ? day_number + 1 : day_number;
+            event->has_end = true;
+        }
+    }
+}
+
+static void parse_ics_chunk(Import_Chunk *chunk, char *path) {
+    Text_File_Handler handler;
+    handler.do_version_number = false;
+    handler.strip_comments_from_end_of_lines = false;
+    handler.comment_character = 0;
+    handler.eat_spaces_before_line = false; // A leading space means the line goes on from the one before.
+    handler.start_memory(path, chunk->data.data, chunk->data.count, "import");
+    handler.line_number = chunk->num_lines_before;
+
+    Ics_Event event = {};
+    bool in_event = false;
+
+    // Lines that are folded are put back together here. Values that aren't are used as
+    // they are, since the lines of a chunk in memory stay where they are.
+    Array <char> unfolded;
+    String property = {};
+    int property_line = 0;
+
+    while (true) {
+        String line = handler.consume_next_line();
+
+        if (line.data && (line.data[0] == ' ' || line.data[0] == '\t')) {
+            if (property.data != unfolded.data) {
+                unfolded.count = 0;
+                add_text(&unfolded, property, false);
+            }
+            add_text(&unfolded, advance(line, 1), false);
+            property = make_string(unfolded.data, unfolded.count);
+            continue;
+        }
+
+        if (property.data) handle_ics_property(&handler, chunk, &event, &in_event, property, property_line);
+        if (!line.data) break;
+
+        property = line;
+        property_line = handler.line_number;
+    }
+
+    if (in_event) {
+        handler.report_error_at(event.first_line, "The event doesn't end.");
+        chunk->num_errors += 1;
+    }
+}
+
+//
+// Splitting the file up
+//
+
+static Import_Format guess_format(char *path, String data) {
+    char *dot = strrchr(path, '.');
+    if (dot && strings_match_ignoring_case(make_string(dot), ".ics")) return IMPORT_ICS;
+    if (starts_with(data, "BEGIN:VCALENDAR")) return IMPORT_ICS;
+    return IMPORT_CSV;
+}
+
+// Where the chunk that would start at 'at' really starts: after the end of the line,
+// and for .ics files, at the start of an event, so that no event is split up.
+static char *find_chunk_start(char *at, char *end, Import_Format format) {
+    while (at < end) {
+        char *line_break = (char *)memchr(at, '\n', end - at);
+        if (!line_break) return end;
+
+        at = line_break + 1;
+        if (format == IMPORT_CSV) return at;
+        if (starts_with(make_string(at, end - at), "BEGIN:VEVENT")) return at;
+    }
+    return end;
+}
+
+static int count_lines(String data) {
+    int num_lines = 0;
+    char *at  = data.data;
+    char *end = data.data + data.count;
+    while (at < end) {
+        char *line_break = (char *)memchr(at, '\n', end - at);
+        if (!line_break) break;
+
+        num_lines += 1;
+        at = line_break + 1;
+    }
+    return num_lines;
+}
+
+//
+// Putting it all in
+//
+
+static bool is_already_there(Employee *employee, s32 start, s32 end, Array <New_Vacation> *vacations, Array <int> *next_of_same_employee, int last_added) {
+    int first = employee->first_vacation;
+    for (int row = first; row < first + employee->num_vacations; row++) {
+        if (vacation_store.start_day[row] == start && vacation_store.end_day[row] == end) return true;
+    }
+
+    for (int i = last_added; i >= 0; i = (*next_of_same_employee)[i]) {
+        auto vacation = &(*vacations)[i];
+        if (vacation->start == start && vacation->end == end) return true;
+    }
+    return false;
+}
+
+static void merge_chunks(Array <Import_Chunk> *chunks, Bulk_Import_Result *result) {
+    begin_batched_changes();
+
+    // A duplicate starts on the same day, so its year has to be loaded to be found.
+    s32 earliest = INT_MAX, latest = INT_MIN;
+    for (auto &chunk : *chunks) {
+        for (auto row : chunk.rows) {
+            earliest = Min(earliest, row.start);
+            latest   = Max(latest, row.start);
+        }
+    }
+    if (earliest != INT_MAX) load_vacations_near(earliest, latest, earliest);
+
+    String_Hash_Table <int> employee_ids;
+    defer { employee_ids.deinit(); };
+    for (auto employee : all_employees) employee_ids.add(employee->name, employee->id);
+
+    Array <New_Vacation> vacations;
+    Array <int> next_of_same_employee; // The vacation added before it for the same employee, or -1.
+    Array <int> last_added;            // Per employee; the last of its vacations in 'vacations'.
+    last_added.resize(all_employees.count);
+    for (int &i : last_added) i = -1;
+
+    for (auto &chunk : *chunks) {
+        for (auto row : chunk.rows) {
+            char *name = chunk.text.data + row.name_offset;
+
+            Employee *employee;
+            int *id = employee_ids.find(name);
+            if (id) {
+                employee = all_employees[*id];
+            } else {
+                employee = add_employee(name);
+                employee_ids.add(employee->name, employee->id);
+                last_added.add(-1);
+                result->num_new_employees += 1;
+            }
+
+            if (row.team_offset >= 0) {
+                char *team = chunk.text.data + row.team_offset;
+                if (!strings_match(get_team_name(employee->team_id), team)) set_employee_team(employee, team);
+            }
+
+            if (is_already_there(employee, row.start, row.end, &vacations, &next_of_same_employee, last_added[employee->id])) {
+                result->num_duplicates += 1;
+                continue;
+            }
+
+            vacations.add(New_Vacation{ employee->id, row.start, row.end });
+            next_of_same_employee.add(last_added[employee->id]);
+            last_added[employee->id] = vacations.count - 1;
+        }
+    }
+
+    add_vacations(&vacations);
+    result->num_added = vacations.count;
+
+    end_batched_changes();
+}
+
+bool bulk_import(char *path, Bulk_Import_Result *result) {
+    Bulk_Import_Result local_result;
+    if (!result) result = &local_result;
+    *result = {};
+
+    File_View view;
+    if (!os_open_file_view(path, &view)) {
+        log_error("[import] Unable to open '%s'.\n", path);
+        return false;
+    }
+    defer { os_close_file_view(&view); };
+
+    String data = make_string((char *)view.data, view.size);
+    if (starts_with(data, "\xEF\xBB\xBF")) data = advance(data, 3); // The UTF-8 byte order mark Excel likes to put in.
+
+    auto format = guess_format(path, data);
+
+    // The header goes before any of the chunks.
+    Csv_Columns columns;
+    int num_header_lines = 0;
+    if (format == IMPORT_CSV) {
+        char *line_break = (char *)memchr(data.data, '\n', data.count);
+        String first_line = make_string(data.data, line_break ? line_break - data.data : data.count);
+        columns.separator = guess_csv_separator(first_line);
+
+        if (read_csv_header(first_line, &columns)) {
+            data = advance(data, first_line.count + (line_break ? 1 : 0));
+            num_header_lines = 1;
+        }
+    }
+
+    Array <Import_Chunk> chunks;
+    {
+        int max_chunks = get_job_system_thread_count() * 4;
+        s64 chunk_size = Max(MIN_CHUNK_SIZE, data.count / max_chunks + 1);
+
+        char *end = data.data + data.count;
+        char *at  = data.data;
+        while (at < end) {
+            char *next = (end - at > chunk_size) ? find_chunk_start(at + chunk_size - 1, end, format) : end;
+
+            Import_Chunk *chunk = chunks.add();
+            chunk->data = make_string(at, next - at);
+            at = next;
+        }
+    }
+
+    // Errors are reported with their line in the whole file, so the chunks have to know
+    // where they start.
+    run_jobs(chunks.count, [&](int index) {
+        chunks[index].num_lines_before = count_lines(chunks[index].data);
+    });
+    int num_lines = num_header_lines;
+    for (auto &chunk : chunks) {
+        int num_in_chunk = chunk.num_lines_before;
+        chunk.num_lines_before = num_lines;
+        num_lines += num_in_chunk;
+    }
+
+    run_jobs(chunks.count, [&](int index) {
+        if (format == IMPORT_CSV) parse_csv_chunk(&chunks[index], &columns, path);
+        else                      parse_ics_chunk(&chunks[index], path);
+    });
+
+    for (auto &chunk : chunks) {
+        result->num_read   += chunk.rows.count;
+        result->num_errors += chunk.num_errors;
+    }
+
+    merge_chunks(&chunks, result);
+
+    log("[import] '%s': %d vacations read, %d added, %d already there, %d new employees, %d errors.\n",
+        path, result->num_read, result->num_added, result->num_duplicates, result->num_new_employees, result->num_errors);
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+//
+// Brings in vacations from what HR exports, instead of typing them in one by one:
+//
+//     CSV:  name, from, to and optionally team, one vacation per line, separated by ',', ';'
+//           or tabs. A header line, if there is one, says which column is which.
+//           Dates are D.M.Y or YYYY-MM-DD.
+//     .ics: one VEVENT per vacation. SUMMARY is the name, DTSTART and DTEND the dates,
+//           and the first of CATEGORIES, if there is one, the team.
+//
+// Employees are matched by name, and added if there is nobody with that name yet.
+// Vacations the employee already has are skipped, so importing the same file twice
+// doesn't add anything the second time. Lines that can't be read are reported and
+// skipped.
+//
+// The file is split into chunks that are parsed on the job system, and then everything
+// goes in at once, with one collision rebuild at the end.
+//
+
+struct Bulk_Import_Result {
+    int num_read = 0;          // Vacations read from the file.
+    int num_errors = 0;        // Lines or events that were reported and skipped.
+    int num_new_employees = 0;
+    int num_added = 0;
+    int num_duplicates = 0;    // Already there, or in the file more than once.
+};
+
+bool bulk_import(char *path, Bulk_Import_Result *result = NULL);
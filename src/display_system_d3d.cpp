@@ -2,8 +2,8 @@
 #include "display_system_d3d.h"
 #include "os_specific.h"
 #include "resource.h"
+#include "text_file_handler.h"
 
-#include <stdio.h> // For sscanf
 #include <stdlib.h> // For exit.
 #include <string.h> // For strlen.
 
@@ -523,25 +523,27 @@ void Display_System_D3D::immediate_quad(Vector2 p0, Vector2 p1, Vector2 p2, Vect
     num_immediate_vertices += 6;
 }
 
-static bool parse_shader_options(Shader_Options *options, char *file_data) {
+static bool parse_shader_options(Shader_Options *options, char *filepath, char *file_data, s64 file_size) {
     Array <Sampler_State> sampler_states;
+
+    Text_File_Handler handler;
+    handler.do_version_number = false;
+    handler.strip_comments_from_end_of_lines = false;
+    handler.start_memory(filepath, file_data, file_size, "shader");
     
     while (1) {
-        char *line = consume_next_line(&file_data);
-        if (!line) break;
-
-        line = eat_spaces(line);
-        line = eat_trailing_spaces(line);
+        String line = handler.consume_next_line();
+        if (!line.data) break;
 
         if (starts_with(line, "depth_test")) {
-            line += strlen("depth_test");
+            line = advance(line, strlen("depth_test"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after depth_test");
                 return false;
             }
-            line += 1;
+            line = advance(line, 1);
 
             line = eat_spaces(line);
 
@@ -550,21 +552,21 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
             } else if (strings_match(line, "lequal")) {
                 options->depth_test = DEPTH_TEST_LEQUAL;
             } else {
-                log_error("depth_test mode '%s' not supported\n", line);
+                log_error("depth_test mode '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    off\n");
                 log_error("    lequal\n");
                 return false;
             }
         } else if (starts_with(line, "depth_write")) {
-            line += strlen("depth_write");
+            line = advance(line, strlen("depth_write"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after depth_write");
                 return false;
             }
-            line += 1;
+            line = advance(line, 1);
             
             line = eat_spaces(line);
             
@@ -573,21 +575,21 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
             } else if (strings_match(line, "true")) {
                 options->depth_write = true;
             } else {
-                log_error("depth_write mode '%s' not supported\n", line);
+                log_error("depth_write mode '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    false\n");
                 log_error("    true\n");
                 return false;
             }
         } else if (starts_with(line, "blend")) {
-            line += strlen("blend");
+            line = advance(line, strlen("blend"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after blend");
                 return false;
             }
-            line += 1;
+            line = advance(line, 1);
             
             line = eat_spaces(line);
             
@@ -598,7 +600,7 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
             } else if (strings_match(line, "dual")) {
                 options->blend_type = BLEND_TYPE_DUAL;
             } else {
-                log_error("blend mode '%s' not supported\n", line);
+                log_error("blend mode '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    none\n");
                 log_error("    alpha\n");
@@ -606,14 +608,14 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
                 return false;
             }
         } else if (starts_with(line, "cull_mode")) {
-            line += strlen("cull_mode");
+            line = advance(line, strlen("cull_mode"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after cull_mode");
                 return false;
             }
-            line += 1;
+            line = advance(line, 1);
 
             line = eat_spaces(line);
 
@@ -624,7 +626,7 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
             } else if (strings_match(line, "front")) {
                 options->cull_mode = CULL_MODE_FRONT;
             } else {
-                log_error("cull_mode mode '%s' not supported\n", line);
+                log_error("cull_mode mode '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    off\n");
                 log_error("    back\n");
@@ -632,53 +634,56 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
                 return false;
             }
         } else if (starts_with(line, "vertex_type")) {
-            line += strlen("vertex_type");
+            line = advance(line, strlen("vertex_type"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after vertex_type");
                 return false;
             }
 
-            line += 1;
+            line = advance(line, 1);
 
             line = eat_spaces(line);
 
             if (strings_match(line, "immediate")) {
                 options->vertex_type = VERTEX_TYPE_IMMEDIATE;
             } else {
-                log_error("vertex_type mode '%s' not supported\n", line);
+                log_error("vertex_type mode '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    immediate\n");
                 return false;
             }
         } else if (starts_with(line, "sampler")) {
-            line += strlen("sampler");
+            line = advance(line, strlen("sampler"));
             line = eat_spaces(line);
 
-            if (line[0] != '=') {
+            if (!line.count || line.data[0] != '=') {
                 log_error("Expected '=' after sampler");
                 return false;
             }
 
-            line += 1;
+            line = advance(line, 1);
 
             line = eat_spaces(line);
 
-            char texture_filter_string[4096], texture_address_string[4096];
-            int res = sscanf(line, "%4095[^/]/%4095[^/]", texture_filter_string, texture_address_string); // Very weird syntax.
-            if (res != 2) {
-                log_error("Expected filter/address after sampler =, but instead found: %s.\n", line);
+            s64 slash = 0;
+            while (slash < line.count && line.data[slash] != '/') slash += 1;
+            if (slash == 0 || slash >= line.count - 1) {
+                log_error("Expected filter/address after sampler =, but instead found: %.*s.\n", (int)line.count, line.data);
                 return false;
             }
 
+            String texture_filter_string  = eat_trailing_spaces(make_string(line.data, slash));
+            String texture_address_string = eat_spaces(advance(line, slash + 1));
+
             Texture_Filter texture_filter = TEXTURE_FILTER_LINEAR;
             if (strings_match(texture_filter_string, "linear")) {
                 texture_filter = TEXTURE_FILTER_LINEAR;
             } else if (strings_match(texture_filter_string, "point")) {
                 texture_filter = TEXTURE_FILTER_POINT;
             } else {
-                log_error("texture filter '%s' not supported\n", line);
+                log_error("texture filter '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    linear\n");
                 log_error("    point\n");
@@ -691,7 +696,7 @@ static bool parse_shader_options(Shader_Options *options, char *file_data) {
             } else if (strings_match(texture_address_string, "clamp")) {
                 texture_address = TEXTURE_ADDRESS_CLAMP;
             } else {
-                log_error("texture address '%s' not supported\n", line);
+                log_error("texture address '%.*s' not supported\n", (int)line.count, line.data);
                 log_error("Valid values are:\n");
                 log_error("    repeat\n");
                 log_error("    clamp\n");
@@ -728,7 +733,8 @@ static D3D11_COMPARISON_FUNC d3d11_depth_func(Depth_Test mode) {
 }
 
 bool Display_System_D3D::load_shader(Shader *_shader, char *filepath) {
-    char *orig_file_data = os_read_entire_file(filepath);
+    s64 file_size = 0;
+    char *orig_file_data = os_read_entire_file(filepath, &file_size);
     if (!orig_file_data) {
         log_error("Failed to read file '%s'.\n", filepath);
         return false;
@@ -737,7 +743,7 @@ bool Display_System_D3D::load_shader(Shader *_shader, char *filepath) {
 
     ID3DBlob *vertex_code = NULL, *vertex_error = NULL;
     defer { SafeRelease(vertex_code); SafeRelease(vertex_error); };
-    D3DCompile(orig_file_data, strlen(orig_file_data), filepath, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "vertex_main", "vs_5_0", 0, 0, &vertex_code, &vertex_error);
+    D3DCompile(orig_file_data, file_size, filepath, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "vertex_main", "vs_5_0", 0, 0, &vertex_code, &vertex_error);
     if (vertex_error) {
         log_error("Failed to compile '%s' vertex shader:\n%s\n", filepath, (char *)vertex_error->GetBufferPointer());
         return false;
@@ -747,7 +753,7 @@ bool Display_System_D3D::load_shader(Shader *_shader, char *filepath) {
 
     ID3DBlob *pixel_code = NULL, *pixel_error = NULL;
     defer { SafeRelease(pixel_code); SafeRelease(pixel_error); };
-    D3DCompile(orig_file_data, strlen(orig_file_data), filepath, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "pixel_main", "ps_5_0", 0, 0, &pixel_code, &pixel_error);
+    D3DCompile(orig_file_data, file_size, filepath, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "pixel_main", "ps_5_0", 0, 0, &pixel_code, &pixel_error);
     if (pixel_error) {
         log_error("Failed to compile '%s' pixel shader:\n%s\n", filepath, (char *)pixel_error->GetBufferPointer());
         return false;
@@ -755,9 +761,8 @@ bool Display_System_D3D::load_shader(Shader *_shader, char *filepath) {
     ID3D11PixelShader *pixel_shader = NULL;
     device->CreatePixelShader(pixel_code->GetBufferPointer(), pixel_code->GetBufferSize(), NULL, &pixel_shader);
 
-    char *file_data = orig_file_data;
     Shader_Options options = {};
-    if (!parse_shader_options(&options, file_data)) return false;
+    if (!parse_shader_options(&options, filepath, orig_file_data, file_size)) return false;
     
     Array <D3D11_INPUT_ELEMENT_DESC> ieds;
     switch (options.vertex_type) {
@@ -4,6 +4,7 @@
 #include "hud.h"
 #include "os_specific.h"
 #include "vacation.h"
+#include "save_file.h"
 #include "text_input.h"
 
 #include "shader_catalog.h"
@@ -22,9 +23,14 @@ static float bottom_y_after_drawing = 0.0f;
 
 static float scroll_delta_speed = 20.0f;
 
+// Looked up every frame, so they are interned once, here.
+static Interned_String font_name = intern_string("OpenSans-Regular");
+static Interned_String white_texture_name = intern_string("white");
+
 enum Employee_Name_State {
     EMPLOYEE_NAME_FOR_ADDING,
     EMPLOYEE_NAME_FOR_RENAMING,
+    EMPLOYEE_NAME_FOR_TEAM,
 };
 
 static Text_Input employee_name_text_input;
@@ -44,11 +50,12 @@ enum Vacation_Edit_Type {
 
 static Vacation_Edit_Type vacation_edit_type = VACATION_EDIT_NONE;
 static bool show_all_vacations_for_current_employee;
-static Vacation_Info *current_vacation_info_to_edit = NULL;
+static int current_vacation_index_to_edit = -1;
 
 static char *right_click_options[] = {
     "Премахни",
     "Преименувай",
+    "Смени екипа",
     "Добави отпуска",
     "Промени отпуска",
     "Премахни отпуска",
@@ -122,7 +129,7 @@ static void calculate_right_click_bounds(int mx, int my) {
     right_click_y -= offset_y;
     
     int font_size = (int)(0.025f * sys->offscreen_buffer->height);
-    auto font = get_font_at_size("OpenSans-Regular", font_size);
+    auto font = get_font_at_size(font_name, font_size);
 
     char *largest_text = select_longest_right_click_options_text();    
     
@@ -286,7 +293,7 @@ void init_shaders() {
     // Calculate right_click_height before calculate_right_click_bounds is called,
     // so that we can properly clamp draw_y_offset_due_to_scrolling.
     int font_size = (int)(0.025f * sys->offscreen_buffer->height);
-    auto font = get_font_at_size("OpenSans-Regular", font_size);
+    auto font = get_font_at_size(font_name, font_size);
     right_click_height = (font->character_height * 2) * ArrayCount(right_click_options);
 }
 
@@ -446,7 +453,13 @@ void draw_text(Dynamic_Font *font, char *text, int x, int y, Vector4 color) {
 }
 
 static char *get_longest_employee_name() {
-    char *longest = NULL;
+    static char *longest = NULL;
+    static u64 longest_generation = 0;
+
+    if (longest_generation == vacation_data_generation) return longest;
+    longest_generation = vacation_data_generation;
+    
+    longest = NULL;
     int longest_length = 0;
     
     for (auto employee : all_employees) {
@@ -464,9 +477,13 @@ static char *get_longest_vacation_name(Employee *employee) {
     char longest[4096] = {};
     int longest_length = 0;
     
-    for (auto info : employee->vacations) {
+    int first = employee->first_vacation;
+    for (int row = first; row < first + employee->num_vacations; row++) {
+        Date from = day_number_to_date(vacation_store.start_day[row]);
+        Date to   = day_number_to_date(vacation_store.end_day[row]);
+        
         char text[4096];
-        snprintf(text, sizeof(text), "От %d.%d.%dг. до %d.%d.%dг.", info.from_day, info.from_month, info.from_year, info.to_day, info.to_month, info.to_year);
+        snprintf(text, sizeof(text), "От %d.%d.%dг. до %d.%d.%dг.", from.day, from.month, from.year, to.day, to.month, to.year);
         
         int name_length = string_length_unicode(employee->name);
         if (name_length > longest_length) {
@@ -475,7 +492,24 @@ static char *get_longest_vacation_name(Employee *employee) {
         }
     }
     
-    return copy_string(longest);
+    return tprintf("%s", longest);
+}
+
+// The years that weren't loaded at startup, a year per click, going back. Returns
+// false if everything is loaded already, and there is no button.
+static bool do_older_vacations_button(Dynamic_Font *font, int x, int y, int width, int height, bool bypasses_occlusion) {
+    int year = get_newest_unloaded_year();
+    if (!year) return false;
+
+    char *text = tprintf("Покажи отпуските от %dг.", year);
+
+    width = Max(width, font->get_text_width(text) + font->character_height);
+
+    auto state = do_button(font, text, x, y, width, height, default_button_theme, bypasses_occlusion);
+    if (state == Button_State::LEFT_PRESSED) {
+        load_vacations_starting_from(date_to_day_number(1, 1, year));
+    }
+    return true;
 }
 
 static void draw_all_vacations() {
@@ -494,9 +528,9 @@ static void draw_all_vacations() {
     auto employee = currently_right_clicked_employee;
     assert(employee);
 
-    if (employee->vacations.count == 0) {
+    if (employee->num_vacations == 0) {
         int font_size = (int)(0.025f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
 
         int start_y = sys->target_height - 2*font->character_height;
         int y = start_y;
@@ -533,10 +567,9 @@ static void draw_all_vacations() {
     }
     
     char *longest_name = get_longest_vacation_name(employee);
-    defer { delete [] longest_name; };
 
     int font_size = (int)(0.025f * sys->target_height);
-    auto font = get_font_at_size("OpenSans-Regular", font_size);
+    auto font = get_font_at_size(font_name, font_size);
 
     int start_y = sys->target_height - 2*font->character_height;
     
@@ -566,11 +599,12 @@ static void draw_all_vacations() {
         y -= font->character_height;
     }
 
-    for (int i = 0; i < employee->vacations.count; i++) {
-        auto info = &employee->vacations[i];
+    for (int i = 0; i < employee->num_vacations; i++) {
+        int row = employee->first_vacation + i;
+        Date from = day_number_to_date(vacation_store.start_day[row]);
+        Date to   = day_number_to_date(vacation_store.end_day[row]);
         
-        char *text = mprintf("От %d.%d.%dг. до %d.%d.%dг.", info->from_day, info->from_month, info->from_year, info->to_day, info->to_month, info->to_year);
-        defer { delete [] text; };
+        char *text = tprintf("От %d.%d.%dг. до %d.%d.%dг.", from.day, from.month, from.year, to.day, to.month, to.year);
 
         auto theme = default_button_theme; // @TODO: Edit this
         auto state = do_button(font, text, x, y, width, height, theme, true);
@@ -578,30 +612,31 @@ static void draw_all_vacations() {
             switch (vacation_edit_type) {
                 case VACATION_EDIT_DATE: {
                     disable_show_all_vacations(false);
-                    current_vacation_info_to_edit = info;
+                    current_vacation_index_to_edit = i;
                     
                     enable_employee_info_text_input();
                     
-                    char *from_text = mprintf("%d.%d.%d", info->from_day, info->from_month, info->from_year); // @Leak
+                    char *from_text = tprintf("%d.%d.%d", from.day, from.month, from.year);
                     vacation_info_from_text_input.add_text(from_text);
                     
-                    char *to_text = mprintf("%d.%d.%d", info->to_day, info->to_month, info->to_year); // @Leak
+                    char *to_text = tprintf("%d.%d.%d", to.day, to.month, to.year);
                     vacation_info_to_text_input.add_text(to_text);
                 } break;
 
                 case VACATION_EDIT_REMOVE: {
                     disable_show_all_vacations(true);
                     
-                    int info_index = employee->vacations.find(*info);
-                    if (info_index != -1) {
-                        employee->vacations.ordered_remove_by_index(info_index);
-                    }
+                    employee->remove_vacation_info(i);
                 } break;
             }
         }
 
         y -= height;
     }
+
+    if (do_older_vacations_button(font, x, y, width, height, true)) {
+        y -= height;
+    }
 }
 
 static void draw_hud() {
@@ -641,7 +676,7 @@ static void draw_hud() {
         */
         
         int font_size = (int)(0.025f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
         int x = 0;
         int y = sys->target_height - font->character_height;
         
@@ -651,6 +686,16 @@ static void draw_hud() {
         draw_text(font, text, x+offset, y-offset, Vector4(1, 1, 1, 1));
         draw_text(font, text, x, y, text_color);
 
+        // How long the last frames took to build, without waiting for vsync, and how long the
+        // last autosave held up the frame it started in.
+        char frame_time_text[128];
+        snprintf(frame_time_text, sizeof(frame_time_text), "Кадър: %.2f мс  Запис: %.2f мс",
+                 globals.time_info.average_frame_work_time * 1000.0, globals.time_info.save_blocking_time * 1000.0);
+
+        x += font->get_text_width(text) + font->character_height;
+        draw_text(font, frame_time_text, x+offset, y-offset, Vector4(1, 1, 1, 1));
+        draw_text(font, frame_time_text, x, y, Vector4(0, 0, 0, 1));
+
         start_y -= font->character_height * 2;
         start_y -= font->character_height / 2;
     }
@@ -660,7 +705,7 @@ static void draw_hud() {
     //
     {
         int font_size = (int)(0.025f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
         
         char *text = "Добави служител";
         //int offset = (int)(0.025f * sys->target_height);
@@ -683,7 +728,7 @@ static void draw_hud() {
     //
     {
         int font_size = (int)(0.025f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
 
         //int pad = (int)(0.0025f * sys->target_height);
         int pad = 0;
@@ -692,18 +737,33 @@ static void draw_hud() {
         int y = start_y;
         
         char *longest_name = get_longest_employee_name();
+        int text_width = font->get_text_width(longest_name);
+
+        // Only what is on screen gets drawn, so that the cost of a frame doesn't grow with the roster.
+        int visible_y0 = -(int)draw_y_offset_due_to_scrolling;
+        int visible_y1 = visible_y0 + sys->target_height;
+
+        int line_height = font->character_height - font->typical_descender;
         
         int offset = font->character_height / 40;
         for (auto employee : all_employees) {
             char *text = employee->name;
             
-            int text_width = font->get_text_width(longest_name);
-            
             int width  = text_width * 2;
             int height = font->character_height * 2;
             
             int x0 = x;
             int y0 = y - height;
+
+            int block_height = height;
+            if (employee->draw_all_vacations_on_hud) {
+                block_height += Max(employee->num_vacations, 1) * line_height;
+            }
+
+            if ((y - block_height > visible_y1) || (y < visible_y0)) {
+                y -= block_height;
+                continue;
+            }
             
             auto theme = default_button_theme;
             theme.allow_right_clicks = true;
@@ -719,7 +779,7 @@ static void draw_hud() {
             
             auto state = do_button(font, text, x0, y0, width, height, theme);
             if (state == Button_State::LEFT_PRESSED) {
-                employee->draw_all_vacations_on_hud = !employee->draw_all_vacations_on_hud;
+                set_employee_shown_on_hud(employee, !employee->draw_all_vacations_on_hud);
                 disable_right_click_options();
             } else if (state == Button_State::RIGHT_PRESSED) {
                 enable_right_click_options(employee);
@@ -729,7 +789,7 @@ static void draw_hud() {
 
             if (!employee->draw_all_vacations_on_hud) continue;
 
-            if (employee->vacations.count == 0) {
+            if (employee->num_vacations == 0) {
                 char *text = "Няма добавени отпуски";
 
                 y0 = y - font->character_height;
@@ -737,25 +797,38 @@ static void draw_hud() {
                 Vector4 color(0, 0, 0, 1);
                 draw_text(font, text, x0, y0, color);
 
-                y -= font->character_height - font->typical_descender;
+                y -= line_height;
             } else {
-                for (auto info : employee->vacations) {
-                    char *text = mprintf("От %d.%d.%dг. до %d.%d.%dг.", info.from_day, info.from_month, info.from_year, info.to_day, info.to_month, info.to_year);
-                    defer { delete [] text; };
-
+                int first = employee->first_vacation;
+                for (int row = first; row < first + employee->num_vacations; row++) {
                     y0 = y - font->character_height;
                     
+                    if ((y0 > visible_y1) || (y < visible_y0)) {
+                        y -= line_height;
+                        continue;
+                    }
+                    
+                    Date from = day_number_to_date(vacation_store.start_day[row]);
+                    Date to   = day_number_to_date(vacation_store.end_day[row]);
+                    
+                    char *text = tprintf("От %d.%d.%dг. до %d.%d.%dг.", from.day, from.month, from.year, to.day, to.month, to.year);
+                    
                     Vector4 color(0, 0, 0, 1);
-                    if (info.is_colliding) {
+                    if (vacation_store.flags[row] & VACATION_IS_COLLIDING) {
                         color = Vector4(1, 0, 0, 1);
                     }
                     draw_text(font, text, x0, y0, color);
 
-                    y -= font->character_height - font->typical_descender;
+                    y -= line_height;
                 }
             }
         }
 
+        int height = font->character_height * 2;
+        if (do_older_vacations_button(font, x, y - height, text_width * 2, height, false)) {
+            y -= height;
+        }
+
         bottom_y_after_drawing = (float)(y - right_click_height);
     }
 
@@ -763,7 +836,7 @@ static void draw_hud() {
         auto employee = currently_right_clicked_employee;
         
         int font_size = (int)(0.025f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
 
         int x0 = right_click_x;
         int y0 = right_click_y;
@@ -780,12 +853,7 @@ static void draw_hud() {
                 disable_right_click_options();
                 
                 if (strings_match_unicode(option, "Премахни")) {
-                    int employee_index = all_employees.find(currently_right_clicked_employee);
-                    if (employee_index != -1) {
-                        all_employees.ordered_remove_by_index(employee_index);
-                    }
-
-                    update_collding_for_all_infos();
+                    remove_employee(currently_right_clicked_employee);
                 } else if (strings_match_unicode(option, "Преименувай")) {
                     enable_employee_name_text_input(EMPLOYEE_NAME_FOR_RENAMING);
 
@@ -793,6 +861,13 @@ static void draw_hud() {
                     if (employee) {
                         employee_name_text_input.add_text(employee->name);
                     }
+                } else if (strings_match_unicode(option, "Смени екипа")) {
+                    enable_employee_name_text_input(EMPLOYEE_NAME_FOR_TEAM);
+
+                    auto employee = currently_right_clicked_employee;
+                    if (employee && employee->team_id) {
+                        employee_name_text_input.add_text(get_team_name(employee->team_id));
+                    }
                 } else if (strings_match_unicode(option, "Добави отпуска")) {
                     //auto info = employee->add_vacation_info(5, 5, 6, 6, 2023);
                     enable_employee_info_text_input();
@@ -815,7 +890,7 @@ static void draw_hud() {
         assert(!should_draw_employee_info_text_input);
         
         int font_size = (int)(0.05f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
         
         int width  = (int)(0.5f * sys->target_width);
         int height = font->character_height;
@@ -842,17 +917,19 @@ static void draw_hud() {
             disable_employee_name_text_input();
 
             if (state == EMPLOYEE_NAME_FOR_ADDING) {
-                Employee *employee = add_employee(employee_name_text_input.get_result()); // @Leak
+                Employee *employee = add_employee(employee_name_text_input.get_temporary_result()); // It keeps a copy.
                 //auto info = employee->add_vacation_info(5, 5, 6, 6, 2023);
             } else if (state == EMPLOYEE_NAME_FOR_RENAMING) {
                 auto employee = currently_right_clicked_employee;
                 if (employee) {
-                    if (employee->name) {
-                        delete [] employee->name;
-                        employee->name = NULL;
-                    }
-
-                    employee->name = employee_name_text_input.get_result();
+                    set_employee_name(employee, employee_name_text_input.get_result());
+                }
+            } else if (state == EMPLOYEE_NAME_FOR_TEAM) {
+                auto employee = currently_right_clicked_employee;
+                if (employee) {
+                    char *team = employee_name_text_input.get_temporary_result();
+                    
+                    set_employee_team(employee, eat_trailing_spaces(eat_spaces(team))); // Empty means no team.
                 }
             }
         }
@@ -874,7 +951,7 @@ static void draw_hud() {
         }
         
         int font_size = (int)(0.05f * sys->target_height);
-        auto font = get_font_at_size("OpenSans-Regular", font_size);
+        auto font = get_font_at_size(font_name, font_size);
 
         int from_length = font->get_text_width("от");
         int to_length = font->get_text_width("до");
@@ -957,25 +1034,24 @@ static void draw_hud() {
         
         auto state = do_button(font, text, x, y + height*2 + pad/2, width, height, default_button_theme, true);
         if (state == Button_State::LEFT_PRESSED) {
-            char *from_text = vacation_info_from_text_input.get_result();
-            char *to_text   = vacation_info_to_text_input.get_result();
+            char *from_text = vacation_info_from_text_input.get_temporary_result();
+            char *to_text   = vacation_info_to_text_input.get_temporary_result();
             
-            // TODO: Check if they are valid
-
             Employee *employee = NULL; // It is here so that goto works
             
             bool success = true;
             
-            int from_day, from_month, from_year;
-            int res = sscanf(from_text, "%d.%d.%d", &from_day, &from_month, &from_year);
-            if (res != 3) {
+            Date from, to;
+            String date_text;
+
+            date_text = eat_trailing_spaces(eat_spaces(make_string(from_text)));
+            if (!parse_date(&date_text, &from) || date_text.count) {
                 success = false;
                 goto error_from;
             }
             
-            int to_day, to_month, to_year;
-            res = sscanf(to_text, "%d.%d.%d", &to_day, &to_month, &to_year);
-            if (res != 3) {
+            date_text = eat_trailing_spaces(eat_spaces(make_string(to_text)));
+            if (!parse_date(&date_text, &to) || date_text.count) {
                 success = false;
                 goto error_to;
             }
@@ -983,17 +1059,12 @@ static void draw_hud() {
             employee = currently_right_clicked_employee;
             if (employee) {
                 if (vacation_edit_type == VACATION_EDIT_DATE) {
-                    auto info = current_vacation_info_to_edit;
-                    if (info) {
-                        info->from_day   = from_day;
-                        info->from_month = from_month;
-                        info->from_year  = from_year;
-                        info->to_day     = to_day;
-                        info->to_month   = to_month;
-                        info->to_year    = to_year;
+                    int index = current_vacation_index_to_edit;
+                    if (index >= 0 && index < employee->num_vacations) {
+                        employee->edit_vacation_info(index, date_to_day_number(from.day, from.month, from.year), date_to_day_number(to.day, to.month, to.year));
                     }
                 } else {
-                    employee->add_vacation_info(from_day, from_month, from_year, to_day, to_month, to_year);
+                    employee->add_vacation_info(date_to_day_number(from.day, from.month, from.year), date_to_day_number(to.day, to.month, to.year));
                 }
             }
             
@@ -1002,8 +1073,6 @@ static void draw_hud() {
             if (vacation_edit_type == VACATION_EDIT_DATE) {
                 vacation_edit_type = VACATION_EDIT_NONE;
             }
-
-            update_collding_for_all_infos();
             
     error_to:
             if (!success) {
@@ -1022,7 +1091,7 @@ static void draw_hud() {
 void draw_game_view() {
     auto sys = globals.display_system;
 
-    auto dummy_texture = globals.texture_catalog->get_by_name("white");
+    auto dummy_texture = globals.texture_catalog->get_by_name(white_texture_name);
     sys->set_texture(0, dummy_texture); // To avoid a d3d11 warning.
     
     sys->set_render_targets(sys->offscreen_buffer, NULL);
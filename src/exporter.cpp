@@ -0,0 +1,434 @@
+#include "pch.h"
+#include "exporter.h"
+#include "vacation.h"
+#include "save_file.h"
+
+#include <limits.h>
+#include <string.h>
+
+//
+// Output_Buffer
+//
+
+Output_Buffer::~Output_Buffer() {
+    if (file) fclose(file);
+}
+
+bool Output_Buffer::start(char *path) {
+    file = fopen(path, "wb");
+    failed = (file == NULL);
+    count = 0;
+
+    if (failed) log_error("Failed to open file '%s' for writing.\n", path);
+    return !failed;
+}
+
+bool Output_Buffer::finish() {
+    flush();
+
+    if (file) {
+        if (fclose(file) != 0) failed = true;
+        file = NULL;
+    }
+    return !failed;
+}
+
+void Output_Buffer::flush() {
+    if (!count) return;
+
+    if (file && fwrite(data, 1, count, file) != (size_t)count) failed = true;
+    count = 0;
+}
+
+void Output_Buffer::put(char *s, s64 length) {
+    while (length > 0) {
+        if (count == BUFFER_SIZE) flush();
+
+        s64 n = Min(length, (s64)(BUFFER_SIZE - count));
+        memcpy(data + count, s, n);
+        count  += (int)n;
+        s      += n;
+        length -= n;
+    }
+}
+
+void Output_Buffer::put(char *s) {
+    put(s, strlen(s));
+}
+
+void Output_Buffer::put_char(char c) {
+    if (count == BUFFER_SIZE) flush();
+    data[count++] = c;
+}
+
+static char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Two digits at a time, from the back.
+void Output_Buffer::put_int(s64 value) {
+    const int MAX_LENGTH = 20; // A sign and 19 digits.
+    if (count + MAX_LENGTH > BUFFER_SIZE) flush();
+
+    u64 magnitude = (value < 0) ? (0 - (u64)value) : (u64)value;
+
+    char digits[MAX_LENGTH];
+    char *at = digits + MAX_LENGTH;
+    while (magnitude >= 100) {
+        int pair = (int)(magnitude % 100) * 2;
+        magnitude /= 100;
+        at -= 2;
+        at[0] = digit_pairs[pair];
+        at[1] = digit_pairs[pair + 1];
+    }
+    if (magnitude >= 10) {
+        at -= 2;
+        at[0] = digit_pairs[magnitude * 2];
+        at[1] = digit_pairs[magnitude * 2 + 1];
+    } else {
+        *--at = (char)('0' + magnitude);
+    }
+    if (value < 0) *--at = '-';
+
+    int length = (int)(digits + MAX_LENGTH - at);
+    memcpy(data + count, at, length);
+    count += length;
+}
+
+void Output_Buffer::put_date(s32 day_number) {
+    if (count + 16 > BUFFER_SIZE) flush();
+
+    Date date = day_number_to_date(day_number);
+    if (date.year < 0 || date.year > 9999) {
+        put_int(date.year);
+        put_char('-');
+        put_int(date.month);
+        put_char('-');
+        put_int(date.day);
+        return;
+    }
+
+    char *at = data + count;
+    int high = date.year / 100, low = date.year % 100;
+    at[0] = digit_pairs[high * 2];
+    at[1] = digit_pairs[high * 2 + 1];
+    at[2] = digit_pairs[low * 2];
+    at[3] = digit_pairs[low * 2 + 1];
+    at[4] = '-';
+    at[5] = digit_pairs[date.month * 2];
+    at[6] = digit_pairs[date.month * 2 + 1];
+    at[7] = '-';
+    at[8] = digit_pairs[date.day * 2];
+    at[9] = digit_pairs[date.day * 2 + 1];
+    count += 10;
+}
+
+void Output_Buffer::put_csv_field(char *s) {
+    bool needs_quotes = false;
+    for (char *at = s; *at; at++) {
+        if (*at == ',' || *at == '"' || *at == '\n' || *at == '\r') {
+            needs_quotes = true;
+            break;
+        }
+    }
+
+    if (!needs_quotes) {
+        put(s);
+        return;
+    }
+
+    put_char('"');
+    for (char *at = s; *at; at++) {
+        if (*at == '"') put_char('"');
+        put_char(*at);
+    }
+    put_char('"');
+}
+
+void Output_Buffer::put_json_string(char *s) {
+    put_char('"');
+
+    char *run = s; // What doesn't need escaping goes in as one piece.
+    for (char *at = s; *at; at++) {
+        u8 c = (u8)*at;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        put(run, at - run);
+        run = at + 1;
+
+        put_char('\\');
+        switch (c) {
+            case '"':  put_char('"');  break;
+            case '\\': put_char('\\'); break;
+            case '\n': put_char('n');  break;
+            case '\r': put_char('r');  break;
+            case '\t': put_char('t');  break;
+            default: {
+                char hex[] = "0123456789abcdef";
+                put("u00", 3);
+                put_char(hex[c >> 4]);
+                put_char(hex[c & 0xf]);
+            } break;
+        }
+    }
+    put(run, strlen(run));
+
+    put_char('"');
+}
+
+//
+// Picking what goes in
+//
+
+// The calendar goes by employee; a block that has moved to the end of vacation_store is
+// out of order there.
+static int compare_rows_by_employee(const void *a, const void *b) {
+    int row_a = *(int *)a;
+    int row_b = *(int *)b;
+    s32 id_a = vacation_store.employee_id[row_a];
+    s32 id_b = vacation_store.employee_id[row_b];
+    if (id_a != id_b) return (id_a > id_b) ? 1 : -1;
+    return (row_a > row_b) - (row_a < row_b);
+}
+
+static void add_employee_rows(Employee *employee, Export_Filter *filter, Array <int> *rows) {
+    if (filter->only_colliding && !employee->num_colliding_vacations) return;
+
+    int first = employee->first_vacation;
+    for (int row = first; row < first + employee->num_vacations; row++) {
+        if (filter->only_colliding && !(vacation_store.flags[row] & VACATION_IS_COLLIDING)) continue;
+
+        rows->add(row);
+    }
+}
+
+// Rows in vacation_store, in the same order as in the calendar.
+static void select_rows(Export_Filter *filter, Array <int> *rows) {
+    if (filter->by_date) {
+        if (filter->team_id >= 0) find_team_vacations_between(filter->team_id, filter->from, filter->to, rows);
+        else                      find_vacations_between(filter->from, filter->to, rows);
+
+        qsort(rows->data, rows->count, sizeof(int), compare_rows_by_employee);
+
+        if (filter->only_colliding) {
+            int kept = 0;
+            for (int row : *rows) {
+                if (vacation_store.flags[row] & VACATION_IS_COLLIDING) rows->data[kept++] = row;
+            }
+            rows->count = kept;
+        }
+        return;
+    }
+
+    // Without dates, the employees know which of them are in the team and which have
+    // anything colliding, and their rows are already in order.
+    load_all_vacations();
+    rows->reserve(filter->team_id < 0 && !filter->only_colliding ? vacation_store.count : 0);
+    for (auto employee : all_employees) {
+        if (filter->team_id >= 0 && employee->team_id != filter->team_id) continue;
+        add_employee_rows(employee, filter, rows);
+    }
+}
+
+static int compare_collisions(const void *a, const void *b) {
+    auto collision_a = (Vacation_Collision *)a;
+    auto collision_b = (Vacation_Collision *)b;
+    if (collision_a->a != collision_b->a) return (collision_a->a > collision_b->a) ? 1 : -1;
+    return (collision_a->b > collision_b->b) - (collision_a->b < collision_b->b);
+}
+
+// Sorted by the rows of both vacations, so that the report comes out the same however
+// the pairs were found.
+static void select_collisions(Export_Filter *filter, Array <Vacation_Collision> *collisions) {
+    if (!filter->by_date && filter->team_id < 0) {
+        load_all_vacations();
+        find_colliding_vacations(collisions); // One sweep over everything is cheaper than a query per vacation.
+
+        for (auto &collision : *collisions) {
+            if (collision.a > collision.b) {
+                int a = collision.a;
+                collision.a = collision.b;
+                collision.b = a;
+            }
+        }
+    } else {
+        s32 from = filter->by_date ? filter->from : INT_MIN;
+        s32 to   = filter->by_date ? filter->to   : INT_MAX;
+        find_collisions_between(from, to, filter->team_id, collisions);
+    }
+
+    qsort(collisions->data, collisions->count, sizeof(Vacation_Collision), compare_collisions);
+}
+
+//
+// Writing
+//
+
+static void put_csv_vacation(Output_Buffer *out, int row) {
+    auto store = &vacation_store;
+    s32 start = store->start_day[row];
+    s32 end   = store->end_day[row];
+
+    out->put_csv_field(all_employees[store->employee_id[row]]->name);
+    out->put_char(',');
+    out->put_csv_field(get_team_name(store->team_id[row]));
+    out->put_char(',');
+    out->put_date(start);
+    out->put_char(',');
+    out->put_date(end);
+    out->put_char(',');
+    out->put_int(end - start);
+}
+
+static void put_json_vacation(Output_Buffer *out, int row, char *prefix) {
+    auto store = &vacation_store;
+    s32 start = store->start_day[row];
+    s32 end   = store->end_day[row];
+
+    out->put("\"");
+    out->put(prefix);
+    out->put("employee\": ");
+    out->put_json_string(all_employees[store->employee_id[row]]->name);
+    out->put(", \"");
+    out->put(prefix);
+    out->put("from\": \"");
+    out->put_date(start);
+    out->put("\", \"");
+    out->put(prefix);
+    out->put("to\": \"");
+    out->put_date(end);
+    out->put("\"");
+}
+
+bool export_calendar(char *path, Export_Format format, Export_Filter *filter) {
+    Array <int> rows;
+    select_rows(filter, &rows);
+
+    Output_Buffer out;
+    if (!out.start(path)) return false;
+
+    if (format == EXPORT_CSV) {
+        out.put("employee,team,from,to,days,colliding\r\n");
+        for (int row : rows) {
+            put_csv_vacation(&out, row);
+            out.put_char(',');
+            out.put_char((vacation_store.flags[row] & VACATION_IS_COLLIDING) ? '1' : '0');
+            out.put("\r\n");
+        }
+    } else {
+        out.put("{\"vacations\": [");
+        for (int i = 0; i < rows.count; i++) {
+            int row = rows[i];
+            if (i) out.put_char(',');
+            out.put("\n  {");
+            put_json_vacation(&out, row, "");
+            out.put(", \"team\": ");
+            out.put_json_string(get_team_name(vacation_store.team_id[row]));
+            out.put(", \"days\": ");
+            out.put_int(vacation_store.end_day[row] - vacation_store.start_day[row]);
+            out.put(", \"colliding\": ");
+            if (vacation_store.flags[row] & VACATION_IS_COLLIDING) out.put("true}");
+            else                                                    out.put("false}");
+        }
+        if (rows.count) out.put_char('\n');
+        out.put("]}\n");
+    }
+
+    if (!out.finish()) {
+        log_error("Failed to write '%s'.\n", path);
+        return false;
+    }
+
+    log("[export] Wrote %d vacations to '%s'.\n", rows.count, path);
+    return true;
+}
+
+bool export_collision_report(char *path, Export_Format format, Export_Filter *filter) {
+    Array <Vacation_Collision> collisions;
+    select_collisions(filter, &collisions);
+
+    Output_Buffer out;
+    if (!out.start(path)) return false;
+
+    auto store = &vacation_store;
+
+    if (format == EXPORT_CSV) {
+        out.put("team,employee_a,from_a,to_a,employee_b,from_b,to_b,overlap_from,overlap_to,overlap_days\r\n");
+    } else {
+        out.put("{\"collisions\": [");
+    }
+
+    for (int i = 0; i < collisions.count; i++) {
+        int a = collisions[i].a;
+        int b = collisions[i].b;
+
+        s32 overlap_start = Max(store->start_day[a], store->start_day[b]);
+        s32 overlap_end   = Min(store->end_day[a],   store->end_day[b]);
+        char *team = get_team_name(store->team_id[a]);
+
+        if (format == EXPORT_CSV) {
+            out.put_csv_field(team);
+            out.put_char(',');
+            out.put_csv_field(all_employees[store->employee_id[a]]->name);
+            out.put_char(',');
+            out.put_date(store->start_day[a]);
+            out.put_char(',');
+            out.put_date(store->end_day[a]);
+            out.put_char(',');
+            out.put_csv_field(all_employees[store->employee_id[b]]->name);
+            out.put_char(',');
+            out.put_date(store->start_day[b]);
+            out.put_char(',');
+            out.put_date(store->end_day[b]);
+            out.put_char(',');
+            out.put_date(overlap_start);
+            out.put_char(',');
+            out.put_date(overlap_end);
+            out.put_char(',');
+            out.put_int(overlap_end - overlap_start);
+            out.put("\r\n");
+        } else {
+            if (i) out.put_char(',');
+            out.put("\n  {\"team\": ");
+            out.put_json_string(team);
+            out.put(", ");
+            put_json_vacation(&out, a, "a_");
+            out.put(", ");
+            put_json_vacation(&out, b, "b_");
+            out.put(", \"overlap_from\": \"");
+            out.put_date(overlap_start);
+            out.put("\", \"overlap_to\": \"");
+            out.put_date(overlap_end);
+            out.put("\", \"overlap_days\": ");
+            out.put_int(overlap_end - overlap_start);
+            out.put_char('}');
+        }
+    }
+
+    if (format == EXPORT_JSON) {
+        if (collisions.count) out.put_char('\n');
+        out.put("]}\n");
+    }
+
+    if (!out.finish()) {
+        log_error("Failed to write '%s'.\n", path);
+        return false;
+    }
+
+    log("[export] Wrote %d collisions to '%s'.\n", collisions.count, path);
+    return true;
+}
+
+Export_Format get_export_format(char *path) {
+    char *dot = strrchr(path, '.');
+    if (dot && (strings_match(dot, ".json") || strings_match(dot, ".JSON"))) return EXPORT_JSON;
+    return EXPORT_CSV;
+}
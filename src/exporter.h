@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdio.h>
+
+//
+// Exports for payroll and the like: the calendar (one line per vacation) and the
+// collision report (one line per pair of colliding vacations), as CSV or JSON.
+// Dates are written as YYYY-MM-DD, and 'to' is the end as it is stored, so 'days' is
+// to - from.
+//
+// Everything goes through one Output_Buffer, which formats numbers and dates straight
+// into it and only touches the file when it is full, so nothing is allocated per line.
+//
+
+struct Output_Buffer {
+    static const int BUFFER_SIZE = 64 * 1024;
+
+    FILE *file = NULL;
+    bool failed = false;
+
+    int count = 0;
+    char data[BUFFER_SIZE];
+
+    ~Output_Buffer();
+
+    bool start(char *path);
+    bool finish(); // Closes the file; false if anything couldn't be written.
+
+    void flush();
+
+    void put(char *s, s64 length);
+    void put(char *s);
+    void put_char(char c);
+    void put_int(s64 value);
+    void put_date(s32 day_number); // YYYY-MM-DD.
+
+    void put_csv_field(char *s);   // Quoted if it has to be.
+    void put_json_string(char *s); // With the quotes.
+};
+
+enum Export_Format {
+    EXPORT_CSV,
+    EXPORT_JSON,
+};
+
+// What to leave out. The date range and team go through the collision index, and
+// 'only_colliding' through the collision flags, so a narrow export doesn't go through
+// every vacation there is.
+struct Export_Filter {
+    bool by_date = false;
+    s32 from = 0; // [from, to), as day numbers; a vacation is in if it shares a day with it.
+    s32 to   = 0;
+
+    int team_id = -1; // -1 is every team.
+    bool only_colliding = false;
+};
+
+Export_Format get_export_format(char *path); // JSON if it ends in .json.
+
+bool export_calendar(char *path, Export_Format format, Export_Filter *filter);
+bool export_collision_report(char *path, Export_Format format, Export_Filter *filter);
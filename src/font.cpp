@@ -135,7 +135,7 @@ Glyph_Data *Dynamic_Font::find_or_create_glyph(int utf32) {
 
     auto glyph_index = FT_Get_Char_Index(face, utf32);
     if (!glyph_index) {
-        log_error("Unable to find a glyph in font '%s' for utf32 character %d.\n", name, utf32);
+        log_error("Unable to find a glyph in font '%s' for utf32 character %d.\n", get_string(name), utf32);
         glyph_index = glyph_index_for_unknown_character;
     }
     auto error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
@@ -168,7 +168,7 @@ void init_fonts(int _page_size_x, int _page_size_y) {
     auto error = FT_Init_FreeType(&ft_library);
     assert(!error);
 
-    glyph_and_line_arena.init(Megabytes(4)); // Should be enough space
+    glyph_and_line_arena.init(Kilobytes(64)); // Another block is mapped when the glyphs fill it.
 }
 
 void destroy_fonts() {
@@ -282,7 +282,7 @@ void Dynamic_Font::load_font(int pixel_height) {
         if (!success) success = set_unknown_character(0x2022); // BULLET
         if (!success) success = set_unknown_character('?');
         if (!success) {
-            log_error("Unable to set unknown character for font '%s'.\n", name);
+            log_error("Unable to set unknown character for font '%s'.\n", get_string(name));
         }
     }
 
@@ -290,15 +290,21 @@ void Dynamic_Font::load_font(int pixel_height) {
 }
 
 Dynamic_Font *get_font_at_size(char *name, int pixel_height) {
+    return get_font_at_size(intern_string(name), pixel_height);
+}
+
+Dynamic_Font *get_font_at_size(Interned_String interned_name, int pixel_height) {
     ensure_fonts_are_initted();
 
     for (auto it : dynamic_fonts) {
         if (it->character_height != pixel_height) continue;
-        if (!strings_match(it->name, name)) continue;
+        if (it->name != interned_name) continue;
 
         return it;
     }
 
+    char *name = get_string(interned_name);
+
     char *extensions[] = {
         "ttf",
         "otf",
@@ -341,7 +347,7 @@ Dynamic_Font *get_font_at_size(char *name, int pixel_height) {
     }
 
     auto result = new Dynamic_Font();
-    result->name = copy_string(name);
+    result->name = interned_name;
     result->face = face;
     result->load_font(pixel_height);
     return result;
@@ -30,7 +30,7 @@ struct Font_Quad {
 };
 
 struct Dynamic_Font {
-    char *name;
+    Interned_String name;
     struct FT_FaceRec_ *face;
     Hash_Table <int, Glyph_Data *> glyph_lookup;
     
@@ -93,3 +93,4 @@ struct Code_Line {
 void init_fonts(int page_size_x = -1, int page_size_y = -1);
 void destroy_fonts();
 Dynamic_Font *get_font_at_size(char *name, int pixel_height);
+Dynamic_Font *get_font_at_size(Interned_String name, int pixel_height); // For every frame; the names are compared as ints.
@@ -4,6 +4,8 @@
 #include <string.h> // For strlen
 #include <ctype.h>
 
+#include "os_specific.h"
+
 #ifdef _WIN32
 #include <Windows.h>
 #endif
@@ -21,7 +23,8 @@ char *mprintf(char *fmt, ...) {
 }
 
 char *mprintf_valist(char *fmt, va_list args) {
-    va_list ap = args;
+    va_list ap;
+    va_copy(ap, args);
     size_t n = 1 + vsnprintf(NULL, 0, fmt, ap);
     va_end(ap);
     char *str = new char[n];
@@ -145,6 +148,115 @@ void log_error(char *fmt, ...) {
 #endif
 }
 
+String make_string(char *c_string) {
+    String result;
+    result.data  = c_string;
+    result.count = c_string ? strlen(c_string) : 0;
+    return result;
+}
+
+String make_string(char *data, s64 count) {
+    String result;
+    result.data  = data;
+    result.count = count;
+    return result;
+}
+
+String advance(String s, s64 amount) {
+    if (amount > s.count) amount = s.count;
+    s.data  += amount;
+    s.count -= amount;
+    return s;
+}
+
+bool strings_match(String a, char *b) {
+    if (!b) return false;
+
+    for (s64 i = 0; i < a.count; i++) {
+        if (a.data[i] != b[i]) return false; // Also stops at the end of b.
+    }
+    return b[a.count] == 0;
+}
+
+bool starts_with(String a, char *b) {
+    if (!b) return false;
+
+    for (s64 i = 0; b[i]; i++) {
+        if (i >= a.count || a.data[i] != b[i]) return false;
+    }
+    return true;
+}
+
+String eat_spaces(String s) {
+    while (s.count && isspace((u8)s.data[0])) {
+        s.data  += 1;
+        s.count -= 1;
+    }
+    return s;
+}
+
+String eat_trailing_spaces(String s) {
+    while (s.count && isspace((u8)s.data[s.count - 1])) s.count -= 1;
+    return s;
+}
+
+char *copy_string(String s) {
+    char *result = new char[s.count + 1];
+    memcpy(result, s.data, s.count);
+    result[s.count] = 0;
+    return result;
+}
+
+char *to_c_string(String s, char *buffer, s64 buffer_size) {
+    s64 count = Min(s.count, buffer_size - 1);
+    memcpy(buffer, s.data, count);
+    buffer[count] = 0;
+    return buffer;
+}
+
+int string_to_int(String s) {
+    s = eat_spaces(s);
+
+    bool negative = false;
+    if (s.count && (s.data[0] == '-' || s.data[0] == '+')) {
+        negative = s.data[0] == '-';
+        s = advance(s, 1);
+    }
+
+    int result = 0;
+    for (s64 i = 0; i < s.count && s.data[i] >= '0' && s.data[i] <= '9'; i++) {
+        result = result * 10 + (s.data[i] - '0');
+    }
+    return negative ? -result : result;
+}
+
+bool parse_int(String *s, int *result) {
+    char *at  = s->data;
+    char *end = s->data + s->count;
+
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = *at == '-';
+        at += 1;
+    }
+
+    char *digits = at;
+    u32 value = 0;
+    u32 limit = negative ? 2147483648u : 2147483647u;
+    while (at < end && (u8)(*at - '0') <= 9) {
+        u32 digit = (u32)(*at - '0');
+        if (value > (limit - digit) / 10) return false;
+
+        value = value * 10 + digit;
+        at += 1;
+    }
+    if (at == digits) return false;
+
+    *result = negative ? (int)(0u - value) : (int)value;
+    *s = advance(*s, at - s->data);
+    return true;
+}
+
 // Copy-paste from https://github.com/raysan5/raylib/blob/master/src/rtext.c
 int get_codepoint(char *text, int *bytes_processed) {
     int code = 0x3f;
@@ -254,16 +366,108 @@ int get_utf8(char *text, int utf32) {
     return 0;
 }
 
-void Memory_Arena::init(s64 size) {
-    max_size = size;
-    data = new u8[size];
-    data_at = data;
+Memory_Arena temporary_storage;
+
+void Memory_Arena::init(s64 _block_size) {
+    assert(!first);
+    block_size = _block_size;
 }
 
 void *Memory_Arena::get(s64 size) {
-    assert(data_at + size <= data + max_size);
+    size = (size + 15) & ~15;
 
-    void *result = (void *)data_at;
-    data_at += size;
+    if (current && current->used + size <= current->size) {
+        void *result = (u8 *)(current + 1) + current->used;
+        current->used += size;
+        return result;
+    }
+
+    // The block after this one is free if there is one, from an earlier reset_to().
+    auto next = current ? current->next : first;
+    if (!next || next->size < size) {
+        const s64 GRANULARITY = 65536; // What VirtualAlloc hands out anyway.
+
+        s64 mapped = Max(block_size, (s64)sizeof(Memory_Arena_Block) + size);
+        mapped = (mapped + GRANULARITY - 1) & ~(GRANULARITY - 1);
+
+        auto block = (Memory_Arena_Block *)os_allocate_pages(mapped);
+        if (!block) {
+            log_error("Failed to map %lld bytes for a memory arena.\n", (long long)mapped);
+            return NULL;
+        }
+
+        block->size = mapped - (s64)sizeof(Memory_Arena_Block);
+        block->used = 0;
+        block->next = next;
+
+        if (current) current->next = block;
+        else         first = block;
+
+        next = block;
+    }
+
+    current = next;
+    current->used = size;
+    return current + 1;
+}
+
+Arena_Mark Memory_Arena::mark() {
+    Arena_Mark result;
+    result.block = current;
+    result.used  = current ? current->used : 0;
     return result;
 }
+
+void Memory_Arena::reset_to(Arena_Mark mark) {
+    for (auto block = mark.block ? mark.block->next : first; block; block = block->next) {
+        block->used = 0;
+    }
+
+    if (mark.block) mark.block->used = mark.used;
+    current = mark.block;
+}
+
+void Memory_Arena::reset() {
+    reset_to(Arena_Mark());
+}
+
+void Memory_Arena::deinit() {
+    auto block = first;
+    while (block) {
+        auto next = block->next;
+        os_free_pages(block, (s64)sizeof(Memory_Arena_Block) + block->size);
+        block = next;
+    }
+
+    first   = NULL;
+    current = NULL;
+}
+
+// Prints straight into the room the arena would hand out next, and then takes it, so
+// that only a string that doesn't fit there has to be printed twice.
+char *tprintf(char *fmt, ...) {
+    auto arena = &temporary_storage;
+    auto block = arena->current ? arena->current : arena->first;
+
+    char *room = NULL;
+    s64 room_size = 0;
+    if (block) {
+        room = (char *)(block + 1) + block->used;
+        room_size = block->size - block->used;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    s64 n = 1 + vsnprintf(room, (size_t)room_size, fmt, args);
+    va_end(args);
+    if (n <= 0) return ""; // A broken format.
+
+    char *str = (char *)arena->get(n);
+    if (!str) return "";
+    if (str == room) return str;
+
+    va_start(args, fmt);
+    vsnprintf(str, n, fmt, args);
+    va_end(args);
+    return str;
+}
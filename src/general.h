@@ -60,17 +60,68 @@ bool starts_with(char *a, char *b);
 char *eat_spaces(char *s);
 char *eat_trailing_spaces(char *s);
 char *consume_next_line(char **text_ptr);
+
+// Characters that live somewhere else, usually in a file buffer. Not zero terminated.
+struct String {
+    char *data = NULL;
+    s64 count = 0;
+};
+
+String make_string(char *c_string);
+String make_string(char *data, s64 count);
+String advance(String s, s64 amount);
+bool strings_match(String a, char *b);
+bool starts_with(String a, char *b);
+String eat_spaces(String s);
+String eat_trailing_spaces(String s);
+char *copy_string(String s);
+char *to_c_string(String s, char *buffer, s64 buffer_size); // Cuts it short if it doesn't fit.
+int string_to_int(String s); // Like atoi.
+
+// Reads an optional sign and then digits from the start of 's', and advances past them.
+// Fails without digits or when the number doesn't fit; 's' then stays where it was.
+bool parse_int(String *s, int *result);
 int get_codepoint(char *text, int *bytes_processed);
 int get_utf8(char *text, int utf32);
 
 void log(char *fmt, ...);
 void log_error(char *fmt, ...);
 
+//
+// Blocks of pages from the os, chained together; when one is full the next one is mapped,
+// big enough for whatever didn't fit. Nothing is freed on its own: reset_to() gives back
+// everything after a mark, and keeps the blocks around to be used again. The pages only
+// go back to the os in deinit().
+//
+
+struct Memory_Arena_Block {
+    Memory_Arena_Block *next;
+    s64 size; // Of the data after the header.
+    s64 used;
+    s64 pad;  // So that the data starts 16 bytes in.
+};
+
+struct Arena_Mark {
+    Memory_Arena_Block *block = NULL;
+    s64 used = 0;
+};
+
 struct Memory_Arena {
-    s64 max_size;
-    u8 *data;
-    u8 *data_at;
+    s64 block_size = Kilobytes(64);
+    Memory_Arena_Block *first   = NULL;
+    Memory_Arena_Block *current = NULL;
 
-    void init(s64 size);
-    void *get(s64 size);
+    void init(s64 block_size); // What a new block maps, unless one thing needs more.
+    void *get(s64 size);       // Aligned to 16. NULL if the os is out of pages.
+
+    Arena_Mark mark();
+    void reset_to(Arena_Mark mark);
+    void reset();
+    void deinit();
 };
+
+// For things that only have to last the frame. It is reset at the top of the main loop,
+// and only the main thread uses it.
+extern Memory_Arena temporary_storage;
+
+char *tprintf(char *fmt, ...);
@@ -1,26 +1,107 @@
 #pragma once
 
-inline int hash(int x) {
-    x = ((x >> 16) ^ x) * 0x45d9f3b;
-    x = ((x >> 16) ^ x) * 0x45d9f3b;
-    x = (x >> 16) ^ x;
+//
+// Open addressing with a control byte per slot, the way SwissTable does it. The byte
+// is EMPTY, DELETED, or the low 7 bits of the key's hash. A lookup compares 16 control
+// bytes at a time with those 7 bits, and only looks at the keys where they match, so
+// it hardly ever compares a key that isn't the one it wants. It stops at the first
+// group with an EMPTY in it.
+//
+// The table grows once 7/8 of it is used, counting the slots of removed keys, which
+// stay DELETED until then. Pointers to values only last until the next add.
+//
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define HASH_TABLE_SSE2 1 // Every x64 cpu has it.
+#else
+#define HASH_TABLE_SSE2 0
+#endif
+
+// The finalizer of splitmix64, so that every bit of the key moves every bit of the
+// hash; the slot comes from the high bits and the control byte from the low ones.
+inline u64 hash(u64 x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
     return x;
 }
 
-inline int hash(char *str) {
-    int hash = 5381;
+inline u64 hash(int x) {
+    return hash((u64)(u32)x);
+}
+
+inline u64 hash(void *p) {
+    return hash((u64)(uintptr_t)p);
+}
 
-    for (char *at = str; *at; at++) {
-        hash = ((hash << 5) + hash) + *at;
+// FNV-1a.
+inline u64 hash(char *str, s64 length) {
+    u64 hash_value = 0xcbf29ce484222325ULL;
+    for (s64 i = 0; i < length; i++) {
+        hash_value = (hash_value ^ (u8)str[i]) * 0x100000001b3ULL;
     }
-    return hash;
+    return hash(hash_value);
+}
+
+inline u64 hash(char *str) {
+    return hash(str, strlen(str));
+}
+
+template <typename Key>
+inline bool keys_match(Key a, Key b) {
+    return a == b;
 }
 
-#pragma warning(push, 0)
-inline int hash(void *p) {
-    return (int)p;
+inline bool keys_match(char *a, char *b) {
+    return strings_match(a, b);
+}
+
+const int HASH_TABLE_GROUP_SIZE = 16;
+const u8 HASH_TABLE_EMPTY   = 0x80;
+const u8 HASH_TABLE_DELETED = 0xfe; // Anything with the high bit set isn't a key.
+
+// Bit i is set if byte i of the group is 'value'.
+inline u32 match_control_bytes(u8 *group, u8 value) {
+#if HASH_TABLE_SSE2
+    __m128i bytes = _mm_loadu_si128((__m128i *)group);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)value)));
+#else
+    u32 mask = 0;
+    for (int i = 0; i < HASH_TABLE_GROUP_SIZE; i++) {
+        if (group[i] == value) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// Bit i is set if byte i of the group is EMPTY or DELETED.
+inline u32 match_free_control_bytes(u8 *group) {
+#if HASH_TABLE_SSE2
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((__m128i *)group));
+#else
+    u32 mask = 0;
+    for (int i = 0; i < HASH_TABLE_GROUP_SIZE; i++) {
+        if (group[i] & 0x80) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+inline int lowest_set_bit(u32 mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
 }
-#pragma warning(pop)
 
 template <typename Key, typename Value>
 struct Hash_Table {
@@ -29,146 +110,171 @@ struct Hash_Table {
         Value value;
     };
 
+    // allocated + HASH_TABLE_GROUP_SIZE of them; the last group repeats the first one,
+    // so that a group can be read starting at any slot.
+    u8 *controls = nullptr;
     Bucket *buckets = nullptr;
-    bool *occupancy_mask = nullptr;
-    int allocated = 0;
+    int allocated = 0; // A power of two.
     int count = 0;
+    int num_deleted = 0;
 
-    inline void grow() {
-        const int HASH_TABLE_INITIAL_CAPACITY = 256;
+    // Groups are probed at 1, 2, 3... groups further each time, which gets to every
+    // group once the table is a power of two groups big.
+    template <typename Proc>
+    inline int probe(u64 key_hash, Proc proc) {
+        int mask = allocated - 1;
+        int position = (int)(key_hash >> 7) & mask;
+        int stride = 0;
+
+        while (true) {
+            int slot = proc(position, controls + position);
+            if (slot >= 0) return slot;
+            if (slot == -2) return -1;
+
+            stride += HASH_TABLE_GROUP_SIZE;
+            position = (position + stride) & mask;
+        }
+    }
 
-        if (!buckets) {
-            assert(allocated == 0);
-            assert(count == 0);
-            
-            buckets = (Bucket *)calloc(HASH_TABLE_INITIAL_CAPACITY, sizeof(Bucket));
-            occupancy_mask = (bool *)calloc(HASH_TABLE_INITIAL_CAPACITY, sizeof(bool));
-            allocated = HASH_TABLE_INITIAL_CAPACITY;
-            count = 0;
-        } else {
-            Hash_Table <Key, Value> new_hash_table = {
-                (Bucket *)calloc(allocated * 2, sizeof(Bucket)),
-                (bool *)calloc(allocated * 2, sizeof(bool)),
-                allocated * 2,
-                0,
-            };
-
-            memset(new_hash_table.buckets, 0, allocated * 2 * sizeof(Bucket));
-            memset(new_hash_table.occupancy_mask, 0, allocated * 2 * sizeof(bool));
-
-            for (int i = 0; i < count; i++) {
-                if (occupancy_mask[i]) {
-                    new_hash_table.add(buckets[i].key, buckets[i].value);
-                }
+    inline int find_slot(Key key, u64 key_hash) {
+        if (!allocated) return -1;
+
+        u8 h2 = (u8)(key_hash & 0x7f);
+        return probe(key_hash, [&](int position, u8 *group) {
+            u32 matches = match_control_bytes(group, h2);
+            while (matches) {
+                int slot = (position + lowest_set_bit(matches)) & (allocated - 1);
+                if (keys_match(buckets[slot].key, key)) return slot;
+                matches &= matches - 1;
             }
 
-            free(buckets);
-            free(occupancy_mask);
+            // Keys are never past the first EMPTY of their probe sequence.
+            return match_control_bytes(group, HASH_TABLE_EMPTY) ? -2 : -1;
+        });
+    }
+
+    inline int find_free_slot(u64 key_hash) {
+        return probe(key_hash, [&](int position, u8 *group) {
+            u32 free_slots = match_free_control_bytes(group);
+            if (!free_slots) return -1;
+            return (position + lowest_set_bit(free_slots)) & (allocated - 1);
+        });
+    }
 
-            *this = new_hash_table;
-        }
+    inline void set_control(int slot, u8 control) {
+        controls[slot] = control;
+        if (slot < HASH_TABLE_GROUP_SIZE) controls[allocated + slot] = control;
     }
 
-    inline void add(Key key, Value value) {
-        if (count >= allocated) {
-            grow();
-        }
+    // Every slot that holds a key goes to the new table, which drops the DELETED ones.
+    inline void rehash(int new_allocated) {
+        u8 *old_controls = controls;
+        Bucket *old_buckets = buckets;
+        int old_allocated = allocated;
+
+        allocated = new_allocated;
+        controls = (u8 *)malloc(allocated + HASH_TABLE_GROUP_SIZE);
+        buckets = (Bucket *)malloc(allocated * sizeof(Bucket));
+        memset(controls, HASH_TABLE_EMPTY, allocated + HASH_TABLE_GROUP_SIZE);
+        num_deleted = 0;
 
-        auto hk = hash(key) & (allocated - 1);
-        while (occupancy_mask[hk] && buckets[hk].key != key) {
-            hk = (hk + 1) & (allocated - 1);
+        for (int i = 0; i < old_allocated; i++) {
+            if (old_controls[i] & 0x80) continue;
+
+            u64 key_hash = hash(old_buckets[i].key);
+            int slot = find_free_slot(key_hash);
+            set_control(slot, (u8)(key_hash & 0x7f));
+            buckets[slot] = old_buckets[i];
         }
 
-        occupancy_mask[hk] = true;
-        buckets[hk].key = key;
-        buckets[hk].value = value;
-        count++;
+        free(old_controls);
+        free(old_buckets);
     }
 
     inline Value *find(Key key) {
-        auto hk = hash(key) & (allocated - 1);
-        for (int i = 0; i < allocated && occupancy_mask[hk] && buckets[hk].key != key; i++) {
-            hk = (hk + 1) & (allocated - 1);
+        int slot = find_slot(key, hash(key));
+        return (slot >= 0) ? &buckets[slot].value : nullptr;
+    }
+
+    // Replaces the value if the key is there already.
+    inline void add(Key key, Value value) {
+        const int HASH_TABLE_INITIAL_CAPACITY = 256;
+
+        u64 key_hash = hash(key);
+        int slot = find_slot(key, key_hash);
+        if (slot >= 0) {
+            buckets[slot].value = value;
+            return;
         }
 
-        if (buckets && occupancy_mask[hk] && buckets[hk].key == key) {
-            return &buckets[hk].value;
-        } else {
-            return nullptr;
+        if (!allocated) {
+            rehash(HASH_TABLE_INITIAL_CAPACITY);
+        } else if ((count + num_deleted + 1) > allocated / 8 * 7) {
+            // When it is mostly DELETED, getting rid of those is enough.
+            rehash((count + 1 > allocated / 16 * 7) ? allocated * 2 : allocated);
         }
-    }
-};
 
-template <typename Value>
-struct String_Hash_Table {
-    struct Bucket {
-        char *key;
-        Value value;
-    };
+        slot = find_free_slot(key_hash);
+        if (controls[slot] == HASH_TABLE_DELETED) num_deleted -= 1;
 
-    Bucket *buckets = nullptr;
-    bool *occupancy_mask = nullptr;
-    int allocated = 0;
-    int count = 0;
+        set_control(slot, (u8)(key_hash & 0x7f));
+        buckets[slot].key = key;
+        buckets[slot].value = value;
+        count++;
+    }
 
-    inline void grow() {
-        const int HASH_TABLE_INITIAL_CAPACITY = 256;
+    // 'removed_key' is the key as it was stored, for whoever has to free it.
+    inline bool remove(Key key, Key *removed_key = nullptr) {
+        int slot = find_slot(key, hash(key));
+        if (slot < 0) return false;
 
-        if (!buckets) {
-            assert(allocated == 0);
-            assert(count == 0);
-
-            buckets = (Bucket *)calloc(HASH_TABLE_INITIAL_CAPACITY, sizeof(Bucket));
-            occupancy_mask = (bool *)calloc(HASH_TABLE_INITIAL_CAPACITY, sizeof(bool));
-            allocated = HASH_TABLE_INITIAL_CAPACITY;
-            count = 0;
-        } else {
-            String_Hash_Table <Value> new_hash_table = {
-                (Bucket *)calloc(allocated * 2, sizeof(Bucket)),
-                (bool *)calloc(allocated * 2, sizeof(bool)),
-                allocated * 2,
-                0,
-            };
-
-            for (int i = 0; i < count; i++) {
-                if (occupancy_mask[i]) {
-                    new_hash_table.add(buckets[i].key, buckets[i].value);
-                }
-            }
+        if (removed_key) *removed_key = buckets[slot].key;
 
-            free(buckets);
-            free(occupancy_mask);
+        set_control(slot, HASH_TABLE_DELETED);
+        count--;
+        num_deleted++;
+        return true;
+    }
 
-            *this = new_hash_table;
-        }
+    inline void deinit() {
+        free(controls);
+        free(buckets);
+        *this = {};
     }
+};
 
-    inline void add(char *key, Value value) {
-        if (count >= allocated) {
-            grow();
-        }
+// Keeps copies of the keys.
+template <typename Value>
+struct String_Hash_Table {
+    Hash_Table <char *, Value> table;
 
-        auto hk = hash(key) & (allocated - 1);
-        while (occupancy_mask[hk] && !strings_match(buckets[hk].key, key)) {
-            hk = (hk + 1) & (allocated - 1);
+    inline void add(char *key, Value value) {
+        Value *existing = table.find(key);
+        if (existing) {
+            *existing = value;
+            return;
         }
 
-        occupancy_mask[hk] = true;
-        buckets[hk].key = copy_string(key);
-        buckets[hk].value = value;
-        count++;
+        table.add(copy_string(key), value);
     }
 
     inline Value *find(char *key) {
-        auto hk = hash(key) & (allocated - 1);
-        for (int i = 0; i < allocated && occupancy_mask[hk] && !strings_match(buckets[hk].key, key); i++) {
-            hk = (hk + 1) & (allocated - 1);
-        }
+        return table.find(key);
+    }
 
-        if (buckets && occupancy_mask[hk] && strings_match(buckets[hk].key, key)) {
-            return &buckets[hk].value;
-        } else {
-            return nullptr;
+    inline bool remove(char *key) {
+        char *removed_key;
+        if (!table.remove(key, &removed_key)) return false;
+
+        delete [] removed_key;
+        return true;
+    }
+
+    inline void deinit() {
+        for (int i = 0; i < table.allocated; i++) {
+            if (!(table.controls[i] & 0x80)) delete [] table.buckets[i].key;
         }
+
+        table.deinit();
     }
 };
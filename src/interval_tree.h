@@ -0,0 +1,250 @@
+#pragma once
+
+//
+// A treap of half-open [start, end) intervals, ordered by start and augmented with
+// the largest end in every subtree, so that searches can skip whole subtrees that
+// end before the range we are interested in.
+//
+// Nodes live in one array and are referred to by their index, so a handle returned
+// by insert() stays valid until that interval is removed.
+//
+// Key needs operator< and operator==.
+//
+
+template <typename Key, typename Value>
+struct Interval_Tree {
+    struct Node {
+        Key start;
+        Key end;
+        Key max_end;
+
+        Value value;
+
+        int left;
+        int right;
+        u32 priority;
+    };
+
+    Array <Node> nodes;
+    Array <int> free_nodes;
+
+    int root  = -1;
+    int count = 0;
+
+    u32 random_state = 0x9e3779b9;
+
+    int insert(Key start, Key end, Value value);
+    void remove(int handle);
+    void clear();
+
+    Node *get(int handle);
+
+    // Calls proc(handle, node) for every interval that shares at least one day with [start, end).
+    template <typename Proc> void for_each_overlapping(Key start, Key end, Proc proc);
+
+private:
+    u32 next_priority();
+    bool comes_before(int a, int b);
+    void update(int t);
+    void split(int t, int key_node, int *before, int *after);
+    int merge(int a, int b);
+    int insert_at(int t, int n);
+    int remove_at(int t, int n);
+    template <typename Proc> void visit_overlapping(int t, Key start, Key end, Proc &proc);
+};
+
+template <typename Key, typename Value>
+inline u32 Interval_Tree <Key, Value>::next_priority() {
+    // xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Ties on start are broken by handle, so that every node has a unique position
+// and remove() can walk straight down to it.
+template <typename Key, typename Value>
+inline bool Interval_Tree <Key, Value>::comes_before(int a, int b) {
+    auto na = &nodes[a];
+    auto nb = &nodes[b];
+
+    if (na->start < nb->start) return true;
+    if (na->start == nb->start) return a < b;
+    return false;
+}
+
+template <typename Key, typename Value>
+inline void Interval_Tree <Key, Value>::update(int t) {
+    auto node = &nodes[t];
+    node->max_end = node->end;
+
+    if (node->left >= 0) {
+        Key left_end = nodes[node->left].max_end;
+        if (node->max_end < left_end) node->max_end = left_end;
+    }
+
+    if (node->right >= 0) {
+        Key right_end = nodes[node->right].max_end;
+        if (node->max_end < right_end) node->max_end = right_end;
+    }
+}
+
+template <typename Key, typename Value>
+inline void Interval_Tree <Key, Value>::split(int t, int key_node, int *before, int *after) {
+    if (t < 0) {
+        *before = -1;
+        *after  = -1;
+        return;
+    }
+
+    if (comes_before(t, key_node)) {
+        int right_before, right_after;
+        split(nodes[t].right, key_node, &right_before, &right_after);
+        nodes[t].right = right_before;
+        update(t);
+
+        *before = t;
+        *after  = right_after;
+    } else {
+        int left_before, left_after;
+        split(nodes[t].left, key_node, &left_before, &left_after);
+        nodes[t].left = left_after;
+        update(t);
+
+        *before = left_before;
+        *after  = t;
+    }
+}
+
+template <typename Key, typename Value>
+inline int Interval_Tree <Key, Value>::merge(int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+
+    if (nodes[a].priority > nodes[b].priority) {
+        nodes[a].right = merge(nodes[a].right, b);
+        update(a);
+        return a;
+    } else {
+        nodes[b].left = merge(a, nodes[b].left);
+        update(b);
+        return b;
+    }
+}
+
+template <typename Key, typename Value>
+inline int Interval_Tree <Key, Value>::insert_at(int t, int n) {
+    if (t < 0) return n;
+
+    if (nodes[n].priority > nodes[t].priority) {
+        int before, after;
+        split(t, n, &before, &after);
+        nodes[n].left  = before;
+        nodes[n].right = after;
+        update(n);
+        return n;
+    }
+
+    if (comes_before(n, t)) {
+        int left = insert_at(nodes[t].left, n);
+        nodes[t].left = left;
+    } else {
+        int right = insert_at(nodes[t].right, n);
+        nodes[t].right = right;
+    }
+
+    update(t);
+    return t;
+}
+
+template <typename Key, typename Value>
+inline int Interval_Tree <Key, Value>::remove_at(int t, int n) {
+    assert(t >= 0);
+
+    if (t == n) {
+        return merge(nodes[t].left, nodes[t].right);
+    }
+
+    if (comes_before(n, t)) {
+        int left = remove_at(nodes[t].left, n);
+        nodes[t].left = left;
+    } else {
+        int right = remove_at(nodes[t].right, n);
+        nodes[t].right = right;
+    }
+
+    update(t);
+    return t;
+}
+
+template <typename Key, typename Value>
+inline int Interval_Tree <Key, Value>::insert(Key start, Key end, Value value) {
+    int n;
+    if (free_nodes.count) {
+        n = free_nodes[free_nodes.count - 1];
+        free_nodes.count--;
+    } else {
+        n = nodes.count;
+        nodes.add();
+    }
+
+    auto node = &nodes[n];
+    node->start    = start;
+    node->end      = end;
+    node->max_end  = end;
+    node->value    = value;
+    node->left     = -1;
+    node->right    = -1;
+    node->priority = next_priority();
+
+    root = insert_at(root, n);
+    count++;
+
+    return n;
+}
+
+template <typename Key, typename Value>
+inline void Interval_Tree <Key, Value>::remove(int handle) {
+    root = remove_at(root, handle);
+    free_nodes.add(handle);
+    count--;
+}
+
+template <typename Key, typename Value>
+inline void Interval_Tree <Key, Value>::clear() {
+    nodes.count = 0;
+    free_nodes.count = 0;
+    root  = -1;
+    count = 0;
+}
+
+template <typename Key, typename Value>
+inline typename Interval_Tree <Key, Value>::Node *Interval_Tree <Key, Value>::get(int handle) {
+    return &nodes[handle];
+}
+
+template <typename Key, typename Value>
+template <typename Proc>
+inline void Interval_Tree <Key, Value>::visit_overlapping(int t, Key start, Key end, Proc &proc) {
+    if (t < 0) return;
+    if (!(start < nodes[t].max_end)) return; // Everything in here is over before we start.
+
+    visit_overlapping(nodes[t].left, start, end, proc);
+
+    auto node = &nodes[t];
+    if (!(node->start < end)) return; // This and everything to the right starts after we end.
+
+    if ((start < node->end) && (node->start < node->end)) {
+        proc(t, node);
+    }
+
+    visit_overlapping(node->right, start, end, proc);
+}
+
+template <typename Key, typename Value>
+template <typename Proc>
+inline void Interval_Tree <Key, Value>::for_each_overlapping(Key start, Key end, Proc proc) {
+    if (!(start < end)) return;
+    visit_overlapping(root, start, end, proc);
+}
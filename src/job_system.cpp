@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "job_system.h"
+#include "os_specific.h"
+
+static Array <Thread *> workers;
+static Semaphore *work_available;
+static Semaphore *work_done;
+static volatile bool shutting_down;
+
+// The batch being worked on. Only changes while the workers are waiting.
+static Job_Proc batch_proc;
+static void *batch_data;
+static s32 batch_num_jobs;
+static volatile s32 next_job;
+static bool is_running_batch;
+
+static void do_jobs() {
+    while (true) {
+        s32 job = os_atomic_add(&next_job, 1);
+        if (job >= batch_num_jobs) break;
+        
+        batch_proc(batch_data, job);
+    }
+}
+
+static void worker_proc(void *) {
+    while (true) {
+        os_wait_semaphore(work_available);
+        if (shutting_down) break;
+
+        do_jobs();
+        os_signal_semaphore(work_done);
+    }
+}
+
+void init_job_system(int num_threads) {
+    shutdown_job_system();
+
+    work_available = os_create_semaphore(0);
+    work_done      = os_create_semaphore(0);
+    shutting_down  = false;
+
+    for (int i = 1; i < num_threads; i++) {
+        Thread *thread = os_create_thread(worker_proc, NULL);
+        if (!thread) {
+            log_error("Unable to start worker thread %d of %d.\n", i, num_threads);
+            break;
+        }
+        workers.add(thread);
+    }
+}
+
+void shutdown_job_system() {
+    if (!work_available) return;
+
+    shutting_down = true;
+    os_signal_semaphore(work_available, workers.count);
+    for (auto thread : workers) {
+        os_join_thread(thread);
+    }
+    workers.count = 0;
+
+    os_destroy_semaphore(work_available);
+    os_destroy_semaphore(work_done);
+    work_available = NULL;
+    work_done      = NULL;
+}
+
+int get_job_system_thread_count() {
+    return workers.count + 1;
+}
+
+void run_jobs(Job_Proc proc, void *data, int num_jobs) {
+    if (num_jobs <= 0) return;
+
+    // A job that starts jobs of its own just does them itself.
+    if (!workers.count || num_jobs == 1 || is_running_batch) {
+        for (int i = 0; i < num_jobs; i++) {
+            proc(data, i);
+        }
+        return;
+    }
+
+    is_running_batch = true;
+    
+    batch_proc     = proc;
+    batch_data     = data;
+    batch_num_jobs = num_jobs;
+    next_job       = 0;
+
+    int num_helpers = Min(workers.count, num_jobs - 1);
+    os_signal_semaphore(work_available, num_helpers);
+
+    do_jobs();
+
+    for (int i = 0; i < num_helpers; i++) {
+        os_wait_semaphore(work_done);
+    }
+
+    is_running_batch = false;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+//
+// A few worker threads that help the calling thread go through a batch of jobs.
+// run_jobs() only returns once every job of the batch is done, so jobs can use
+// anything the caller has on its stack. Jobs run in no particular order and on any
+// thread, so give each job its own piece of the output and put the pieces together
+// after run_jobs() returns.
+//
+
+typedef void (*Job_Proc)(void *data, int job_index);
+
+void init_job_system(int num_threads); // Counting the calling thread; 1 means everything runs on the caller.
+void shutdown_job_system();
+int get_job_system_thread_count();
+
+void run_jobs(Job_Proc proc, void *data, int num_jobs);
+
+// Same as above, for lambdas: run_jobs(num_jobs, [&](int job_index) { ... });
+template <typename Proc>
+inline void run_jobs(int num_jobs, Proc proc) {
+    auto call = [](void *data, int job_index) {
+        (*(Proc *)data)(job_index);
+    };
+    run_jobs(call, &proc, num_jobs);
+}
@@ -0,0 +1,497 @@
+#include "pch.h"
+#include "journal.h"
+#include "save_file.h"
+#include "vacation.h"
+#include "os_specific.h"
+
+#include <stdio.h>
+
+//
+// The file starts with a Journal_Header. Every record after it is a u32 size and a u32
+// checksum of the bytes that follow: a Journal_Record_Type and its fields. Employees are
+// referred to by id, which works because the records are replayed over exactly the
+// employees they were written against.
+//
+// Vacations are referred to by their dates, and which of the employee's vacations with
+// those dates it is, since their indices depend on which years were loaded when.
+//
+
+const u32 JOURNAL_MAGIC   = 0x4a434156; // "VACJ"
+const u32 JOURNAL_VERSION = 1;
+
+// Roughly ten thousand changes; replaying them takes a good part of a second on a big roster.
+const s64 JOURNAL_COMPACTION_SIZE = 256 * 1024;
+
+struct Journal_Header {
+    u32 magic;
+    u32 version;
+    u64 snapshot_checksum;
+};
+
+enum Journal_Record_Type : u8 {
+    JOURNAL_ADD_EMPLOYEE = 1,
+    JOURNAL_REMOVE_EMPLOYEE,
+    JOURNAL_RENAME_EMPLOYEE,
+    JOURNAL_SET_EMPLOYEE_TEAM,
+    JOURNAL_SET_EMPLOYEE_SHOWN_ON_HUD,
+    JOURNAL_ADD_VACATION,
+    JOURNAL_EDIT_VACATION_BY_DATES,
+    JOURNAL_REMOVE_VACATION_BY_DATES,
+    JOURNAL_WINDOW_SIZE,
+};
+
+static FILE *journal_file;
+static s64 journal_size;
+static u64 journal_snapshot_checksum; // The one in the open journal's header.
+
+//
+// Writing
+//
+
+static Array <u8> record;
+
+static void put_bytes(void *data, int size) {
+    record.add_n((u8 *)data, size);
+}
+
+static void put_u8(u8 value) {
+    put_bytes(&value, sizeof(value));
+}
+
+static void put_s32(s32 value) {
+    put_bytes(&value, sizeof(value));
+}
+
+static void put_string(char *s) {
+    s32 length = (s32)strlen(s);
+    put_s32(length);
+    put_bytes(s, length);
+}
+
+static void begin_record(Journal_Record_Type type) {
+    record.count = 0;
+    put_u8(type);
+}
+
+// Flushed right away, so that the record survives us crashing; it doesn't wait for the disk.
+static void end_record() {
+    u32 size     = record.count;
+    u32 checksum = (u32)compute_checksum(record.data, record.count);
+
+    fwrite(&size, sizeof(size), 1, journal_file);
+    fwrite(&checksum, sizeof(checksum), 1, journal_file);
+    fwrite(record.data, 1, record.count, journal_file);
+    fflush(journal_file);
+
+    journal_size += sizeof(size) + sizeof(checksum) + record.count;
+}
+
+void journal_window_size(int width, int height) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_WINDOW_SIZE);
+    put_s32(width);
+    put_s32(height);
+    end_record();
+}
+
+void journal_add_employee(Employee *employee) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_ADD_EMPLOYEE);
+    put_string(employee->name);
+    end_record();
+}
+
+void journal_remove_employee(Employee *employee) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_REMOVE_EMPLOYEE);
+    put_s32(employee->id);
+    end_record();
+}
+
+void journal_rename_employee(Employee *employee) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_RENAME_EMPLOYEE);
+    put_s32(employee->id);
+    put_string(employee->name);
+    end_record();
+}
+
+void journal_set_employee_team(Employee *employee) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_SET_EMPLOYEE_TEAM);
+    put_s32(employee->id);
+    put_string(get_team_name(employee->team_id));
+    end_record();
+}
+
+void journal_set_employee_shown_on_hud(Employee *employee) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_SET_EMPLOYEE_SHOWN_ON_HUD);
+    put_s32(employee->id);
+    put_u8(employee->draw_all_vacations_on_hud);
+    end_record();
+}
+
+void journal_add_vacation(Employee *employee, s32 from, s32 to) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_ADD_VACATION);
+    put_s32(employee->id);
+    put_s32(from);
+    put_s32(to);
+    end_record();
+}
+
+// The dates of the vacation, and how many of the employee's vacations before it have the same ones.
+static void put_vacation(Employee *employee, int index) {
+    auto store = &vacation_store;
+    int row = employee->first_vacation + index;
+    s32 start = store->start_day[row];
+    s32 end   = store->end_day[row];
+
+    s32 ordinal = 0;
+    for (int other = employee->first_vacation; other < row; other++) {
+        if (store->start_day[other] == start && store->end_day[other] == end) ordinal += 1;
+    }
+
+    put_s32(employee->id);
+    put_s32(start);
+    put_s32(end);
+    put_s32(ordinal);
+}
+
+void journal_edit_vacation(Employee *employee, int index, s32 from, s32 to) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_EDIT_VACATION_BY_DATES);
+    put_vacation(employee, index);
+    put_s32(from);
+    put_s32(to);
+    end_record();
+}
+
+void journal_remove_vacation(Employee *employee, int index) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_REMOVE_VACATION_BY_DATES);
+    put_vacation(employee, index);
+    end_record();
+}
+
+//
+// Replaying
+//
+
+struct Journal_Reader {
+    u8 *at;
+    u8 *end;
+    bool failed = false;
+};
+
+static void get_bytes(Journal_Reader *reader, void *data, s64 size) {
+    if (reader->failed || reader->end - reader->at < size) {
+        reader->failed = true;
+        memset(data, 0, size);
+        return;
+    }
+
+    memcpy(data, reader->at, size);
+    reader->at += size;
+}
+
+static u8 get_u8(Journal_Reader *reader) {
+    u8 value;
+    get_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static s32 get_s32(Journal_Reader *reader) {
+    s32 value;
+    get_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+// The result lives until the next call.
+static char *get_string(Journal_Reader *reader) {
+    static Array <char> buffer;
+
+    s32 length = get_s32(reader);
+    if (length < 0 || length > reader->end - reader->at) {
+        reader->failed = true;
+        length = 0;
+    }
+
+    buffer.resize(length + 1);
+    get_bytes(reader, buffer.data, length);
+    buffer[length] = 0;
+
+    return buffer.data;
+}
+
+static Employee *get_employee(Journal_Reader *reader) {
+    s32 id = get_s32(reader);
+    if (id < 0 || id >= all_employees.count) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    return all_employees[id];
+}
+
+// Loads the vacation's year, if it isn't loaded yet.
+static int get_vacation_by_dates(Journal_Reader *reader, Employee *employee) {
+    s32 start   = get_s32(reader);
+    s32 end     = get_s32(reader);
+    s32 ordinal = get_s32(reader);
+    if (reader->failed || !employee) {
+        reader->failed = true;
+        return -1;
+    }
+
+    load_vacations_near(start, start, start);
+
+    auto store = &vacation_store;
+    int first = employee->first_vacation;
+    for (int row = first; row < first + employee->num_vacations; row++) {
+        if (store->start_day[row] != start || store->end_day[row] != end) continue;
+        if (ordinal-- == 0) return row - first;
+    }
+
+    reader->failed = true;
+    return -1;
+}
+
+// Reads everything first, so that a damaged record changes nothing.
+static bool apply_record(u8 *data, s64 size, Save_Settings *settings) {
+    Journal_Reader reader;
+    reader.at  = data;
+    reader.end = data + size;
+
+    auto type = (Journal_Record_Type)get_u8(&reader);
+    switch (type) {
+        case JOURNAL_ADD_EMPLOYEE: {
+            char *name = get_string(&reader);
+            if (reader.failed) return false;
+
+            add_employee(name);
+        } break;
+
+        case JOURNAL_REMOVE_EMPLOYEE: {
+            Employee *employee = get_employee(&reader);
+            if (reader.failed) return false;
+
+            remove_employee(employee);
+
+            // Nothing else can be pointing at it this early.
+            if (!employee->name_is_borrowed) delete [] employee->name;
+            delete employee;
+        } break;
+
+        case JOURNAL_RENAME_EMPLOYEE: {
+            Employee *employee = get_employee(&reader);
+            char *name = get_string(&reader);
+            if (reader.failed) return false;
+
+            set_employee_name(employee, copy_string(name));
+        } break;
+
+        case JOURNAL_SET_EMPLOYEE_TEAM: {
+            Employee *employee = get_employee(&reader);
+            char *team = get_string(&reader);
+            if (reader.failed) return false;
+
+            set_employee_team(employee, team);
+        } break;
+
+        case JOURNAL_SET_EMPLOYEE_SHOWN_ON_HUD: {
+            Employee *employee = get_employee(&reader);
+            bool shown = get_u8(&reader) != 0;
+            if (reader.failed) return false;
+
+            set_employee_shown_on_hud(employee, shown);
+        } break;
+
+        case JOURNAL_ADD_VACATION: {
+            Employee *employee = get_employee(&reader);
+            s32 from = get_s32(&reader);
+            s32 to   = get_s32(&reader);
+            if (reader.failed) return false;
+
+            employee->add_vacation_info(from, to);
+        } break;
+
+        case JOURNAL_EDIT_VACATION_BY_DATES: {
+            Employee *employee = get_employee(&reader);
+            int index = get_vacation_by_dates(&reader, employee);
+            s32 from  = get_s32(&reader);
+            s32 to    = get_s32(&reader);
+            if (reader.failed) return false;
+
+            employee->edit_vacation_info(index, from, to);
+        } break;
+
+        case JOURNAL_REMOVE_VACATION_BY_DATES: {
+            Employee *employee = get_employee(&reader);
+            int index = get_vacation_by_dates(&reader, employee);
+            if (reader.failed) return false;
+
+            employee->remove_vacation_info(index);
+        } break;
+
+        case JOURNAL_WINDOW_SIZE: {
+            s32 width  = get_s32(&reader);
+            s32 height = get_s32(&reader);
+            if (reader.failed) return false;
+
+            settings->window_width  = width;
+            settings->window_height = height;
+        } break;
+
+        default: {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Where the records the snapshot doesn't have yet start, or 0 if there are none.
+static s64 find_unsaved_records(u8 *data, s64 size, Save_Settings *settings, char *path) {
+    Journal_Header header;
+    if (size < (s64)sizeof(header)) return 0;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION) {
+        log_error("[journal] '%s' is not a journal we know, so it is ignored.\n", path);
+        return 0;
+    }
+
+    if (header.snapshot_checksum == settings->snapshot_checksum) return sizeof(header);
+
+    // The snapshot was written while this journal was in use, and has the start of it.
+    if (header.snapshot_checksum == settings->journal_base_checksum &&
+        settings->journal_position >= (s64)sizeof(header) && settings->journal_position <= size) {
+        return settings->journal_position;
+    }
+
+    // Left over from an older snapshot; everything in it is in the snapshot already.
+    return 0;
+}
+
+// Goes over the records from 'start' on, applying them if 'apply' is set, and returns
+// where the good ones end.
+static s64 replay_records(u8 *data, s64 start, s64 size, Save_Settings *settings, bool apply, char *path) {
+    begin_batched_changes();
+    defer { end_batched_changes(); };
+
+    u8 *at  = data + start;
+    u8 *end = data + size;
+
+    int num_records = 0;
+    while (end - at >= 8) {
+        u32 record_size, checksum;
+        memcpy(&record_size, at, sizeof(u32));
+        memcpy(&checksum, at + sizeof(u32), sizeof(u32));
+
+        u8 *record_data = at + 8;
+        if (record_size == 0 || record_size > (u64)(end - record_data)) break;
+        if ((u32)compute_checksum(record_data, record_size) != checksum) break;
+        if (apply && !apply_record(record_data, record_size, settings)) break;
+
+        at = record_data + record_size;
+        num_records += 1;
+    }
+
+    if (at != end) {
+        log_error("[journal] '%s' is damaged after %d records; the rest of it is dropped.\n", path, num_records);
+    }
+
+    if (apply) log("[journal] Replayed %d changes from '%s'.\n", num_records, path);
+    return at - data;
+}
+
+static bool start_journal(char *path, Save_Settings *settings, bool apply) {
+    close_journal();
+
+    s64 size = 0;
+    char *data = os_read_entire_file(path, &size);
+    defer { delete [] data; };
+
+    s64 start = 0;
+    s64 good_end = 0;
+    if (data) {
+        start = find_unsaved_records((u8 *)data, size, settings, path);
+        if (start) good_end = replay_records((u8 *)data, start, size, settings, apply, path);
+    }
+
+    bool can_append = start == sizeof(Journal_Header) && good_end == size;
+    if (!can_append) {
+        // A new journal for the current snapshot, with whatever it doesn't have yet.
+        Journal_Header header = {};
+        header.magic   = JOURNAL_MAGIC;
+        header.version = JOURNAL_VERSION;
+        header.snapshot_checksum = settings->snapshot_checksum;
+
+        s64 num_record_bytes = good_end - start;
+
+        Array <u8> buffer;
+        buffer.resize((int)(sizeof(header) + num_record_bytes));
+        memcpy(buffer.data, &header, sizeof(header));
+        if (num_record_bytes) memcpy(buffer.data + sizeof(header), data + start, num_record_bytes);
+
+        char temporary_path[4096];
+        snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path);
+
+        if (!os_write_entire_file(temporary_path, buffer.data, buffer.count) || !os_replace_file(temporary_path, path)) {
+            log_error("[journal] Failed to write '%s'; changes will only be saved in snapshots.\n", path);
+            return false;
+        }
+
+        good_end = buffer.count;
+    }
+
+    journal_file = fopen(path, "ab");
+    if (!journal_file) {
+        log_error("[journal] Failed to open '%s' for writing; changes will only be saved in snapshots.\n", path);
+        return false;
+    }
+
+    journal_size = good_end;
+    journal_snapshot_checksum = settings->snapshot_checksum;
+    return true;
+}
+
+bool open_journal(char *path, Save_Settings *settings) {
+    return start_journal(path, settings, true);
+}
+
+bool restart_journal(char *path, Save_Settings *settings) {
+    return start_journal(path, settings, false);
+}
+
+void note_journal_position(Save_Settings *settings) {
+    settings->journal_base_checksum = journal_file ? journal_snapshot_checksum : 0;
+    settings->journal_position      = journal_file ? journal_size : 0;
+}
+
+void close_journal() {
+    if (!journal_file) return;
+
+    fclose(journal_file);
+    journal_file = NULL;
+    journal_size = 0;
+}
+
+bool journal_has_changes() {
+    return journal_size > (s64)sizeof(Journal_Header);
+}
+
+bool journal_needs_compaction() {
+    return journal_size > JOURNAL_COMPACTION_SIZE;
+}
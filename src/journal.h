@@ -0,0 +1,45 @@
+#pragma once
+
+struct Employee;
+struct Save_Settings;
+
+//
+// save.journal has every change made since save.bin was written, one small record per
+// change, appended as it happens. Starting up replays it over the snapshot, so nothing
+// is lost if we don't get to exit cleanly, and saving doesn't have to rewrite everything.
+//
+// A journal belongs to the snapshot it was started after (by the snapshot's checksum).
+// A snapshot written while a journal is in use remembers how much of it it has, so that
+// until the journal is restarted for the new snapshot, the records after that still count.
+//
+
+// Replays what the loaded snapshot doesn't have yet, and keeps the journal open for
+// appending. Anything after the last complete record is cut off.
+bool open_journal(char *path, Save_Settings *settings);
+
+// After writing a snapshot: starts a journal for it, keeping only the records that came
+// in after the snapshot was serialized.
+bool restart_journal(char *path, Save_Settings *settings);
+
+// Call right before serializing a snapshot.
+void note_journal_position(Save_Settings *settings);
+
+void close_journal();
+
+bool journal_has_changes(); // Since the snapshot it belongs to.
+
+// True once replaying the journal costs more than writing a new snapshot would be worth.
+bool journal_needs_compaction();
+
+void journal_window_size(int width, int height);
+
+// These are for vacation.cpp. They do nothing while no journal is open, which is also
+// the case while one is being replayed.
+void journal_add_employee(Employee *employee);
+void journal_remove_employee(Employee *employee); // Call before it is removed.
+void journal_rename_employee(Employee *employee);
+void journal_set_employee_team(Employee *employee);
+void journal_set_employee_shown_on_hud(Employee *employee);
+void journal_add_vacation(Employee *employee, s32 from, s32 to);
+void journal_edit_vacation(Employee *employee, int index, s32 from, s32 to); // Call before it is changed.
+void journal_remove_vacation(Employee *employee, int index); // Call before it is removed.
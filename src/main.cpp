@@ -3,12 +3,18 @@
 #include "draw.h"
 #include "os_specific.h"
 #include "vacation.h"
-#include "text_file_handler.h"
+#include "save_file.h"
+#include "journal.h"
+#include "benchmark.h"
+#include "job_system.h"
+#include "bulk_import.h"
+#include "exporter.h"
 
 #include "shader_catalog.h"
 #include "texture_catalog.h"
 
 #include <stdio.h>
+#include <limits.h>
 
 static int startup_window_width  = -1;
 static int startup_window_height = -1;
@@ -35,6 +41,8 @@ bool was_key_just_released(int key_code) {
     return key_states[key_code].was_down && !key_states[key_code].is_down;
 }
 
+#if !HEADLESS
+// The window loop's; the headless build has no frames and no autosaving.
 static void update_time() {
     double now = os_get_time();
     double delta = now - globals.time_info.last_time;
@@ -44,10 +52,34 @@ static void update_time() {
     globals.time_info.current_real_world_time += delta;
 }
 
+static void update_frame_work_time(double work_time) {
+    auto info = &globals.time_info;
+    info->frame_work_time = work_time;
+
+    // Smoothed, so that the number on the screen is readable.
+    const double SMOOTHING = 0.05;
+    if (info->average_frame_work_time == 0.0) info->average_frame_work_time = work_time;
+    info->average_frame_work_time += (work_time - info->average_frame_work_time) * SMOOTHING;
+}
+
 static void save_data();
-static void load_data();
+static void save_data_on_exit();
+static void update_autosave();
+#endif
+
+static bool load_data();
+static void write_snapshot(Save_Settings *settings);
+static bool parse_export_filter(int argc, char **argv, Export_Filter *filter);
 
 int main(int argc, char **argv) {
+    init_job_system(os_get_number_of_processors());
+    
+    if (argc > 1 && strings_match(argv[1], "-benchmark")) {
+        os_attach_to_parent_console();
+        os_init_colors_and_utf8();
+        return run_benchmarks(argc - 2, argv + 2);
+    }
+    
     os_init_colors_and_utf8();
 
     {
@@ -62,7 +94,73 @@ int main(int argc, char **argv) {
         os_set_current_working_directory(path);
     }
 
-    load_data();
+    // Paths are relative to the executable, like save.bin is.
+    if (argc > 2 && strings_match(argv[1], "-export")) {
+        os_attach_to_parent_console();
+        if (!load_data()) return 1;
+
+        close_journal();
+
+        Save_Settings settings;
+        settings.window_width  = startup_window_width;
+        settings.window_height = startup_window_height;
+        return export_text(argv[2], &settings) ? 0 : 1;
+    }
+
+    if (argc > 2 && strings_match(argv[1], "-import")) {
+        os_attach_to_parent_console();
+
+        // Replaces what is in save.bin; the journal goes with it, since it belongs to the old one.
+        Save_Settings settings;
+        if (!import_text(argv[2], &settings)) return 1;
+        return save_snapshot("save.bin", &settings) ? 0 : 1;
+    }
+
+    if (argc > 2 && strings_match(argv[1], "-bulk-import")) {
+        os_attach_to_parent_console();
+        if (!load_data()) return 1;
+
+        // Unlike -import, this adds to what is there. It all went to the journal too, but
+        // a big import is better off in the snapshot.
+        Bulk_Import_Result result;
+        bool success = bulk_import(argv[2], &result);
+
+        Save_Settings settings;
+        settings.window_width  = startup_window_width;
+        settings.window_height = startup_window_height;
+        if (success && result.num_added) write_snapshot(&settings);
+
+        close_journal();
+        return success ? 0 : 1;
+    }
+
+    // For payroll: -export-calendar or -export-collisions <path.csv|path.json>, then optionally
+    // -from D.M.Y -to D.M.Y (the end isn't included), -team <name> and -colliding.
+    bool export_calendar_only   = argc > 2 && strings_match(argv[1], "-export-calendar");
+    bool export_collisions_only = argc > 2 && strings_match(argv[1], "-export-collisions");
+    if (export_calendar_only || export_collisions_only) {
+        os_attach_to_parent_console();
+        if (!load_data()) return 1;
+        close_journal();
+
+        Export_Filter filter;
+        if (!parse_export_filter(argc - 3, argv + 3, &filter)) return 1;
+
+        char *path = argv[2];
+        bool success;
+        if (export_calendar_only) success = export_calendar(path, get_export_format(path), &filter);
+        else                      success = export_collision_report(path, get_export_format(path), &filter);
+        return success ? 0 : 1;
+    }
+
+#if HEADLESS
+    // Built without the display system, fonts and shaders, for servers and scripts.
+    log_error("There is no window in this build. Use -benchmark, -import, -export, -bulk-import, -export-calendar or -export-collisions.\n");
+    return 1;
+#else
+    if (!load_data()) {
+        os_show_message_box("Грешка", "save.bin не може да бъде зареден.\nsave.bin и save.journal са оставени както са, а промените няма да се запазват.", true);
+    }
     
     globals.display_system = make_display_system(startup_window_width, startup_window_height, "Отпуски", true);
     defer { delete globals.display_system; };
@@ -85,6 +183,8 @@ int main(int argc, char **argv) {
     while (!globals.should_quit_game) {
         auto sys = globals.display_system;
 
+        temporary_storage.reset(); // Nothing from the last frame is looked at anymore.
+        
         update_time();
         
         for (int i = 0; i < ArrayCount(key_states); i++) {
@@ -117,95 +217,184 @@ int main(int argc, char **argv) {
             handle_event(event);
         }
         
+        double frame_start_time = os_get_time();
         draw_game_view();
+        update_frame_work_time(os_get_time() - frame_start_time);
+        
         sys->swap_buffers();
+
+        update_autosave();
     }
 
-    save_data();
+    save_data_on_exit();
     destroy_fonts();
+    shutdown_job_system();
     
     return 0;
+#endif
 }
 
-const int CURRENT_DATA_FILE_VERSION = 2;
+static bool journaling = false; // Changes go to save.journal as they are made.
+static bool has_loaded_data = false; // If save.bin couldn't be loaded, nothing gets written over it or its journal.
+
+// Autosaving writes a snapshot in the background, which also keeps the journal short.
+const double AUTOSAVE_INTERVAL = 5 * 60; // Seconds.
+const double MIN_TIME_BETWEEN_AUTOSAVES = 10;
+static double last_autosave_time = 0;
+
+static void write_snapshot(Save_Settings *settings) {
+    if (!has_loaded_data) return;
+
+    note_journal_position(settings);
+    if (!save_snapshot("save.bin", settings)) return; // The old snapshot and journal still hold everything.
+
+    journaling = restart_journal("save.journal", settings);
+}
+
+#if !HEADLESS
+static Save_Settings autosave_settings; // Of the one being written.
+
+static void get_window_size(Save_Settings *settings) {
+    auto sys = globals.display_system;
+    if (!sys->maximized) {
+        settings->window_width  = sys->display_width;
+        settings->window_height = sys->display_height;
+    }
+}
 
 static void save_data() {
-    FILE *file = fopen("save.txt", "wb");
-    if (!file) {
-        log_error("Failed to open file 'save.txt' for writing.\n");
+    Save_Settings settings;
+    get_window_size(&settings);
+    write_snapshot(&settings);
+}
+
+static void update_autosave() {
+    if (!has_loaded_data) return;
+
+    double start_time = os_get_time();
+
+    auto state = poll_background_save();
+    if (state == BACKGROUND_SAVE_RUNNING) return;
+
+    if (state == BACKGROUND_SAVE_SUCCEEDED) {
+        journaling = restart_journal("save.journal", &autosave_settings);
+        globals.time_info.save_blocking_time += os_get_time() - start_time;
         return;
     }
-    defer { fclose(file); };
 
-    fprintf(file, "[%d] # Version number do not delete\n", CURRENT_DATA_FILE_VERSION);
+    // A journal that needs compacting doesn't wait as long, but a failing disk shouldn't get retried every frame.
+    double elapsed = start_time - last_autosave_time;
+    bool is_due = elapsed >= AUTOSAVE_INTERVAL && (!journaling || journal_has_changes());
+    if (journal_needs_compaction() && elapsed >= MIN_TIME_BETWEEN_AUTOSAVES) is_due = true;
+    if (!is_due) return;
 
-    auto sys = globals.display_system;
-    if (sys->maximized) {
-        fprintf(file, "%d # Window width; -1 means not set\n", -1);
-        fprintf(file, "%d # Window height; -1 means not set\n", -1);
+    last_autosave_time = start_time;
+
+    autosave_settings = {};
+    get_window_size(&autosave_settings);
+    note_journal_position(&autosave_settings);
+    start_background_save("save.bin", &autosave_settings);
+
+    globals.time_info.save_blocking_time = os_get_time() - start_time;
+}
+
+static void save_data_on_exit() {
+    if (!has_loaded_data) {
+        shutdown_background_saves();
+        return;
+    }
+
+    if (finish_background_save() == BACKGROUND_SAVE_SUCCEEDED) {
+        journaling = restart_journal("save.journal", &autosave_settings);
+    }
+    shutdown_background_saves();
+
+    if (!journaling || journal_needs_compaction()) {
+        save_data();
     } else {
-        fprintf(file, "%d # Window width; -1 means not set\n", sys->display_width);
-        fprintf(file, "%d # Window height; -1 means not set\n", sys->display_height);
+        Save_Settings settings;
+        get_window_size(&settings);
+        journal_window_size(settings.window_width, settings.window_height);
     }
-    
-    fprintf(file, "%d # Number of employees\n", all_employees.count);
-    
-    for (auto employee : all_employees) {
-        fprintf(file, "%s # Employee name\n", employee->name);
-        fprintf(file, "%d # Whether the employee is hidden or not\n", (int)employee->draw_all_vacations_on_hud);
-
-        fprintf(file, "%d # Number of vacations of the current employee\n", employee->vacations.count);
-        for (auto info : employee->vacations) {
-            fprintf(file, "%d.%d.%d %d.%d.%d # StartDate EndDate\n",
-                    info.from_day, info.from_month, info.from_year,
-                    info.to_day, info.to_month, info.to_year);
+
+    close_journal();
+}
+#endif
+
+static bool parse_export_filter(int argc, char **argv, Export_Filter *filter) {
+    for (int i = 0; i < argc; i++) {
+        char *option = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strings_match(option, "-colliding")) {
+            filter->only_colliding = true;
+        } else if ((strings_match(option, "-from") || strings_match(option, "-to")) && has_value) {
+            String text = make_string(argv[++i]);
+            Date date;
+            if (!parse_date(&text, &date) || text.count) {
+                log_error("Expected a date like 1.7.2024 after %s, but got '%s'.\n", option, argv[i]);
+                return false;
+            }
+
+            s32 day_number = date_to_day_number(date.day, date.month, date.year);
+            if (!filter->by_date) {
+                filter->by_date = true;
+                filter->from = INT_MIN;
+                filter->to   = INT_MAX;
+            }
+            if (option[1] == 'f') filter->from = day_number;
+            else                  filter->to   = day_number;
+        } else if (strings_match(option, "-team") && has_value) {
+            char *name = argv[++i];
+
+            // get_team_id would add a team that isn't there.
+            filter->team_id = find_team_id(name);
+            if (filter->team_id < 0) {
+                log_error("There is no team called '%s'.\n", name);
+                return false;
+            }
+        } else {
+            log_error("Unknown option '%s'.\n", option);
+            return false;
         }
     }
+
+    return true;
 }
 
-static void load_data() {
-    Text_File_Handler handler;
-    handler.eat_spaces_before_line = false;
-    handler.start_file("save", "save.txt", "save");
-    if (handler.failed) return;
+// Returns false if save.bin is there but couldn't be loaded. The journal isn't opened
+// then: without its snapshot it would look stale and get emptied. Both files are left
+// as they are, and nothing is saved over them for the rest of the run.
+static bool load_data() {
+    Save_Settings settings;
+
+    if (os_file_exists("save.bin")) {
+        // One collision rebuild for both.
+        begin_batched_changes();
+        bool loaded = load_snapshot("save.bin", &settings);
+        if (loaded) journaling = open_journal("save.journal", &settings);
+        end_batched_changes();
+
+        if (!loaded) {
+            log_error("save.bin couldn't be loaded, so it and save.journal are left as they are and nothing will be saved.\n");
+            return false;
+        }
 
-    if (handler.version == 2) {
-        char *line = handler.consume_next_line();
-        startup_window_width = atoi(line);
+        has_loaded_data = true;
 
-        line = handler.consume_next_line();
-        startup_window_height = atoi(line);
-    }
-    
-    char *line = handler.consume_next_line();
-    int num_employees = atoi(line);
-    all_employees.resize(num_employees);
-
-    for (int i = 0; i < num_employees; i++) {
-        all_employees[i] = new Employee();
-        Employee *employee = all_employees[i];
-        employee->has_vacation_that_overlaps = false;
-        
-        line = handler.consume_next_line();
-        line = eat_spaces(line);
-        line = eat_trailing_spaces(line);
-        employee->name = copy_string(line);
-
-        line = handler.consume_next_line();
-        employee->draw_all_vacations_on_hud = (bool)atoi(line);
-
-        line = handler.consume_next_line();
-        int num_vacations = atoi(line);
-        employee->vacations.resize(num_vacations);
-
-        for (int j = 0; j < num_vacations; j++) {
-            Vacation_Info *info = &employee->vacations[j];
-            info->is_colliding = false;
-            
-            line = handler.consume_next_line();
-            sscanf(line, "%d.%d.%d %d.%d.%d",
-                   &info->from_day, &info->from_month, &info->from_year,
-                   &info->to_day, &info->to_month, &info->to_year);
-        }
+        // A damaged snapshot is written again without the damaged parts, so they are only reported once.
+        if (journal_needs_compaction() || settings.snapshot_was_repaired) write_snapshot(&settings);
+    } else {
+        // save.txt is from before there was a snapshot, and the journal needs one to go on top of.
+        import_text("save.txt", &settings);
+
+        has_loaded_data = true;
+        write_snapshot(&settings);
     }
+
+    startup_window_width  = settings.window_width;
+    startup_window_height = settings.window_height;
+
+    last_autosave_time = os_get_time();
+    return true;
 }
@@ -11,6 +11,13 @@ struct Time_Info {
 
     double current_real_world_time = 0.0;
     double current_dt = 0.0;
+
+    // Time spent building a frame, not counting the wait in swap_buffers.
+    double frame_work_time = 0.0;
+    double average_frame_work_time = 0.0;
+
+    // Time the main thread spent on the last autosave; the writing happens on another thread.
+    double save_blocking_time = 0.0;
 };
 
 struct Globals {
@@ -0,0 +1,420 @@
+#include "pch.h"
+#include "occupancy.h"
+#include "vacation.h"
+#include "save_file.h"
+
+//
+// Every day from first_day on has a count of the people away, and a bit per employee
+// id telling which ones. An employee with overlapping vacations still counts once.
+// The calendar spans whole years, so that most new vacations fall inside it.
+//
+// A bit per employee per day adds up, so the calendar only covers the MAX_CALENDAR_YEARS
+// with the most vacations in them, and fewer if there are so many employees that those
+// would take more than MAX_CALENDAR_BYTES. A vacation typed in as 2205 instead of 2025
+// is then left outside, and days outside are answered from the collision index instead.
+//
+
+const int MAX_CALENDAR_YEARS = 16;
+const s64 MAX_CALENDAR_BYTES = Megabytes(256);
+
+static s32 first_day = 0;
+static int num_days = 0;
+static int words_per_day = 0;
+static bool calendar_is_cut_short = false; // Some vacations have days outside of it.
+
+static Array <s32> absent_counts;
+static Array <u64> absent_bits;
+
+static bool needs_rebuild = true;
+
+static u64 *get_day_bits(s32 day) {
+    return &absent_bits[(day - first_day) * words_per_day];
+}
+
+struct Day_Range {
+    s32 start;
+    s32 end;
+};
+
+static int compare_day_ranges(const void *a, const void *b) {
+    s32 start_a = ((Day_Range *)a)->start;
+    s32 start_b = ((Day_Range *)b)->start;
+    return (start_a > start_b) - (start_a < start_b);
+}
+
+// Merges an employee's own overlapping vacations, so that nobody counts twice.
+static void merge_day_ranges(Array <Day_Range> *ranges) {
+    if (!ranges->count) return;
+
+    qsort(ranges->data, ranges->count, sizeof(Day_Range), compare_day_ranges);
+
+    int num_merged = 1;
+    for (int i = 1; i < ranges->count; i++) {
+        auto last = &(*ranges)[num_merged - 1];
+        if ((*ranges)[i].start <= last->end) {
+            last->end = Max(last->end, (*ranges)[i].end);
+        } else {
+            (*ranges)[num_merged++] = (*ranges)[i];
+        }
+    }
+    ranges->count = num_merged;
+}
+
+static bool is_in_calendar(s32 day) {
+    return day >= first_day && day < first_day + num_days;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int int_a = *(int *)a;
+    int int_b = *(int *)b;
+    return (int_a > int_b) - (int_a < int_b);
+}
+
+// The 'max_years' whole years in a row that the most vacations start in; the later ones
+// if it is a tie. Sets num_days to 0 if there are no vacations.
+static void pick_calendar_years(int max_years) {
+    auto store = &vacation_store;
+
+    static Array <int> years;
+    years.count = 0;
+
+    s32 min_day = 0;
+    s32 max_day = 0;
+    for (int row = 0; row < store->count; row++) {
+        s32 start = store->start_day[row];
+        if (!(start < store->end_day[row])) continue;
+
+        if (!years.count || start < min_day) min_day = start;
+        if (!years.count || start > max_day) max_day = start;
+        years.add(start);
+    }
+
+    first_day = 0;
+    num_days  = 0;
+    calendar_is_cut_short = false;
+    if (!years.count) return;
+
+    // Usually they all fit, and there is nothing to pick.
+    int min_year = day_number_to_date(min_day).year;
+    int max_year = day_number_to_date(max_day).year;
+    if (max_year - min_year < max_years) {
+        first_day = date_to_day_number(1, 1, min_year);
+        num_days  = date_to_day_number(1, 1, Min(max_year + 2, min_year + max_years)) - first_day;
+        return;
+    }
+
+    for (auto &year : years) year = day_number_to_date(year).year;
+    qsort(years.data, years.count, sizeof(int), compare_ints);
+
+    // Slide a window of years over the sorted start years.
+    int best_first = 0;
+    int best_last  = 0;
+
+    int first = 0;
+    for (int last = 0; last < years.count; last++) {
+        while (years[last] - years[first] >= max_years) first += 1;
+        if (last - first >= best_last - best_first) {
+            best_first = first;
+            best_last  = last;
+        }
+    }
+
+    // Vacations that start in the last year can go on into the next one.
+    int first_year = years[best_first];
+    int last_year  = Min(years[best_last] + 1, first_year + max_years - 1);
+    first_day = date_to_day_number(1, 1, first_year);
+    num_days  = date_to_day_number(1, 1, last_year + 1) - first_day;
+    calendar_is_cut_short = best_last - best_first + 1 < years.count;
+}
+
+static void rebuild_occupancy() {
+    needs_rebuild = false;
+
+    auto store = &vacation_store;
+
+    // Leave room for at least one more employee, so that adding one doesn't need a rebuild.
+    words_per_day = all_employees.count / 64 + 1;
+
+    s64 bytes_per_day = (s64)words_per_day * sizeof(u64) + sizeof(s32);
+    s64 max_days = MAX_CALENDAR_BYTES / bytes_per_day;
+    pick_calendar_years((int)Max(Min(max_days / 366, (s64)MAX_CALENDAR_YEARS), (s64)1));
+
+    // At least a year fits unless there are millions of employees; then it gets what fits.
+    if (num_days > max_days) {
+        num_days = (int)max_days;
+        calendar_is_cut_short = true;
+    }
+
+    absent_counts.resize(num_days);
+    absent_bits.resize((int)((s64)num_days * words_per_day));
+    memset(absent_bits.data, 0, absent_bits.count * sizeof(u64));
+
+    // Counts go through a difference array: +1 on the day a stretch of absence starts,
+    // -1 on the day it ends, summed up at the end.
+    static Array <s32> difference;
+    difference.resize(num_days + 1);
+    memset(difference.data, 0, difference.count * sizeof(s32));
+
+    Array <Day_Range> ranges;
+
+    for (auto employee : all_employees) {
+        ranges.count = 0;
+        ranges.reserve(employee->num_vacations);
+
+        int first = employee->first_vacation;
+        for (int row = first; row < first + employee->num_vacations; row++) {
+            Day_Range range = { store->start_day[row], store->end_day[row] };
+            if (range.start < range.end) ranges.add(range);
+        }
+        if (!ranges.count) continue;
+
+        merge_day_ranges(&ranges);
+
+        int word = employee->id / 64;
+        u64 mask = 1ULL << (employee->id % 64);
+
+        for (auto range : ranges) {
+            // Long vacations can run past the years they start in.
+            if (range.start < first_day || range.end > first_day + num_days) {
+                range.start = Max(range.start, first_day);
+                range.end   = Min(range.end, first_day + num_days);
+                calendar_is_cut_short = true;
+                if (!(range.start < range.end)) continue;
+            }
+
+            difference[range.start - first_day] += 1;
+            difference[range.end   - first_day] -= 1;
+
+            for (s32 day = range.start; day < range.end; day++) {
+                get_day_bits(day)[word] |= mask;
+            }
+        }
+    }
+
+    s32 count = 0;
+    for (int i = 0; i < num_days; i++) {
+        count += difference[i];
+        absent_counts[i] = count;
+    }
+}
+
+static void ensure_occupancy() {
+    if (needs_rebuild) rebuild_occupancy();
+}
+
+void invalidate_occupancy() {
+    needs_rebuild = true;
+}
+
+// Cuts the vacation down to the days the calendar has. When the calendar would have been
+// made bigger for it, or there is no bit for the employee, it has to be rebuilt instead.
+static bool fit_in_calendar(s32 *start, s32 *end, s32 employee_id) {
+    if (employee_id >= words_per_day * 64) return false;
+
+    if (*start < first_day || *end > first_day + num_days) {
+        if (!calendar_is_cut_short) return false;
+
+        *start = Max(*start, first_day);
+        *end   = Min(*end, first_day + num_days);
+    }
+    return true;
+}
+
+void occupancy_add_vacation(int row) {
+    if (needs_rebuild) return; // It will be picked up then.
+
+    s32 start = vacation_store.start_day[row];
+    s32 end   = vacation_store.end_day[row];
+    s32 id    = vacation_store.employee_id[row];
+    if (!(start < end)) return;
+
+    if (!fit_in_calendar(&start, &end, id)) {
+        needs_rebuild = true;
+        return;
+    }
+
+    int word = id / 64;
+    u64 mask = 1ULL << (id % 64);
+
+    for (s32 day = start; day < end; day++) {
+        u64 *bits = get_day_bits(day);
+        if (bits[word] & mask) continue; // Already away that day.
+
+        bits[word] |= mask;
+        absent_counts[day - first_day] += 1;
+    }
+}
+
+void occupancy_remove_vacation(int row) {
+    if (needs_rebuild) return;
+
+    auto store = &vacation_store;
+
+    s32 start = store->start_day[row];
+    s32 end   = store->end_day[row];
+    s32 id    = store->employee_id[row];
+    if (!(start < end)) return;
+
+    if (!fit_in_calendar(&start, &end, id)) {
+        needs_rebuild = true;
+        return;
+    }
+
+    // The employee is still away on the days their other vacations cover.
+    auto employee = all_employees[id];
+
+    Array <Day_Range> others;
+    int first = employee->first_vacation;
+    for (int other = first; other < first + employee->num_vacations; other++) {
+        if (other == row) continue;
+
+        Day_Range range = { store->start_day[other], store->end_day[other] };
+        if (Max(range.start, start) < Min(range.end, end)) others.add(range);
+    }
+
+    int word = id / 64;
+    u64 mask = 1ULL << (id % 64);
+
+    for (s32 day = start; day < end; day++) {
+        bool still_away = false;
+        for (auto range : others) {
+            if (range.start <= day && day < range.end) {
+                still_away = true;
+                break;
+            }
+        }
+        if (still_away) continue;
+
+        get_day_bits(day)[word] &= ~mask;
+        absent_counts[day - first_day] -= 1;
+    }
+}
+
+//
+// Days outside of the calendar
+//
+
+struct Day_Change {
+    s32 day;
+    int delta;
+};
+
+static int compare_day_changes(const void *a, const void *b) {
+    s32 day_a = ((Day_Change *)a)->day;
+    s32 day_b = ((Day_Change *)b)->day;
+    return (day_a > day_b) - (day_a < day_b);
+}
+
+static int compare_rows_by_employee(const void *a, const void *b) {
+    int row_a = *(int *)a;
+    int row_b = *(int *)b;
+    s32 id_a = vacation_store.employee_id[row_a];
+    s32 id_b = vacation_store.employee_id[row_b];
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+// Like the calendar, but from what the index has in [from, to), so it takes time in the
+// number of vacations there, however long the range is.
+static void find_days_with_more_absent_than_from_index(int max_absent, s32 from, s32 to, Array <s32> *days) {
+    if (!(from < to)) return;
+
+    auto store = &vacation_store;
+
+    static Array <int> rows;
+    rows.count = 0;
+    find_vacations_between(from, to, &rows);
+    qsort(rows.data, rows.count, sizeof(int), compare_rows_by_employee);
+
+    static Array <Day_Change> changes;
+    changes.count = 0;
+
+    Array <Day_Range> ranges;
+    for (int i = 0; i < rows.count;) {
+        s32 id = store->employee_id[rows[i]];
+
+        ranges.count = 0;
+        for (; i < rows.count && store->employee_id[rows[i]] == id; i++) {
+            Day_Range range = { Max(store->start_day[rows[i]], from), Min(store->end_day[rows[i]], to) };
+            ranges.add(range);
+        }
+        merge_day_ranges(&ranges);
+
+        for (auto range : ranges) {
+            changes.add({ range.start,  1 });
+            changes.add({ range.end,   -1 });
+        }
+    }
+    qsort(changes.data, changes.count, sizeof(Day_Change), compare_day_changes);
+
+    int num_absent = 0;
+    int next = 0;
+    for (s32 day = from; day < to;) {
+        while (next < changes.count && changes[next].day == day) num_absent += changes[next++].delta;
+
+        s32 until = (next < changes.count) ? changes[next].day : to;
+        if (num_absent > max_absent) {
+            for (s32 busy_day = day; busy_day < until; busy_day++) days->add(busy_day);
+        }
+        day = until;
+    }
+}
+
+int get_num_absent_on(s32 day) {
+    load_vacations_between(day, day + 1);
+    ensure_occupancy();
+
+    if (!is_in_calendar(day)) {
+        if (!calendar_is_cut_short) return 0;
+
+        static Array <Employee *> employees;
+        employees.count = 0;
+        find_employees_off_on(day, &employees);
+        return employees.count;
+    }
+    return absent_counts[day - first_day];
+}
+
+bool is_absent_on(Employee *employee, s32 day) {
+    load_vacations_between(day, day + 1);
+    ensure_occupancy();
+
+    int id = employee->id;
+    if (id < 0) return false;
+
+    if (!is_in_calendar(day) || id >= words_per_day * 64) {
+        if (!calendar_is_cut_short) return false;
+
+        int first = employee->first_vacation;
+        for (int row = first; row < first + employee->num_vacations; row++) {
+            if (vacation_store.start_day[row] <= day && day < vacation_store.end_day[row]) return true;
+        }
+        return false;
+    }
+
+    return (get_day_bits(day)[id / 64] & (1ULL << (id % 64))) != 0;
+}
+
+void find_days_with_more_absent_than(int max_absent, s32 from, s32 to, Array <s32> *days) {
+    load_vacations_between(from, to);
+    ensure_occupancy();
+
+    s32 start = Max(from, first_day);
+    s32 end   = Min(to, first_day + num_days);
+    if (!(start < end)) {
+        if (calendar_is_cut_short) find_days_with_more_absent_than_from_index(max_absent, from, to, days);
+        return;
+    }
+
+    if (calendar_is_cut_short) find_days_with_more_absent_than_from_index(max_absent, from, start, days);
+
+    days->reserve(days->count + (end - start));
+    for (s32 day = start; day < end; day++) {
+        if (absent_counts[day - first_day] > max_absent) days->add(day);
+    }
+
+    if (calendar_is_cut_short) find_days_with_more_absent_than_from_index(max_absent, end, to, days);
+}
+
+s64 get_occupancy_bytes() {
+    return (s64)absent_bits.allocated * sizeof(u64) + (s64)absent_counts.allocated * sizeof(s32);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+struct Employee;
+
+//
+// How many people are away on each day, and who. Adding, editing and removing vacations
+// updates it in place; anything bigger (loading, removing employees) throws it away and
+// it gets rebuilt the next time it is asked something. Asking about a day first loads
+// any year that could have someone away on it.
+//
+// The calendar covers at most 16 years, picked where most vacations are. Days outside of
+// it are still answered, from the collision index, just more slowly.
+//
+
+int get_num_absent_on(s32 day);
+bool is_absent_on(Employee *employee, s32 day);
+
+// Adds the days in [from, to) on which more than 'max_absent' people are away to 'days'.
+void find_days_with_more_absent_than(int max_absent, s32 from, s32 to, Array <s32> *days);
+
+// These are for vacation.cpp.
+void occupancy_add_vacation(int row);
+void occupancy_remove_vacation(int row); // Call while the row is still in vacation_store.
+void invalidate_occupancy();
+
+s64 get_occupancy_bytes(); // For the benchmarks.
@@ -0,0 +1,240 @@
+#include "pch.h"
+
+#ifdef __linux__
+
+#include "os_specific.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool os_file_exists(char *filepath) {
+    struct stat st;
+    return stat(filepath, &st) == 0;
+}
+
+bool os_get_file_last_write_time(char *filepath, u64 *modtime_pointer) {
+    struct stat st;
+    if (stat(filepath, &st) != 0) return false;
+
+    if (modtime_pointer) *modtime_pointer = (u64)st.st_mtim.tv_sec * 1000000000ULL + (u64)st.st_mtim.tv_nsec;
+
+    return true;
+}
+
+char *os_read_entire_file(char *filepath, s64 *length_pointer) {
+    int file = open(filepath, O_RDONLY);
+    if (file < 0) return NULL;
+    defer { close(file); };
+
+    struct stat st;
+    if (fstat(file, &st) != 0) return NULL;
+
+    s64 length = st.st_size;
+    char *result = new char[length + 1];
+
+    s64 num_read = 0;
+    while (num_read < length) {
+        ssize_t n = read(file, result + num_read, length - num_read);
+        if (n <= 0) break;
+        num_read += n;
+    }
+    result[num_read] = 0;
+
+    if (length_pointer) *length_pointer = num_read;
+    return result;
+}
+
+bool os_write_entire_file(char *filepath, void *data, s64 size) {
+    int file = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) return false;
+    defer { close(file); };
+
+    u8 *at = (u8 *)data;
+    s64 remaining = size;
+    while (remaining > 0) {
+        ssize_t written = write(file, at, remaining);
+        if (written <= 0) return false;
+
+        at        += written;
+        remaining -= written;
+    }
+
+    return fsync(file) == 0;
+}
+
+bool os_replace_file(char *from, char *to) {
+    if (rename(from, to) != 0) return false;
+
+    // The rename itself only sticks once the directory has been synced.
+    char directory[4096];
+    snprintf(directory, sizeof(directory), "%s", to);
+    char *slash = strrchr(directory, '/');
+    if (slash) slash[slash == directory ? 1 : 0] = 0;
+    else       snprintf(directory, sizeof(directory), ".");
+
+    int dir = open(directory, O_RDONLY | O_DIRECTORY);
+    if (dir < 0) return true; // Renamed, just maybe not durably.
+    defer { close(dir); };
+
+    fsync(dir);
+    return true;
+}
+
+bool os_open_file_view(char *filepath, File_View *view) {
+    int file = open(filepath, O_RDONLY);
+    if (file < 0) return false;
+    defer { close(file); }; // The mapping keeps the file alive.
+
+    struct stat st;
+    if (fstat(file, &st) != 0) return false;
+
+    view->data = NULL;
+    view->size = st.st_size;
+    if (!view->size) return true; // Empty files can't be mapped.
+
+    void *data = mmap(NULL, view->size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED) {
+        view->size = 0;
+        return false;
+    }
+
+    view->data = (u8 *)data;
+    return true;
+}
+
+void os_close_file_view(File_View *view) {
+    if (view->data) munmap(view->data, view->size);
+    view->data = NULL;
+    view->size = 0;
+}
+
+void *os_allocate_pages(s64 size) {
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (memory == MAP_FAILED) ? NULL : memory;
+}
+
+void os_free_pages(void *memory, s64 size) {
+    if (memory) munmap(memory, size);
+}
+
+void os_init_colors_and_utf8() {
+    // Terminals here already do both.
+}
+
+void os_attach_to_parent_console() {
+    // We always have the console we were started from.
+}
+
+char *os_get_path_of_running_executable() {
+    char result[4096];
+    ssize_t len = readlink("/proc/self/exe", result, sizeof(result) - 1);
+    if (len < 0) len = 0;
+    result[len] = 0;
+
+    char *copied_result = new char[len + 1];
+    memcpy(copied_result, result, len + 1);
+    return copied_result;
+}
+
+void os_set_current_working_directory(char *path) {
+    chdir(path);
+}
+
+System_Time os_get_local_time() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    tm local = {};
+    localtime_r(&now.tv_sec, &local);
+
+    System_Time result  = {};
+    result.year         = local.tm_year + 1900;
+    result.month        = local.tm_mon + 1;
+    result.day_of_week  = local.tm_wday;
+    result.day          = local.tm_mday;
+    result.hour         = local.tm_hour;
+    result.minute       = local.tm_min;
+    result.second       = local.tm_sec;
+    result.milliseconds = (int)(now.tv_nsec / 1000000);
+
+    return result;
+}
+
+double os_get_time() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+void os_show_message_box(char *caption, char *text, bool error) {
+    fprintf(error ? stderr : stdout, "%s: %s\n", caption, text);
+}
+
+struct Thread {
+    pthread_t handle;
+    Thread_Proc proc;
+    void *data;
+};
+
+struct Semaphore {
+    sem_t handle;
+};
+
+static void *thread_entry(void *parameter) {
+    Thread *thread = (Thread *)parameter;
+    thread->proc(thread->data);
+    return NULL;
+}
+
+Thread *os_create_thread(Thread_Proc proc, void *data) {
+    Thread *thread = new Thread();
+    thread->proc = proc;
+    thread->data = data;
+
+    if (pthread_create(&thread->handle, NULL, thread_entry, thread) != 0) {
+        delete thread;
+        return NULL;
+    }
+
+    return thread;
+}
+
+void os_join_thread(Thread *thread) {
+    pthread_join(thread->handle, NULL);
+    delete thread;
+}
+
+Semaphore *os_create_semaphore(int initial_count) {
+    Semaphore *semaphore = new Semaphore();
+    sem_init(&semaphore->handle, 0, initial_count);
+    return semaphore;
+}
+
+void os_destroy_semaphore(Semaphore *semaphore) {
+    sem_destroy(&semaphore->handle);
+    delete semaphore;
+}
+
+void os_signal_semaphore(Semaphore *semaphore, int count) {
+    for (int i = 0; i < count; i++) sem_post(&semaphore->handle);
+}
+
+void os_wait_semaphore(Semaphore *semaphore) {
+    while (sem_wait(&semaphore->handle) != 0) {} // Interrupted by a signal.
+}
+
+int os_get_number_of_processors() {
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+s32 os_atomic_add(volatile s32 *value, s32 amount) {
+    return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+}
+
+#endif
@@ -4,7 +4,29 @@ bool os_file_exists(char *filepath);
 bool os_get_file_last_write_time(char *filepath, u64 *modtime_pointer);
 char *os_read_entire_file(char *filepath, s64 *length_pointer = NULL);
 
+// Doesn't return until the data has reached the disk.
+bool os_write_entire_file(char *filepath, void *data, s64 size);
+
+// Moves 'from' over 'to' in one step: anyone opening 'to', even after a crash, finds
+// either the old file or the new one. Both have to be on the same drive.
+bool os_replace_file(char *from, char *to);
+
+// A read-only mapping of a whole file. The data stays valid until the view is closed;
+// don't write to the file through anything else while it is open.
+struct File_View {
+    u8 *data = NULL;
+    s64 size = 0;
+};
+
+bool os_open_file_view(char *filepath, File_View *view);
+void os_close_file_view(File_View *view);
+
+// Zeroed, read-write pages straight from the os. 'size' is rounded up to whole pages.
+void *os_allocate_pages(s64 size);
+void os_free_pages(void *memory, s64 size);
+
 void os_init_colors_and_utf8();
+void os_attach_to_parent_console();
 char *os_get_path_of_running_executable();
 void os_set_current_working_directory(char *path);
 
@@ -24,3 +46,23 @@ System_Time os_get_local_time();
 double os_get_time();
 
 void os_show_message_box(char *caption, char *text, bool error);
+
+//
+// Threads
+//
+
+struct Thread;
+struct Semaphore;
+
+typedef void (*Thread_Proc)(void *data);
+
+Thread *os_create_thread(Thread_Proc proc, void *data);
+void os_join_thread(Thread *thread); // Waits for the thread to finish and frees it.
+
+Semaphore *os_create_semaphore(int initial_count);
+void os_destroy_semaphore(Semaphore *semaphore);
+void os_signal_semaphore(Semaphore *semaphore, int count = 1);
+void os_wait_semaphore(Semaphore *semaphore);
+
+int os_get_number_of_processors();
+s32 os_atomic_add(volatile s32 *value, s32 amount); // Returns the value before the add.
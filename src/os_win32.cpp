@@ -65,8 +65,8 @@ char *os_read_entire_file(char *filepath, s64 *length_pointer) {
         fseek(file, 0, SEEK_SET);
 
         result = new char[length + 1];
-        memset(result, 0, length + 1);
         auto num_read = fread(result, 1, length, file);
+        result[num_read] = 0;
         fclose(file);
 
         if (length_pointer) *length_pointer = num_read;
@@ -74,6 +74,81 @@ char *os_read_entire_file(char *filepath, s64 *length_pointer) {
     return result;
 }
 
+bool os_write_entire_file(char *filepath, void *data, s64 size) {
+    wchar_t wide_filepath[4096];
+    to_windows_filepath(filepath, wide_filepath, ArrayCount(wide_filepath));
+
+    HANDLE file = CreateFileW(wide_filepath, GENERIC_WRITE, 0, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    defer { CloseHandle(file); };
+
+    u8 *at = (u8 *)data;
+    s64 remaining = size;
+    while (remaining > 0) {
+        DWORD to_write = (DWORD)Min(remaining, (s64)(1 << 30));
+        DWORD written = 0;
+        if (!WriteFile(file, at, to_write, &written, NULL) || !written) return false;
+
+        at        += written;
+        remaining -= written;
+    }
+
+    return FlushFileBuffers(file) != 0;
+}
+
+bool os_replace_file(char *from, char *to) {
+    wchar_t wide_from[4096], wide_to[4096];
+    to_windows_filepath(from, wide_from, ArrayCount(wide_from));
+    to_windows_filepath(to,   wide_to,   ArrayCount(wide_to));
+
+    return MoveFileExW(wide_from, wide_to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+bool os_open_file_view(char *filepath, File_View *view) {
+    wchar_t wide_filepath[4096];
+    to_windows_filepath(filepath, wide_filepath, ArrayCount(wide_filepath));
+
+    HANDLE file = CreateFileW(wide_filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    defer { CloseHandle(file); };
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) return false;
+
+    view->data = NULL;
+    view->size = size.QuadPart;
+    if (!view->size) return true; // Empty files can't be mapped.
+
+    // The view keeps the file and the mapping alive after their handles are closed.
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return false;
+    defer { CloseHandle(mapping); };
+
+    view->data = (u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view->data) {
+        view->size = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void os_close_file_view(File_View *view) {
+    if (view->data) UnmapViewOfFile(view->data);
+    view->data = NULL;
+    view->size = 0;
+}
+
+void *os_allocate_pages(s64 size) {
+    return VirtualAlloc(NULL, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void os_free_pages(void *memory, s64 size) {
+    if (memory) VirtualFree(memory, 0, MEM_RELEASE);
+}
+
 void os_init_colors_and_utf8() {
     SetConsoleOutputCP(CP_UTF8);
     HANDLE stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -86,6 +161,15 @@ void os_init_colors_and_utf8() {
     }
 }
 
+// We are a windows subsystem application, so we don't get a console by default.
+// This is for things like -benchmark, which are run from a terminal.
+void os_attach_to_parent_console() {
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+}
+
 char *os_get_path_of_running_executable() {
     wchar_t wide_result[MAX_PATH];
     GetModuleFileNameW(nullptr, wide_result, MAX_PATH);
@@ -142,6 +226,71 @@ void os_show_message_box(char *caption, char *text, bool error) {
     MessageBoxW(NULL, wide_text, wide_caption, flags);
 }
 
+struct Thread {
+    HANDLE handle;
+    Thread_Proc proc;
+    void *data;
+};
+
+struct Semaphore {
+    HANDLE handle;
+};
+
+static DWORD WINAPI thread_entry(LPVOID parameter) {
+    Thread *thread = (Thread *)parameter;
+    thread->proc(thread->data);
+    return 0;
+}
+
+Thread *os_create_thread(Thread_Proc proc, void *data) {
+    Thread *thread = new Thread();
+    thread->proc = proc;
+    thread->data = data;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    
+    if (!thread->handle) {
+        delete thread;
+        return NULL;
+    }
+    
+    return thread;
+}
+
+void os_join_thread(Thread *thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    delete thread;
+}
+
+Semaphore *os_create_semaphore(int initial_count) {
+    Semaphore *semaphore = new Semaphore();
+    semaphore->handle = CreateSemaphoreW(NULL, initial_count, LONG_MAX, NULL);
+    return semaphore;
+}
+
+void os_destroy_semaphore(Semaphore *semaphore) {
+    CloseHandle(semaphore->handle);
+    delete semaphore;
+}
+
+void os_signal_semaphore(Semaphore *semaphore, int count) {
+    ReleaseSemaphore(semaphore->handle, count, NULL);
+}
+
+void os_wait_semaphore(Semaphore *semaphore) {
+    WaitForSingleObject(semaphore->handle, INFINITE);
+}
+
+int os_get_number_of_processors() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+s32 os_atomic_add(volatile s32 *value, s32 amount) {
+    return (s32)InterlockedExchangeAdd((volatile LONG *)value, amount);
+}
+
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     int main(int agrc, char **argv);
     return main(__argc, __argv);
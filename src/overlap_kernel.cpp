@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "overlap_kernel.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define OVERLAP_KERNEL_X64 1
+#else
+#define OVERLAP_KERNEL_X64 0
+#endif
+
+#if OVERLAP_KERNEL_X64
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
+
+Overlap_Kernel_Proc overlaps_any_other_employee;
+Overlap_Kernel_Type overlap_kernel_type = OVERLAP_KERNEL_SCALAR;
+
+// Max(start, other_start) < Min(end, other_end) is the same as every start being
+// before every end, which is what the wide kernels test, since SSE2 has no 32-bit min/max.
+static bool overlaps_any_other_employee_scalar(s32 start, s32 end, s32 employee_id, s32 *starts, s32 *ends, s32 *employee_ids, int count) {
+    if (!(start < end)) return false;
+
+    for (int i = 0; i < count; i++) {
+        if (employee_ids[i] == employee_id) continue;
+        if (Max(start, starts[i]) < Min(end, ends[i])) return true;
+    }
+    return false;
+}
+
+#if OVERLAP_KERNEL_X64
+
+static bool overlaps_any_other_employee_sse2(s32 start, s32 end, s32 employee_id, s32 *starts, s32 *ends, s32 *employee_ids, int count) {
+    if (!(start < end)) return false;
+
+    __m128i s  = _mm_set1_epi32(start);
+    __m128i e  = _mm_set1_epi32(end);
+    __m128i id = _mm_set1_epi32(employee_id);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i hits = _mm_setzero_si128();
+
+        for (int j = 0; j < 8; j += 4) {
+            __m128i other_s  = _mm_loadu_si128((__m128i *)(starts + i + j));
+            __m128i other_e  = _mm_loadu_si128((__m128i *)(ends + i + j));
+            __m128i other_id = _mm_loadu_si128((__m128i *)(employee_ids + i + j));
+
+            __m128i overlap = _mm_and_si128(_mm_cmplt_epi32(s, other_e), _mm_cmplt_epi32(other_s, e));
+            overlap = _mm_and_si128(overlap, _mm_cmplt_epi32(other_s, other_e));
+            overlap = _mm_andnot_si128(_mm_cmpeq_epi32(id, other_id), overlap);
+
+            hits = _mm_or_si128(hits, overlap);
+        }
+
+        if (_mm_movemask_epi8(hits)) return true;
+    }
+
+    return overlaps_any_other_employee_scalar(start, end, employee_id, starts + i, ends + i, employee_ids + i, count - i);
+}
+
+TARGET_AVX2 static bool overlaps_any_other_employee_avx2(s32 start, s32 end, s32 employee_id, s32 *starts, s32 *ends, s32 *employee_ids, int count) {
+    if (!(start < end)) return false;
+
+    __m256i s  = _mm256_set1_epi32(start);
+    __m256i e  = _mm256_set1_epi32(end);
+    __m256i id = _mm256_set1_epi32(employee_id);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i hits = _mm256_setzero_si256();
+
+        for (int j = 0; j < 16; j += 8) {
+            __m256i other_s  = _mm256_loadu_si256((__m256i *)(starts + i + j));
+            __m256i other_e  = _mm256_loadu_si256((__m256i *)(ends + i + j));
+            __m256i other_id = _mm256_loadu_si256((__m256i *)(employee_ids + i + j));
+
+            __m256i overlap = _mm256_and_si256(_mm256_cmpgt_epi32(other_e, s), _mm256_cmpgt_epi32(e, other_s));
+            overlap = _mm256_and_si256(overlap, _mm256_cmpgt_epi32(other_e, other_s));
+            overlap = _mm256_andnot_si256(_mm256_cmpeq_epi32(id, other_id), overlap);
+
+            hits = _mm256_or_si256(hits, overlap);
+        }
+
+        if (_mm256_movemask_epi8(hits)) return true;
+    }
+
+    return overlaps_any_other_employee_scalar(start, end, employee_id, starts + i, ends + i, employee_ids + i, count - i);
+}
+
+static void cpuid(int leaf, int subleaf, int regs[4]) {
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subleaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = (int)a;
+    regs[1] = (int)b;
+    regs[2] = (int)c;
+    regs[3] = (int)d;
+#endif
+}
+
+static u64 read_xcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    u32 low, high;
+    __asm__ volatile ("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((u64)high << 32) | low;
+#endif
+}
+
+#endif
+
+bool is_overlap_kernel_supported(Overlap_Kernel_Type type) {
+    if (type == OVERLAP_KERNEL_SCALAR) return true;
+
+#if OVERLAP_KERNEL_X64
+    int regs[4];
+    cpuid(0, 0, regs);
+    int max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    bool has_sse2    = (regs[3] & (1 << 26)) != 0;
+    bool has_osxsave = (regs[2] & (1 << 27)) != 0;
+    bool has_avx     = (regs[2] & (1 << 28)) != 0;
+
+    if (type == OVERLAP_KERNEL_SSE2) return has_sse2;
+
+    if (type == OVERLAP_KERNEL_AVX2) {
+        if (!has_osxsave || !has_avx || max_leaf < 7) return false;
+        if ((read_xcr0() & 0x6) != 0x6) return false; // The OS has to save the YMM registers for us.
+
+        cpuid(7, 0, regs);
+        return (regs[1] & (1 << 5)) != 0;
+    }
+#endif
+
+    return false;
+}
+
+Overlap_Kernel_Proc get_overlap_kernel(Overlap_Kernel_Type type) {
+#if OVERLAP_KERNEL_X64
+    if (type == OVERLAP_KERNEL_SSE2) return overlaps_any_other_employee_sse2;
+    if (type == OVERLAP_KERNEL_AVX2) return overlaps_any_other_employee_avx2;
+#endif
+    return overlaps_any_other_employee_scalar;
+}
+
+char *get_overlap_kernel_name(Overlap_Kernel_Type type) {
+    switch (type) {
+        case OVERLAP_KERNEL_SCALAR: return "scalar";
+        case OVERLAP_KERNEL_SSE2:   return "sse2";
+        case OVERLAP_KERNEL_AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+void init_overlap_kernel() {
+    overlap_kernel_type = OVERLAP_KERNEL_SCALAR;
+    if (is_overlap_kernel_supported(OVERLAP_KERNEL_SSE2)) overlap_kernel_type = OVERLAP_KERNEL_SSE2;
+    if (is_overlap_kernel_supported(OVERLAP_KERNEL_AVX2)) overlap_kernel_type = OVERLAP_KERNEL_AVX2;
+
+    overlaps_any_other_employee = get_overlap_kernel(overlap_kernel_type);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+//
+// Tests one vacation against a batch of others, several at a time when the CPU allows it.
+// The batch is given as columns, like in vacation_store.
+// Vacations of the same employee never count, and neither do ones that can't collide
+// (start >= end), same as everywhere else.
+//
+// Only the benchmarks use it, to compare against the sweep. The collision flags themselves
+// come from update_collding_for_all_infos, which needs the number of collisions of every
+// vacation, not just whether there is one, and doesn't go quadratic when nothing collides.
+//
+
+enum Overlap_Kernel_Type {
+    OVERLAP_KERNEL_SCALAR,
+    OVERLAP_KERNEL_SSE2,
+    OVERLAP_KERNEL_AVX2,
+};
+
+typedef bool (*Overlap_Kernel_Proc)(s32 start, s32 end, s32 employee_id, s32 *starts, s32 *ends, s32 *employee_ids, int count);
+
+// Returns whether [start, end) overlaps any of the intervals of another employee.
+extern Overlap_Kernel_Proc overlaps_any_other_employee;
+extern Overlap_Kernel_Type overlap_kernel_type;
+
+void init_overlap_kernel(); // Picks the widest kernel the CPU supports. Call before using the above.
+
+bool is_overlap_kernel_supported(Overlap_Kernel_Type type);
+Overlap_Kernel_Proc get_overlap_kernel(Overlap_Kernel_Type type);
+char *get_overlap_kernel_name(Overlap_Kernel_Type type);
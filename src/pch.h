@@ -4,3 +4,4 @@
 #include "geometry.h"
 #include "array.h"
 #include "hash_table.h"
+#include "string_pool.h"
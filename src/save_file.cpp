@@ -0,0 +1,1248 @@
+#include "pch.h"
+#include "save_file.h"
+#include "vacation.h"
+#include "text_file_handler.h"
+#include "os_specific.h"
+
+#include <stdio.h>
+#include <limits.h>
+//
+// Binary snapshot
+//
+// The header is followed by the sections it points to, each starting on an 8 byte
+// boundary: the employees, the teams, the years, and the string table with every name,
+// zero terminated. The header's checksum covers these.
+//
+// After them come the vacations, in one block per year (the year they start in), oldest
+// first. A block starts with an index of its parts, each the rows of EMPLOYEES_PER_PART
+// employees, and then has the employee ids, the start days and the end days of that
+// year's vacations, by employee and then by date. Every block has its own checksum, so
+// that loading the last few years doesn't have to read the rest of the file.
+//
+// Everything that can be left out on its own has a checksum of its own too: the header,
+// each employee, team and year, and each part of a block. Normally the header's and the
+// blocks' checksums match, and only those are computed. When one doesn't, the pieces are
+// checked one by one, and the damaged ones are left out instead of the whole file.
+//
+
+const u32 SNAPSHOT_MAGIC   = 0x53434156; // "VACS"
+const u32 SNAPSHOT_VERSION = 1;
+
+// load_snapshot brings in the years from this many before the current one on, and
+// anything older that reaches into them.
+const int LOADED_YEARS_BEFORE_THIS_ONE = 1;
+
+const u32 EMPLOYEES_PER_PART = 256;
+
+const u32 SNAPSHOT_EMPLOYEE_SHOW_VACATIONS = 0x1;
+
+struct Snapshot_Header {
+    u32 magic;
+    u32 version;
+
+    s32 window_width;
+    s32 window_height;
+
+    u32 num_employees;
+    u32 num_teams;
+    u32 num_years;
+    u32 num_vacations; // In all years.
+    u32 string_table_size;
+    u32 header_checksum; // Of the header, with this set to 0.
+
+    // From the start of the file.
+    u64 employees_offset;
+    u64 teams_offset;
+    u64 years_offset;
+    u64 string_table_offset;
+
+    // How much of which journal is already in here, see Save_Settings.
+    u64 journal_base_checksum;
+    u64 journal_position;
+
+    u64 file_size;
+    u64 checksum; // Of everything after the header, up to the end of the string table.
+};
+
+// The checksums of these are of the record with the checksum set to 0, and then the name.
+struct Snapshot_Employee {
+    u32 name_offset; // Into the string table.
+    u32 team_id;     // Index into the snapshot's teams, not team_names.
+    u32 flags;
+    u32 checksum;
+};
+
+struct Snapshot_Team {
+    u32 name_offset;
+    u32 checksum;
+};
+
+struct Snapshot_Year {
+    s32 year;
+    u32 num_vacations;
+    s32 last_day; // The latest end of any of them, so that queries can tell whether they need the year.
+    u32 num_parts;
+
+    u64 offset;   // Of the block, from the start of the file.
+    u64 checksum; // Of the block.
+
+    u32 entry_checksum; // Of this, with this set to 0.
+    u32 unused;
+};
+
+static u64 align_8(u64 x) {
+    return (x + 7) & ~(u64)7;
+}
+
+// FNV-1a, a word at a time.
+u64 compute_checksum(u8 *data, s64 size, u64 checksum) {
+    s64 i = 0;
+    for (; i + 8 <= size; i += 8) {
+        u64 word;
+        memcpy(&word, data + i, 8);
+        checksum = (checksum ^ word) * 0x100000001b3ULL;
+    }
+    for (; i < size; i++) {
+        checksum = (checksum ^ data[i]) * 0x100000001b3ULL;
+    }
+
+    return checksum;
+}
+
+static bool section_fits(u64 offset, u64 size, u64 file_size) {
+    return (offset <= file_size) && (size <= file_size - offset);
+}
+
+// The low half of compute_checksum only depends on the low halves of the words, so both
+// halves go into the small checksums.
+static u32 fold_checksum(u64 checksum) {
+    return (u32)(checksum ^ (checksum >> 32));
+}
+
+// Of a record with its checksum at the end, set to 0 while it is computed, and optionally a name.
+template <typename T>
+static u32 get_record_checksum(T record, char *name = NULL) {
+    record.checksum = 0;
+    u64 checksum = compute_checksum((u8 *)&record, sizeof(T));
+    if (name) checksum = compute_checksum((u8 *)name, strlen(name) + 1, checksum);
+    return fold_checksum(checksum);
+}
+
+static u32 get_entry_checksum(Snapshot_Year year) {
+    year.entry_checksum = 0;
+    return fold_checksum(compute_checksum((u8 *)&year, sizeof(year)));
+}
+
+static u32 get_header_checksum(Snapshot_Header header) {
+    header.header_checksum = 0;
+    return fold_checksum(compute_checksum((u8 *)&header, sizeof(header)));
+}
+
+// A block without parts, of a snapshot without employees, is one part with everybody in it.
+struct Year_Block {
+    u32 *part_rows;      // num_parts + 1 of them; part i has the rows from part_rows[i] up to part_rows[i + 1].
+    u32 *part_checksums;
+    u32 *employee_ids;
+    s32 *starts;
+    s32 *ends;
+};
+
+static u64 get_part_index_size(u32 num_parts) {
+    if (!num_parts) return 0;
+    return align_8(((u64)num_parts + 1) * sizeof(u32)) + align_8((u64)num_parts * sizeof(u32));
+}
+
+static u64 get_year_block_size(Snapshot_Year *year) {
+    u64 num = year->num_vacations;
+    return get_part_index_size(year->num_parts) + align_8(num * sizeof(u32)) + 2 * align_8(num * sizeof(s32));
+}
+
+static Year_Block get_year_block(u8 *data, Snapshot_Year *year) {
+    u64 num = year->num_vacations;
+    u8 *at = data + year->offset;
+
+    Year_Block block;
+    block.part_rows      = (u32 *)at;
+    block.part_checksums = (u32 *)(at + align_8(((u64)year->num_parts + 1) * sizeof(u32)));
+    at += get_part_index_size(year->num_parts);
+
+    block.employee_ids = (u32 *)at;
+    block.starts       = (s32 *)(at + align_8(num * sizeof(u32)));
+    block.ends         = (s32 *)((u8 *)block.starts + align_8(num * sizeof(s32)));
+    return block;
+}
+
+static u32 get_num_parts(Snapshot_Year *year) {
+    return Max(year->num_parts, 1);
+}
+
+// The rows of a part; if the index is damaged, the ones it says, as long as they are in the block.
+static bool get_part_rows(Year_Block *block, Snapshot_Year *year, u32 part, u32 *first, u32 *last) {
+    if (!year->num_parts) {
+        *first = 0;
+        *last  = year->num_vacations;
+        return true;
+    }
+
+    *first = block->part_rows[part];
+    *last  = block->part_rows[part + 1];
+    return *first <= *last && *last <= year->num_vacations;
+}
+
+static u32 get_part_checksum(Year_Block *block, u32 first, u32 last) {
+    u64 num = last - first;
+    u64 checksum = compute_checksum((u8 *)(block->employee_ids + first), num * sizeof(u32));
+    checksum = compute_checksum((u8 *)(block->starts + first), num * sizeof(s32), checksum);
+    checksum = compute_checksum((u8 *)(block->ends   + first), num * sizeof(s32), checksum);
+    return fold_checksum(checksum);
+}
+
+// Sets 'part_ok' for each part of the year's block and returns how many of them are bad.
+// Whatever the checksums say, the rows have to make sense: every employee's rows in one
+// piece in the right part, and dates the year can have.
+static u32 check_year_block(u8 *data, u64 size, Snapshot_Year *year, u32 num_employees, Array <bool> *part_ok) {
+    u32 num_parts = get_num_parts(year);
+    part_ok->resize(num_parts);
+    for (bool &ok : *part_ok) ok = false;
+
+    u64 max_parts = (num_employees + EMPLOYEES_PER_PART - 1) / EMPLOYEES_PER_PART;
+    if (year->num_parts > max_parts || year->offset % 8 || !section_fits(year->offset, get_year_block_size(year), size)) {
+        return num_parts;
+    }
+
+    auto block = get_year_block(data, year);
+    bool block_ok = compute_checksum(data + year->offset, get_year_block_size(year)) == year->checksum;
+    if (!block_ok && !year->num_parts) return num_parts; // Nothing smaller to check.
+
+    s32 year_start = date_to_day_number(1, 1, year->year);
+    s32 year_end   = date_to_day_number(1, 1, year->year + 1);
+    s32 first_day  = date_to_day_number(1, 1, 1);
+    s32 last_day   = Min(year->last_day, date_to_day_number(1, 1, 10000)); // parse_date takes years up to 9999.
+
+    u32 num_bad = 0;
+    for (u32 part = 0; part < num_parts; part++) {
+        u32 first, last;
+        bool ok = get_part_rows(&block, year, part, &first, &last);
+        if (ok && !block_ok) ok = get_part_checksum(&block, first, last) == block.part_checksums[part];
+
+        u32 first_id = year->num_parts ? part * EMPLOYEES_PER_PART : 0;
+        u32 end_id   = year->num_parts ? Min(first_id + EMPLOYEES_PER_PART, num_employees) : num_employees;
+
+        u32 last_id = first_id;
+        for (u32 row = first; ok && row < last; row++) {
+            u32 id = block.employee_ids[row];
+            s32 start = block.starts[row];
+            s32 end   = block.ends[row];
+
+            ok = id >= last_id && id < end_id;
+            ok = ok && start >= year_start && start < year_end;
+            ok = ok && end >= first_day && end <= last_day;
+            last_id = id;
+        }
+
+        (*part_ok)[part] = ok;
+        if (!ok) num_bad += 1;
+    }
+
+    return num_bad;
+}
+
+static void log_damaged_parts(Snapshot_Year *year, Array <bool> *part_ok, u32 num_employees, char *name_for_errors) {
+    if (!year->num_parts) {
+        log_error("[save] The vacations from %d in '%s' are damaged, so they are left out.\n", year->year, name_for_errors);
+        return;
+    }
+
+    // One line for each run of damaged parts.
+    u32 part = 0;
+    while (part < (u32)part_ok->count) {
+        if ((*part_ok)[part]) {
+            part += 1;
+            continue;
+        }
+
+        u32 first_id = part * EMPLOYEES_PER_PART;
+        while (part < (u32)part_ok->count && !(*part_ok)[part]) part += 1;
+        u32 end_id = Min(part * EMPLOYEES_PER_PART, num_employees);
+
+        log_error("[save] The vacations from %d of employees %u to %u in '%s' are damaged, so they are left out.\n",
+                  year->year, first_id + 1, end_id, name_for_errors);
+    }
+}
+
+//
+// Years that aren't loaded
+//
+// The blocks of the years load_snapshot leaves out stay where they are: in the mapped
+// snapshot, or in archive_buffer once that has to be closed, until the snapshot written
+// in its place is mapped. A block has the vacations that start in its year, so it covers
+// the days from the start of the year to its last_day, and only the ones that share days
+// with what is asked about get loaded. A year is always loaded before a vacation that
+// starts in it is added, so no year is partly loaded.
+//
+
+static Array <Snapshot_Year> unloaded_years; // Oldest first.
+static u8 *unloaded_data; // What their offsets are from.
+static u64 unloaded_size;
+static s32 unloaded_last_day = INT_MIN;
+static char unloaded_path[4096]; // Of the snapshot they came from, for errors.
+
+static Array <u8> archive_buffer;
+
+static void free_archive_buffer() {
+    if (archive_buffer.data) free(archive_buffer.data);
+    archive_buffer.data = NULL;
+    archive_buffer.allocated = 0;
+    archive_buffer.count = 0;
+}
+
+static void note_unloaded_years_changed() {
+    unloaded_last_day = INT_MIN;
+    for (auto &year : unloaded_years) {
+        unloaded_last_day = Max(unloaded_last_day, year.last_day);
+    }
+
+    if (!unloaded_years.count) {
+        unloaded_data = NULL;
+        unloaded_size = 0;
+        free_archive_buffer();
+    }
+}
+
+// Loads the years from first_year to last_year, and the ones with vacations that share a
+// day with [from, to). Parts that turn out to be damaged are left out, and so are lost
+// with the next save; there is nothing better to do with them.
+static void load_unloaded_years(int first_year, int last_year, s32 from, s32 to) {
+    static Array <bool> wanted;
+    wanted.resize(unloaded_years.count);
+
+    u32 total = 0;
+    int num_wanted = 0;
+    for (int i = 0; i < unloaded_years.count; i++) {
+        auto year = &unloaded_years[i];
+        bool shares_days = date_to_day_number(1, 1, year->year) < to && year->last_day > from;
+        wanted[i] = (year->year >= first_year && year->year <= last_year) || shares_days;
+        if (!wanted[i]) continue;
+
+        total += year->num_vacations;
+        num_wanted += 1;
+    }
+    if (!num_wanted) return;
+
+    Array <New_Vacation> vacations;
+    vacations.reserve(total);
+
+    int oldest = INT_MAX;
+    int newest = INT_MIN;
+    static Array <bool> part_ok;
+    for (int i = 0; i < unloaded_years.count; i++) {
+        if (!wanted[i]) continue;
+
+        auto year = &unloaded_years[i];
+        oldest = Min(oldest, year->year);
+        newest = Max(newest, year->year);
+        if (check_year_block(unloaded_data, unloaded_size, year, all_employees.count, &part_ok)) {
+            log_damaged_parts(year, &part_ok, all_employees.count, unloaded_path);
+        }
+
+        auto block = get_year_block(unloaded_data, year);
+        for (u32 part = 0; part < (u32)part_ok.count; part++) {
+            if (!part_ok[part]) continue;
+
+            u32 first_row, last_row;
+            get_part_rows(&block, year, part, &first_row, &last_row);
+            for (u32 row = first_row; row < last_row; row++) {
+                New_Vacation vacation;
+                vacation.employee_id = block.employee_ids[row];
+                vacation.start       = block.starts[row];
+                vacation.end         = block.ends[row];
+                vacations.add(vacation);
+            }
+        }
+    }
+
+    if (num_wanted == 1) log("[save] Loaded %d vacations from %d.\n", vacations.count, oldest);
+    else                 log("[save] Loaded %d vacations from %d years between %d and %d.\n", vacations.count, num_wanted, oldest, newest);
+
+    int num_left = 0;
+    for (int i = 0; i < unloaded_years.count; i++) {
+        if (!wanted[i]) unloaded_years[num_left++] = unloaded_years[i];
+    }
+    unloaded_years.count = num_left;
+    note_unloaded_years_changed();
+
+    add_vacations(&vacations, true);
+}
+
+void load_vacations_between(s32 from, s32 to) {
+    if (unloaded_last_day <= from) return;
+    load_unloaded_years(INT_MAX, INT_MIN, from, to);
+}
+
+void load_vacations_near(s32 first_start, s32 last_start, s32 last_end) {
+    if (!unloaded_years.count) return;
+    load_unloaded_years(day_number_to_date(first_start).year, day_number_to_date(last_start).year, first_start, last_end);
+}
+
+void load_vacations_starting_from(s32 day) {
+    if (!unloaded_years.count) return;
+    load_unloaded_years(day_number_to_date(day).year, INT_MAX, INT_MIN, INT_MIN);
+}
+
+void load_all_vacations() {
+    if (!unloaded_years.count) return;
+    load_unloaded_years(INT_MIN, INT_MAX, INT_MIN, INT_MIN);
+}
+
+int get_newest_unloaded_year() {
+    if (!unloaded_years.count) return 0;
+    return unloaded_years[unloaded_years.count - 1].year;
+}
+
+void forget_unloaded_vacations() {
+    unloaded_years.count = 0;
+    note_unloaded_years_changed();
+}
+
+// Copies the blocks out of the snapshot, so that it can be closed.
+static void archive_unloaded_years() {
+    if (!unloaded_years.count || unloaded_data == archive_buffer.data) return;
+
+    u64 size = 0;
+    for (auto &year : unloaded_years) size += get_year_block_size(&year);
+
+    archive_buffer.resize((int)size);
+
+    u64 offset = 0;
+    for (auto &year : unloaded_years) {
+        u64 block_size = get_year_block_size(&year);
+        memcpy(archive_buffer.data + offset, unloaded_data + year.offset, block_size);
+        year.offset = offset;
+        offset += block_size;
+    }
+
+    unloaded_data = archive_buffer.data;
+    unloaded_size = size;
+}
+
+// Each employee's vacations in the block go by their dates, so that the file only depends
+// on what the vacations are, and not on the order they ended up in after loading and
+// editing. There are only a few per employee in a year.
+static void sort_year_block(u8 *data, Snapshot_Year *year) {
+    auto block = get_year_block(data, year);
+
+    u32 first = 0;
+    while (first < year->num_vacations) {
+        u32 last = first + 1;
+        while (last < year->num_vacations && block.employee_ids[last] == block.employee_ids[first]) last += 1;
+
+        for (u32 i = first + 1; i < last; i++) {
+            s32 start = block.starts[i];
+            s32 end   = block.ends[i];
+
+            u32 j = i;
+            for (; j > first; j--) {
+                s32 other_start = block.starts[j - 1];
+                s32 other_end   = block.ends[j - 1];
+                if (other_start < start || (other_start == start && other_end <= end)) break;
+
+                block.starts[j] = other_start;
+                block.ends[j]   = other_end;
+            }
+            block.starts[j] = start;
+            block.ends[j]   = end;
+        }
+
+        first = last;
+    }
+}
+
+static void write_part_index(u8 *data, Snapshot_Year *year) {
+    auto block = get_year_block(data, year);
+
+    u32 row = 0;
+    for (u32 part = 0; part < year->num_parts; part++) {
+        block.part_rows[part] = row;
+
+        u32 end_id = (part + 1) * EMPLOYEES_PER_PART;
+        while (row < year->num_vacations && block.employee_ids[row] < end_id) row += 1;
+    }
+    block.part_rows[year->num_parts] = row;
+
+    for (u32 part = 0; part < year->num_parts; part++) {
+        block.part_checksums[part] = get_part_checksum(&block, block.part_rows[part], block.part_rows[part + 1]);
+    }
+}
+
+void serialize_snapshot(Array <u8> *buffer, Save_Settings *settings) {
+    auto store = &vacation_store;
+    int num_teams = Max(team_names.count, 1);
+
+    // The loaded vacations go into their years with a counting sort, going through the
+    // employees in order, so that every year ends up by employee.
+    static Array <s32> row_years;
+    row_years.resize(store->count);
+
+    int first_year = INT_MAX;
+    int last_year  = INT_MIN;
+    for (int row = 0; row < store->count; row++) {
+        if (store->employee_id[row] < 0) continue;
+
+        int year = day_number_to_date(store->start_day[row]).year;
+        row_years[row] = year;
+        first_year = Min(first_year, year);
+        last_year  = Max(last_year, year);
+    }
+    int num_spanned = (first_year <= last_year) ? last_year - first_year + 1 : 0;
+
+    static Array <u32> year_counts;
+    static Array <s32> year_last_days;
+    year_counts.resize(num_spanned);
+    year_last_days.resize(num_spanned);
+    for (int i = 0; i < num_spanned; i++) {
+        year_counts[i] = 0;
+        year_last_days[i] = INT_MIN;
+    }
+    for (int row = 0; row < store->count; row++) {
+        if (store->employee_id[row] < 0) continue;
+
+        int i = row_years[row] - first_year;
+        year_counts[i] += 1;
+        year_last_days[i] = Max(year_last_days[i], store->end_day[row]);
+    }
+
+    // The years that aren't loaded go in between the loaded ones, so that the file comes
+    // out the same whatever was loaded.
+    static Array <Snapshot_Year> years;
+    static Array <int> unloaded_index; // Per year; -1 if it is loaded.
+    years.count = 0;
+    unloaded_index.count = 0;
+
+    int next_unloaded = 0;
+    for (int i = 0; i <= num_spanned; i++) {
+        int next_year = (i < num_spanned) ? first_year + i : INT_MAX;
+        while (next_unloaded < unloaded_years.count && unloaded_years[next_unloaded].year < next_year) {
+            years.add(unloaded_years[next_unloaded]);
+            unloaded_index.add(next_unloaded);
+            next_unloaded += 1;
+        }
+        if (i == num_spanned || !year_counts[i]) continue;
+
+        // A year is loaded before anything new goes into it.
+        assert(next_unloaded == unloaded_years.count || unloaded_years[next_unloaded].year != next_year);
+
+        Snapshot_Year year = {};
+        year.year          = next_year;
+        year.num_vacations = year_counts[i];
+        year.last_day      = year_last_days[i];
+        year.num_parts     = (all_employees.count + EMPLOYEES_PER_PART - 1) / EMPLOYEES_PER_PART;
+        years.add(year);
+        unloaded_index.add(-1);
+    }
+
+    u32 string_table_size = 0;
+    for (auto employee : all_employees) {
+        string_table_size += (u32)strlen(employee->name) + 1;
+    }
+    for (int i = 0; i < num_teams; i++) {
+        string_table_size += (u32)strlen(get_team_name(i)) + 1;
+    }
+
+    Snapshot_Header header = {};
+    header.magic         = SNAPSHOT_MAGIC;
+    header.version       = SNAPSHOT_VERSION;
+    header.window_width  = settings->window_width;
+    header.window_height = settings->window_height;
+
+    header.journal_base_checksum = settings->journal_base_checksum;
+    header.journal_position      = settings->journal_position;
+
+    header.num_employees     = all_employees.count;
+    header.num_teams         = num_teams;
+    header.num_years         = years.count;
+    header.string_table_size = string_table_size;
+
+    header.employees_offset    = align_8(sizeof(Snapshot_Header));
+    header.teams_offset        = align_8(header.employees_offset + header.num_employees * sizeof(Snapshot_Employee));
+    header.years_offset        = align_8(header.teams_offset     + header.num_teams * sizeof(Snapshot_Team));
+    header.string_table_offset = align_8(header.years_offset     + header.num_years * sizeof(Snapshot_Year));
+
+    u64 offset = align_8(header.string_table_offset + string_table_size);
+    for (auto &year : years) {
+        year.offset = offset;
+        offset += get_year_block_size(&year);
+        header.num_vacations += year.num_vacations;
+    }
+    header.file_size = offset;
+
+    buffer->resize((int)header.file_size);
+    u8 *data = buffer->data;
+    memset(data, 0, header.file_size);
+
+    char *strings = (char *)(data + header.string_table_offset);
+    u32 string_cursor = 0;
+
+    auto employees = (Snapshot_Employee *)(data + header.employees_offset);
+    for (int i = 0; i < all_employees.count; i++) {
+        auto employee = all_employees[i];
+        auto record = &employees[i];
+
+        record->name_offset = string_cursor;
+        record->team_id     = employee->team_id;
+        record->flags       = employee->draw_all_vacations_on_hud ? SNAPSHOT_EMPLOYEE_SHOW_VACATIONS : 0;
+        record->checksum    = get_record_checksum(*record, employee->name);
+
+        int length = (int)strlen(employee->name) + 1;
+        memcpy(strings + string_cursor, employee->name, length);
+        string_cursor += length;
+    }
+
+    auto teams = (Snapshot_Team *)(data + header.teams_offset);
+    for (int i = 0; i < num_teams; i++) {
+        char *name = get_team_name(i);
+        teams[i].name_offset = string_cursor;
+        teams[i].checksum    = get_record_checksum(teams[i], name);
+
+        int length = (int)strlen(name) + 1;
+        memcpy(strings + string_cursor, name, length);
+        string_cursor += length;
+    }
+
+    // The years that aren't loaded go in as they are, checksums and all.
+    for (int i = 0; i < years.count; i++) {
+        if (unloaded_index[i] < 0) continue;
+        memcpy(data + years[i].offset, unloaded_data + unloaded_years[unloaded_index[i]].offset, get_year_block_size(&years[i]));
+    }
+
+    static Array <Year_Block> blocks;
+    static Array <u32> cursors;
+    blocks.resize(num_spanned);
+    cursors.resize(num_spanned);
+    for (int i = 0; i < years.count; i++) {
+        if (unloaded_index[i] >= 0) continue;
+
+        int spanned = years[i].year - first_year;
+        blocks[spanned]  = get_year_block(data, &years[i]);
+        cursors[spanned] = 0;
+    }
+    for (auto employee : all_employees) {
+        int first = employee->first_vacation;
+        for (int row = first; row < first + employee->num_vacations; row++) {
+            int spanned = row_years[row] - first_year;
+            auto block = &blocks[spanned];
+            u32 cursor = cursors[spanned]++;
+
+            block->employee_ids[cursor] = store->employee_id[row];
+            block->starts[cursor]       = store->start_day[row];
+            block->ends[cursor]         = store->end_day[row];
+        }
+    }
+    for (int i = 0; i < years.count; i++) {
+        if (unloaded_index[i] >= 0) continue;
+
+        sort_year_block(data, &years[i]);
+        write_part_index(data, &years[i]);
+        years[i].checksum = compute_checksum(data + years[i].offset, get_year_block_size(&years[i]));
+    }
+    for (auto &year : years) {
+        year.entry_checksum = get_entry_checksum(year);
+    }
+
+    memcpy(data + header.years_offset, years.data, years.count * sizeof(Snapshot_Year));
+
+    u64 checked_size = header.string_table_offset + string_table_size - sizeof(Snapshot_Header);
+    header.checksum = compute_checksum(data + sizeof(Snapshot_Header), checked_size);
+    header.header_checksum = get_header_checksum(header);
+    memcpy(data, &header, sizeof(Snapshot_Header));
+
+    settings->snapshot_checksum = header.checksum;
+    settings->journal_base_checksum = header.journal_base_checksum;
+    settings->journal_position      = header.journal_position;
+}
+
+// Names of loaded employees point into this, until someone renames them or we save.
+// So do the years that aren't loaded, until then.
+static File_View snapshot_view;
+
+// Gives every employee still pointing into the snapshot a copy of their name, so that
+// the file can be unmapped and written over.
+static void release_snapshot_view() {
+    if (!snapshot_view.data) return;
+
+    for (auto employee : all_employees) {
+        if (!employee->name_is_borrowed) continue;
+
+        employee->name = copy_string(employee->name);
+        employee->name_is_borrowed = false;
+    }
+    archive_unloaded_years();
+
+    os_close_file_view(&snapshot_view);
+}
+
+// Once the snapshot at 'path' has been written, the years that aren't loaded are in it
+// too, so they can be read from there instead of from archive_buffer.
+static void map_saved_snapshot(char *path) {
+    if (!unloaded_years.count || snapshot_view.data) return;
+
+    File_View view;
+    if (!os_open_file_view(path, &view)) return;
+
+    Snapshot_Header header = {};
+    if (view.size >= (s64)sizeof(Snapshot_Header)) memcpy(&header, view.data, sizeof(Snapshot_Header));
+
+    bool usable = header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION && header.file_size == (u64)view.size;
+    usable = usable && section_fits(header.years_offset, (u64)header.num_years * sizeof(Snapshot_Year), view.size);
+    if (!usable) {
+        os_close_file_view(&view);
+        return;
+    }
+
+    // The same years, with the same checksums, just somewhere else.
+    static Array <u64> offsets;
+    offsets.resize(unloaded_years.count);
+
+    auto years = (Snapshot_Year *)(view.data + header.years_offset);
+    for (int i = 0; i < unloaded_years.count; i++) {
+        auto year = &unloaded_years[i];
+
+        offsets[i] = 0;
+        for (u32 j = 0; j < header.num_years; j++) {
+            if (years[j].year != year->year) continue;
+            if (years[j].checksum != year->checksum || years[j].num_vacations != year->num_vacations || years[j].num_parts != year->num_parts) break;
+
+            offsets[i] = years[j].offset;
+        }
+
+        if (!offsets[i]) {
+            os_close_file_view(&view);
+            return;
+        }
+    }
+
+    for (int i = 0; i < unloaded_years.count; i++) {
+        unloaded_years[i].offset = offsets[i];
+    }
+    unloaded_data = view.data;
+    unloaded_size = view.size;
+    snprintf(unloaded_path, sizeof(unloaded_path), "%s", path);
+    free_archive_buffer();
+
+    snapshot_view = view;
+}
+
+// A name in the string table, or NULL if it doesn't end inside of it.
+static char *get_snapshot_string(char *strings, u32 string_table_size, u32 offset) {
+    if (offset >= string_table_size) return NULL;
+    if (!memchr(strings + offset, 0, string_table_size - offset)) return NULL;
+    return strings + offset;
+}
+
+// With 'borrow_names', 'data' stays mapped after this, so the years before the ones
+// that are loaded at startup can be left in it.
+static bool load_snapshot_from_memory(u8 *data, s64 size, Save_Settings *settings, char *name_for_errors, bool borrow_names) {
+    if (size < (s64)sizeof(Snapshot_Header)) {
+        log_error("[save] '%s' is too small to be a snapshot.\n", name_for_errors);
+        return false;
+    }
+
+    Snapshot_Header header;
+    memcpy(&header, data, sizeof(Snapshot_Header));
+
+    if (header.magic != SNAPSHOT_MAGIC) {
+        log_error("[save] '%s' is not a snapshot.\n", name_for_errors);
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        log_error("[save] '%s' has version %u, but we only know version %u.\n", name_for_errors, header.version, SNAPSHOT_VERSION);
+        return false;
+    }
+
+    if (get_header_checksum(header) != header.header_checksum) {
+        log_error("[save] The header of '%s' is damaged, so nothing in it can be found.\n", name_for_errors);
+        return false;
+    }
+    if (header.file_size != (u64)size) {
+        log_error("[save] '%s' should be %llu bytes, but it is %lld.\n", name_for_errors, (unsigned long long)header.file_size, (long long)size);
+        return false;
+    }
+
+    bool fits = true;
+    fits = fits && section_fits(header.employees_offset,    (u64)header.num_employees * sizeof(Snapshot_Employee), size);
+    fits = fits && section_fits(header.teams_offset,        (u64)header.num_teams * sizeof(Snapshot_Team), size);
+    fits = fits && section_fits(header.years_offset,        (u64)header.num_years * sizeof(Snapshot_Year), size);
+    fits = fits && section_fits(header.string_table_offset, header.string_table_size, size);
+    fits = fits && header.string_table_offset >= sizeof(Snapshot_Header);
+    fits = fits && header.num_teams > 0 && header.string_table_size > 0;
+    if (!fits) {
+        log_error("[save] The sections of '%s' don't fit in the file.\n", name_for_errors);
+        return false;
+    }
+
+    u64 checked_size = header.string_table_offset + header.string_table_size - sizeof(Snapshot_Header);
+    bool intact = compute_checksum(data + sizeof(Snapshot_Header), checked_size) == header.checksum;
+    if (!intact) {
+        log_error("[save] '%s' is damaged; what can still be read of it is loaded.\n", name_for_errors);
+    }
+
+    bool repaired = !intact;
+
+    char *strings = (char *)(data + header.string_table_offset);
+    auto employees = (Snapshot_Employee *)(data + header.employees_offset);
+
+    // Whatever is damaged is NULL in here. Damaged employees still get loaded, under a
+    // made up name, so that the ids in the blocks and in the journal still line up.
+    static Array <char *> employee_names;
+    employee_names.resize(header.num_employees);
+    for (u32 i = 0; i < header.num_employees; i++) {
+        auto record = &employees[i];
+        char *name = get_snapshot_string(strings, header.string_table_size, record->name_offset);
+
+        bool ok = name && record->team_id < header.num_teams;
+        if (ok && !intact) ok = get_record_checksum(*record, name) == record->checksum;
+        if (!ok) {
+            log_error("[save] Employee %u of '%s' is damaged; their vacations are kept, but not their name or team.\n", i + 1, name_for_errors);
+            repaired = true;
+        }
+
+        employee_names[i] = ok ? name : NULL;
+    }
+
+    static Array <char *> team_names_in_file;
+    team_names_in_file.resize(header.num_teams);
+    for (u32 i = 0; i < header.num_teams; i++) {
+        Snapshot_Team team;
+        memcpy(&team, data + header.teams_offset + i * sizeof(Snapshot_Team), sizeof(Snapshot_Team));
+        char *name = get_snapshot_string(strings, header.string_table_size, team.name_offset);
+
+        bool ok = name != NULL;
+        if (ok && !intact) ok = get_record_checksum(team, name) == team.checksum;
+        if (!ok) {
+            log_error("[save] Team %u of '%s' is damaged; its people are loaded without a team.\n", i, name_for_errors);
+            repaired = true;
+        }
+
+        team_names_in_file[i] = ok ? name : NULL;
+    }
+
+    static Array <Snapshot_Year> years;
+    years.count = 0;
+    u64 total_vacations = 0;
+    for (u32 i = 0; i < header.num_years; i++) {
+        Snapshot_Year year;
+        memcpy(&year, data + header.years_offset + i * sizeof(Snapshot_Year), sizeof(Snapshot_Year));
+
+        u64 max_parts = (header.num_employees + EMPLOYEES_PER_PART - 1) / EMPLOYEES_PER_PART;
+
+        bool ok = !years.count || years[years.count - 1].year < year.year;
+        ok = ok && year.num_parts <= max_parts && year.offset % 8 == 0 && section_fits(year.offset, get_year_block_size(&year), size);
+        if (ok && !intact) ok = get_entry_checksum(year) == year.entry_checksum;
+        if (!ok) {
+            log_error("[save] The %u. year in '%s' is damaged, so its vacations are left out.\n", i + 1, name_for_errors);
+            repaired = true;
+            continue;
+        }
+
+        years.add(year);
+        total_vacations += year.num_vacations;
+    }
+    if (intact && total_vacations != header.num_vacations) {
+        log_error("[save] The years of '%s' have %llu vacations, but there should be %u.\n", name_for_errors, (unsigned long long)total_vacations, header.num_vacations);
+        return false;
+    }
+
+    // Years that don't reach into the window are left out, unless something is loaded
+    // already; then it has to be all there, for the years to stay in order.
+    int first_loaded = 0;
+    if (borrow_names && !all_employees.count) {
+        int window_year = os_get_local_time().year - LOADED_YEARS_BEFORE_THIS_ONE;
+        s32 window_start = date_to_day_number(1, 1, window_year);
+
+        while (first_loaded < years.count) {
+            auto year = &years[first_loaded];
+            if (year->year >= window_year || year->last_day > window_start) break;
+            first_loaded += 1;
+        }
+    }
+
+    // All parts of all loaded years, one after the other.
+    static Array <bool> part_ok;
+    static Array <int> first_part_ok;
+    part_ok.count = 0;
+    first_part_ok.resize(years.count);
+    for (int i = first_loaded; i < years.count; i++) {
+        static Array <bool> year_part_ok;
+        if (check_year_block(data, size, &years[i], header.num_employees, &year_part_ok)) {
+            log_damaged_parts(&years[i], &year_part_ok, header.num_employees, name_for_errors);
+            repaired = true;
+        }
+
+        first_part_ok[i] = part_ok.count;
+        for (bool ok : year_part_ok) part_ok.add(ok);
+    }
+
+    // Everything that is left checks out; from here on nothing can fail.
+    settings->window_width  = header.window_width;
+    settings->window_height = header.window_height;
+    settings->snapshot_checksum = header.checksum;
+    settings->snapshot_was_repaired = repaired;
+
+    if (all_employees.count) load_all_vacations();
+    else                     forget_unloaded_vacations();
+
+    static Array <int> team_ids;
+    team_ids.resize(header.num_teams);
+    for (u32 i = 0; i < header.num_teams; i++) {
+        team_ids[i] = team_names_in_file[i] ? get_team_id(team_names_in_file[i]) : 0;
+    }
+
+    static Array <Year_Block> blocks;
+    static Array <u32> cursors;
+    blocks.resize(years.count);
+    cursors.resize(years.count);
+    for (int i = first_loaded; i < years.count; i++) {
+        blocks[i]  = get_year_block(data, &years[i]);
+        cursors[i] = 0;
+    }
+
+    all_employees.reserve(all_employees.count + header.num_employees);
+
+    for (u32 i = 0; i < header.num_employees; i++) {
+        auto record = &employees[i];
+        char *name = employee_names[i];
+
+        Employee *employee = new Employee();
+        employee->id = all_employees.count;
+
+        if (!name) {
+            employee->name = mprintf("Служител %u (повреден запис)", i + 1);
+        } else {
+            if (borrow_names) {
+                employee->name = name;
+                employee->name_is_borrowed = true;
+            } else {
+                employee->name = copy_string(name);
+            }
+            employee->team_id = team_ids[record->team_id];
+            employee->draw_all_vacations_on_hud = (record->flags & SNAPSHOT_EMPLOYEE_SHOW_VACATIONS) != 0;
+        }
+
+        // Each part of a year has its employees' rows in one piece each, one employee after the other.
+        employee->first_vacation = vacation_store.count;
+        for (int j = first_loaded; j < years.count; j++) {
+            auto year  = &years[j];
+            auto block = &blocks[j];
+
+            u32 part = year->num_parts ? i / EMPLOYEES_PER_PART : 0;
+            if (part >= get_num_parts(year) || !part_ok[first_part_ok[j] + part]) continue;
+
+            u32 part_first, part_last;
+            get_part_rows(block, year, part, &part_first, &part_last);
+            if (i == part * EMPLOYEES_PER_PART) cursors[j] = part_first;
+
+            u32 first = cursors[j];
+            u32 last  = first;
+            while (last < part_last && block->employee_ids[last] == i) last += 1;
+
+            vacation_store.add_many(block->starts + first, block->ends + first, last - first, employee->id, employee->team_id);
+            employee->num_vacations += last - first;
+            cursors[j] = last;
+        }
+        employee->vacation_capacity = employee->num_vacations;
+
+        all_employees.add(employee);
+    }
+
+    if (first_loaded) {
+        unloaded_years.resize(first_loaded);
+        memcpy(unloaded_years.data, years.data, first_loaded * sizeof(Snapshot_Year));
+        unloaded_data = data;
+        unloaded_size = size;
+        snprintf(unloaded_path, sizeof(unloaded_path), "%s", name_for_errors);
+        note_unloaded_years_changed();
+
+        log("[save] Left the vacations from %d to %d in '%s', until they are needed.\n", years[0].year, years[first_loaded - 1].year, name_for_errors);
+    }
+
+    update_collding_for_all_infos();
+    return true;
+}
+
+bool load_snapshot_from_memory(u8 *data, s64 size, Save_Settings *settings, char *name_for_errors) {
+    return load_snapshot_from_memory(data, size, settings, name_for_errors, false);
+}
+
+// Written next to 'path' first and then moved over it, so a crash halfway through
+// leaves the old file as it was.
+static bool write_file_atomically(char *path, u8 *data, s64 size) {
+    char temporary_path[4096];
+    snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path);
+
+    if (!os_write_entire_file(temporary_path, data, size)) {
+        log_error("[save] Failed to write '%s'.\n", temporary_path);
+        return false;
+    }
+    if (!os_replace_file(temporary_path, path)) {
+        log_error("[save] Failed to move '%s' over '%s'.\n", temporary_path, path);
+        return false;
+    }
+
+    return true;
+}
+
+bool save_snapshot(char *path, Save_Settings *settings) {
+    finish_background_save(); // Or it could finish after us, with older data.
+
+    release_snapshot_view(); // Windows won't replace a file that is mapped.
+
+    Array <u8> buffer;
+    serialize_snapshot(&buffer, settings);
+
+    if (!write_file_atomically(path, buffer.data, buffer.count)) return false;
+
+    map_saved_snapshot(path);
+    return true;
+}
+
+//
+// Saving in the background
+//
+// The snapshot is serialized on the main thread, which is the part that has to see
+// consistent data and is quick, and written out by the writer thread.
+//
+
+static Thread *writer_thread;
+static Semaphore *writer_wakeup;
+static Semaphore *writer_finished;
+static bool writer_should_quit;
+
+// These belong to the writer thread while a save is in flight.
+static char writer_path[4096];
+static Array <u8> writer_buffer;
+static bool writer_succeeded;
+
+static volatile s32 writer_is_busy;
+static bool save_in_flight; // What the main thread thinks; cleared once it has seen the result.
+
+static void writer_thread_proc(void *) {
+    while (true) {
+        os_wait_semaphore(writer_wakeup);
+        if (writer_should_quit) break;
+
+        writer_succeeded = write_file_atomically(writer_path, writer_buffer.data, writer_buffer.count);
+
+        // Cleared first, so that whoever the signal wakes up sees it done.
+        os_atomic_add(&writer_is_busy, -1);
+        os_signal_semaphore(writer_finished);
+    }
+}
+
+bool start_background_save(char *path, Save_Settings *settings) {
+    if (save_in_flight) return false;
+
+    if (!writer_thread) {
+        writer_wakeup   = os_create_semaphore(0);
+        writer_finished = os_create_semaphore(0);
+        writer_thread   = os_create_thread(writer_thread_proc, NULL);
+    }
+
+    release_snapshot_view();
+    serialize_snapshot(&writer_buffer, settings);
+    snprintf(writer_path, sizeof(writer_path), "%s", path);
+
+    save_in_flight = true;
+    os_atomic_add(&writer_is_busy, 1);
+    os_signal_semaphore(writer_wakeup);
+
+    return true;
+}
+
+static Background_Save_State take_save_result() {
+    os_wait_semaphore(writer_finished);
+
+    save_in_flight = false;
+    if (!writer_succeeded) return BACKGROUND_SAVE_FAILED;
+
+    map_saved_snapshot(writer_path);
+    return BACKGROUND_SAVE_SUCCEEDED;
+}
+
+Background_Save_State poll_background_save() {
+    if (!save_in_flight) return BACKGROUND_SAVE_IDLE;
+    if (os_atomic_add(&writer_is_busy, 0)) return BACKGROUND_SAVE_RUNNING;
+
+    return take_save_result(); // Won't block, the writer is done.
+}
+
+Background_Save_State finish_background_save() {
+    if (!save_in_flight) return BACKGROUND_SAVE_IDLE;
+    return take_save_result();
+}
+
+void shutdown_background_saves() {
+    if (!writer_thread) return;
+
+    finish_background_save();
+
+    writer_should_quit = true;
+    os_signal_semaphore(writer_wakeup);
+    os_join_thread(writer_thread);
+    writer_thread = NULL;
+
+    os_destroy_semaphore(writer_wakeup);
+    os_destroy_semaphore(writer_finished);
+    writer_should_quit = false;
+}
+
+bool load_snapshot(char *path, Save_Settings *settings) {
+    release_snapshot_view();
+
+    File_View view;
+    if (!os_open_file_view(path, &view)) {
+        log_error("[save] Failed to open '%s'.\n", path);
+        return false;
+    }
+
+    if (!load_snapshot_from_memory(view.data, view.size, settings, path, true)) {
+        os_close_file_view(&view);
+        return false;
+    }
+
+    snapshot_view = view;
+    return true;
+}
+
+//
+// Text
+//
+
+const int CURRENT_TEXT_FILE_VERSION = 3;
+
+bool export_text(char *path, Save_Settings *settings) {
+    load_all_vacations();
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        log_error("Failed to open file '%s' for writing.\n", path);
+        return false;
+    }
+    defer { fclose(file); };
+
+    fprintf(file, "[%d] # Version number do not delete\n", CURRENT_TEXT_FILE_VERSION);
+
+    fprintf(file, "%d # Window width; -1 means not set\n", settings->window_width);
+    fprintf(file, "%d # Window height; -1 means not set\n", settings->window_height);
+
+    fprintf(file, "%d # Number of employees\n", all_employees.count);
+
+    for (auto employee : all_employees) {
+        fprintf(file, "%s # Employee name\n", employee->name);
+        fprintf(file, "%d # Whether the employee is hidden or not\n", (int)employee->draw_all_vacations_on_hud);
+
+        char *team = get_team_name(employee->team_id);
+        fprintf(file, "%s # Team; - means no team\n", team[0] ? team : "-");
+
+        fprintf(file, "%d # Number of vacations of the current employee\n", employee->num_vacations);
+
+        int first = employee->first_vacation;
+        for (int row = first; row < first + employee->num_vacations; row++) {
+            Date from = day_number_to_date(vacation_store.start_day[row]);
+            Date to   = day_number_to_date(vacation_store.end_day[row]);
+            fprintf(file, "%d.%d.%d %d.%d.%d # StartDate EndDate\n",
+                    from.day, from.month, from.year,
+                    to.day, to.month, to.year);
+        }
+    }
+
+    return true;
+}
+
+bool import_text(char *path, Save_Settings *settings) {
+    load_all_vacations(); // The rows below go in without add_vacations, so everything older has to be there already.
+
+    Text_File_Handler handler;
+    handler.eat_spaces_before_line = false;
+    handler.start_file("save", path, "save");
+    if (handler.failed) return false;
+
+    if (handler.version >= 2) {
+        if (!handler.parse_int(handler.consume_next_line(), &settings->window_width))  return false;
+        if (!handler.parse_int(handler.consume_next_line(), &settings->window_height)) return false;
+    }
+
+    int num_employees = 0;
+    if (!handler.parse_int(handler.consume_next_line(), &num_employees)) return false;
+    if (num_employees < 0) {
+        handler.report_error("The number of employees can't be %d.", num_employees);
+        return false;
+    }
+    all_employees.reserve(all_employees.count + num_employees);
+
+    // Whatever was read before something that can't be made sense of is kept.
+    bool success = true;
+    for (int i = 0; i < num_employees && success; i++) {
+        String line = handler.consume_next_line();
+        if (!line.data) {
+            handler.report_error("Expected the name of employee %d of %d, but the file ended.", i + 1, num_employees);
+            success = false;
+            break;
+        }
+
+        Employee *employee = new Employee();
+        employee->has_vacation_that_overlaps = false;
+        employee->id = all_employees.count;
+        employee->first_vacation = vacation_store.count;
+        all_employees.add(employee);
+
+        line = eat_spaces(line);
+        line = eat_trailing_spaces(line);
+        employee->name = copy_string(line);
+
+        int shown_on_hud = 0;
+        if (!handler.parse_int(handler.consume_next_line(), &shown_on_hud)) {
+            success = false;
+            break;
+        }
+        employee->draw_all_vacations_on_hud = (bool)shown_on_hud;
+
+        if (handler.version >= 3) {
+            line = handler.consume_next_line();
+            line = eat_spaces(line);
+            line = eat_trailing_spaces(line);
+            if (!strings_match(line, "-")) {
+                char *team = copy_string(line); // The pool keeps its own copy.
+                employee->team_id = get_team_id(team);
+                delete [] team;
+            }
+        }
+
+        int num_vacations = 0;
+        if (!handler.parse_int(handler.consume_next_line(), &num_vacations) || num_vacations < 0) {
+            if (num_vacations < 0) handler.report_error("The number of vacations can't be %d.", num_vacations);
+            success = false;
+            break;
+        }
+
+        for (int j = 0; j < num_vacations; j++) {
+            line = handler.consume_next_line();
+            if (!line.data) {
+                handler.report_error("Expected vacation %d of %d, but the file ended.", j + 1, num_vacations);
+                success = false;
+                break;
+            }
+
+            // A bad vacation is left out, but the rest of the employee is still there.
+            Date from, to;
+            if (!handler.parse_date_range(line, &from, &to)) continue;
+
+            vacation_store.add(date_to_day_number(from.day, from.month, from.year),
+                               date_to_day_number(to.day, to.month, to.year),
+                               employee->id, employee->team_id);
+            employee->num_vacations += 1;
+            employee->vacation_capacity += 1;
+        }
+    }
+
+    update_collding_for_all_infos();
+    return success;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+//
+// save.bin is a snapshot of all employees and vacations, laid out so that loading it
+// is one mapping, a checksum and a few copies. Employee names point straight into the
+// mapping (see Employee::name_is_borrowed) until they are renamed or the file is saved
+// over. save.txt, the old text format, is still there to export to and import from.
+//
+// The vacations are stored a year at a time, and load_snapshot only loads the last few
+// years; the older ones stay in the file until something needs them, see below.
+//
+// The loaders add to whatever is loaded already, which is normally nothing.
+//
+
+struct Save_Settings {
+    int window_width  = -1; // -1 means not set.
+    int window_height = -1;
+
+    u64 snapshot_checksum = 0; // Of the snapshot last loaded or written.
+
+    // The snapshot already has the records up to 'journal_position' of the journal that
+    // was started after the snapshot with this checksum. Set by note_journal_position.
+    u64 journal_base_checksum = 0;
+    s64 journal_position = 0;
+
+    bool snapshot_was_repaired = false; // Damaged parts of it were left out when it was loaded.
+};
+
+// Pass what one call returned to the next to checksum several pieces as if they were one.
+u64 compute_checksum(u8 *data, s64 size, u64 checksum = 0xcbf29ce484222325ULL);
+
+void serialize_snapshot(Array <u8> *buffer, Save_Settings *settings);
+bool load_snapshot_from_memory(u8 *data, s64 size, Save_Settings *settings, char *name_for_errors);
+
+// Writes to a temporary file and moves it over 'path' once it is on the disk.
+bool save_snapshot(char *path, Save_Settings *settings);
+bool load_snapshot(char *path, Save_Settings *settings);
+
+enum Background_Save_State {
+    BACKGROUND_SAVE_IDLE,
+    BACKGROUND_SAVE_RUNNING,
+    BACKGROUND_SAVE_SUCCEEDED, // These two are returned once per save.
+    BACKGROUND_SAVE_FAILED,
+};
+
+// Like save_snapshot, except the writing happens on another thread. Returns false
+// without doing anything while the previous one is still going.
+bool start_background_save(char *path, Save_Settings *settings);
+Background_Save_State poll_background_save();
+Background_Save_State finish_background_save(); // Waits for it.
+void shutdown_background_saves();
+
+// Bringing in the years load_snapshot left out. Only the years that are asked about get
+// loaded, so there can be gaps between them. The queries in vacation.h and occupancy.h
+// call these themselves; the collision flags are only up to date for the years that are
+// loaded.
+void load_vacations_between(s32 from, s32 to); // Everything that shares a day with [from, to).
+void load_vacations_starting_from(s32 day);    // Everything from the year 'day' is in on.
+
+// The years of the vacations that start from 'first_start' to 'last_start', and everything
+// that shares a day with [first_start, last_end): what adding, moving or looking up those
+// vacations needs.
+void load_vacations_near(s32 first_start, s32 last_start, s32 last_end);
+void load_all_vacations();
+int get_newest_unloaded_year(); // 0 once everything is loaded.
+void forget_unloaded_vacations(); // For when all employees are thrown away.
+
+bool export_text(char *path, Save_Settings *settings);
+bool import_text(char *path, Save_Settings *settings);
@@ -13,9 +13,15 @@ Shader_Catalog::~Shader_Catalog() {
 }
 
 Shader *Shader_Catalog::get_by_name(char *name) {
-    Shader **_shader = shader_lookup.find(name);
+    return get_by_name(intern_string(name));
+}
+
+Shader *Shader_Catalog::get_by_name(Interned_String interned_name) {
+    Shader **_shader = shader_lookup.find(interned_name);
     if (_shader) return *_shader;
 
+    char *name = get_string(interned_name);
+
     char full_path[4096];
     snprintf(full_path, sizeof(full_path), "%s/%s.fx", SHADER_DIRECTORY, name);
     if (!os_file_exists(full_path)) {
@@ -40,7 +46,7 @@ Shader *Shader_Catalog::get_by_name(char *name) {
     shader->name = copy_string(name);
     shader->modtime = modtime;
     
-    shader_lookup.add(name, shader);
+    shader_lookup.add(interned_name, shader);
     loaded_shaders.add(shader);
     
     return shader;
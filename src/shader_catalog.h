@@ -5,11 +5,12 @@
 struct Shader;
 
 struct Shader_Catalog {
-    String_Hash_Table <Shader *> shader_lookup;
+    Hash_Table <Interned_String, Shader *> shader_lookup;
     Array <Shader *> loaded_shaders;
 
     ~Shader_Catalog();
     
     Shader *get_by_name(char *name);
+    Shader *get_by_name(Interned_String name); // For every frame; this one is an int lookup.
     void do_hotloading();
 };
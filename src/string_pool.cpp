@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "string_pool.h"
+
+struct Interned_Entry {
+    char *data;
+    s64 length;
+    u64 hash;
+};
+
+// What the pool is looked up by; the hash is computed once per lookup.
+struct String_Key {
+    char *data;
+    s64 length;
+    u64 hash;
+};
+
+static inline u64 hash(String_Key key) {
+    return key.hash;
+}
+
+static inline bool keys_match(String_Key a, String_Key b) {
+    return a.hash == b.hash && a.length == b.length && memcmp(a.data, b.data, a.length) == 0;
+}
+
+static Array <Interned_Entry> entries;
+static Hash_Table <String_Key, u32> lookup;
+
+// The text goes into big blocks, so that it doesn't move and isn't one allocation per string.
+const s64 STRING_BLOCK_SIZE = 64 * 1024;
+static char *block_cursor;
+static s64 block_remaining;
+
+static char *copy_into_pool(char *s, s64 length) {
+    s64 size = length + 1;
+
+    char *result;
+    if (size > STRING_BLOCK_SIZE / 4) {
+        result = (char *)malloc(size);
+    } else {
+        if (block_remaining < size) {
+            block_cursor = (char *)malloc(STRING_BLOCK_SIZE);
+            block_remaining = STRING_BLOCK_SIZE;
+        }
+
+        result = block_cursor;
+        block_cursor += size;
+        block_remaining -= size;
+    }
+
+    memcpy(result, s, length);
+    result[length] = 0;
+    return result;
+}
+
+static void init_pool() {
+    Interned_Entry empty;
+    empty.data   = copy_into_pool("", 0);
+    empty.length = 0;
+    empty.hash   = hash("");
+    entries.add(empty);
+}
+
+Interned_String intern_string(char *s, s64 length) {
+    if (!entries.count) init_pool();
+
+    Interned_String result;
+    if (!length) return result;
+
+    String_Key key = { s, length, hash(s, length) };
+    u32 *index = lookup.find(key);
+    if (index) {
+        result.index = *index;
+        return result;
+    }
+
+    Interned_Entry entry;
+    entry.data   = copy_into_pool(s, length);
+    entry.length = length;
+    entry.hash   = key.hash;
+
+    result.index = entries.count;
+    entries.add(entry);
+
+    key.data = entry.data;
+    lookup.add(key, result.index);
+    return result;
+}
+
+Interned_String intern_string(char *s) {
+    return intern_string(s, s ? strlen(s) : 0);
+}
+
+bool find_interned_string(char *s, Interned_String *result) {
+    *result = {};
+
+    s64 length = s ? strlen(s) : 0;
+    if (!length) return true;
+
+    String_Key key = { s, length, hash(s, length) };
+    u32 *index = lookup.find(key);
+    if (!index) return false;
+
+    result->index = *index;
+    return true;
+}
+
+char *get_string(Interned_String s) {
+    if (!s.index) return "";
+    return entries[s.index].data;
+}
+
+s64 get_length(Interned_String s) {
+    if (!s.index) return 0;
+    return entries[s.index].length;
+}
+
+u64 get_hash(Interned_String s) {
+    if (!s.index) return hash("");
+    return entries[s.index].hash;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+//
+// Interned strings. Interning the same text twice gives the same handle, so handles
+// are compared and hashed as ints, and each one has its text's length and hash with
+// it. The text is copied into the pool and stays where it is until the program exits,
+// so this is for names there is only so many of (textures, shaders, fonts, teams),
+// not for whatever the user types.
+//
+
+struct Interned_String {
+    u32 index = 0; // 0 is the empty string.
+
+    inline bool operator==(Interned_String other) const { return index == other.index; }
+    inline bool operator!=(Interned_String other) const { return index != other.index; }
+};
+
+Interned_String intern_string(char *s);
+Interned_String intern_string(char *s, s64 length);
+bool find_interned_string(char *s, Interned_String *result); // Doesn't add it if it isn't there.
+
+char *get_string(Interned_String s); // Zero terminated.
+s64 get_length(Interned_String s);
+u64 get_hash(Interned_String s); // The same as hash() of the text.
+
+inline u64 hash(Interned_String s) {
+    return hash((u64)s.index);
+}
@@ -1,13 +1,156 @@
 #include "pch.h"
 #include "text_file_handler.h"
-#include "os_specific.h"
+#include "vacation.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define TEXT_FILE_HANDLER_SSE2 1 // Every x64 cpu has it.
+#else
+#define TEXT_FILE_HANDLER_SSE2 0
+#endif
+
+#if TEXT_FILE_HANDLER_SSE2
+static inline int lowest_bit_index(u32 mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// The first line break or 'c' in [at, end), or 'end'. This is the only pass over the line.
+static char *find_line_break_or(char *at, char *end, char c) {
+#if TEXT_FILE_HANDLER_SSE2
+    __m128i line_breaks = _mm_set1_epi8('\n');
+    __m128i cs          = _mm_set1_epi8(c);
+
+    while (end - at >= 16) {
+        __m128i bytes = _mm_loadu_si128((__m128i *)at);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, line_breaks), _mm_cmpeq_epi8(bytes, cs)));
+        if (mask) return at + lowest_bit_index(mask);
+        at += 16;
+    }
+#endif
+
+    for (; at < end; at++) {
+        if (*at == '\n' || *at == c) return at;
+    }
+    return end;
+}
+
+#if TEXT_FILE_HANDLER_SSE2
+// Up to 4 digits, as the last 'length' bytes of 'bytes', to a number; all of them at once.
+static inline int four_digits_to_int(u32 bytes, int length) {
+    u32 keep = 0xffffffffu << (8 * (4 - length)); // The first character is the low byte.
+    bytes = (bytes & keep) | (0x30303030u & ~keep);
+    bytes -= 0x30303030u;
+
+    bytes = (bytes * 10 + (bytes >> 8)) & 0x00ff00ffu; // Pairs of digits.
+    bytes = (bytes * 100 + (bytes >> 16)) & 0xffffu;
+    return (int)bytes;
+}
+
+static inline u64 load_u64(char *at) {
+    u64 result;
+    memcpy(&result, at, sizeof(result));
+    return result;
+}
+
+// The 4 bytes of the line before 'end', as four_digits_to_int wants them. Near the
+// start of the line, the ones that would be before it are zeros instead.
+static inline u32 get_four_bytes_before(char *line, int end) {
+    u32 bytes;
+    if (end >= 4) {
+        memcpy(&bytes, line + end - 4, 4);
+    } else {
+        memcpy(&bytes, line, 4); // The line has at least 11 characters.
+        bytes <<= 8 * (4 - end);
+    }
+    return bytes;
+}
+
+// The line every vacation has, "D.M.Y D.M.Y" with nothing else in it, without going
+// character by character: one compare finds where the six fields are. Anything else
+// returns false and goes the slow way, which also says what is wrong with it.
+static bool parse_date_range_quickly(String line, Date *from, Date *to) {
+    const int MAX_LENGTH = 21; // "DD.MM.YYYY DD.MM.YYYY"
+    int count = (int)line.count;
+    if (count < 11 || count > MAX_LENGTH) return false;
+
+    // Nothing is read from outside the line: it is put together in registers as 32 bytes
+    // with zeros after it, the last 8 bytes loaded overlapping the ones before them and
+    // shifted down into place.
+    char *text = line.data;
+    u64 tail = load_u64(text + count - 8);
+
+    u64 word_0 = load_u64(text);
+    u64 word_1 = 0;
+    u64 word_2 = 0;
+    if (count <= 16) {
+        word_1 = tail >> (8 * (16 - count));
+    } else {
+        word_1 = load_u64(text + 8);
+        word_2 = tail >> (8 * (24 - count));
+    }
+
+    __m128i below_zero = _mm_set1_epi8('0' - 1);
+    __m128i above_nine = _mm_set1_epi8('9' + 1);
+    __m128i low  = _mm_set_epi64x((s64)word_1, (s64)word_0);
+    __m128i high = _mm_set_epi64x(0, (s64)word_2);
+    u32 digits = (u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(low,  below_zero), _mm_cmplt_epi8(low,  above_nine)))
+              | ((u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(high, below_zero), _mm_cmplt_epi8(high, above_nine))) << 16);
+
+    u32 separators = ~digits & ((1u << count) - 1);
+
+    // Where each of the six fields ends.
+    int e0 = lowest_bit_index(separators | 0x80000000u); separators &= separators - 1;
+    int e1 = lowest_bit_index(separators | 0x80000000u); separators &= separators - 1;
+    int e2 = lowest_bit_index(separators | 0x80000000u); separators &= separators - 1;
+    int e3 = lowest_bit_index(separators | 0x80000000u); separators &= separators - 1;
+    int e4 = lowest_bit_index(separators | 0x80000000u); separators &= separators - 1;
+    int e5 = count;
+    if (separators || e4 >= e5) return false; // Too many of them, or too few.
+
+    if (text[e0] != '.' || text[e1] != '.' || text[e2] != ' ' || text[e3] != '.' || text[e4] != '.') return false;
+
+    int l0 = e0, l1 = e1 - e0 - 1, l2 = e2 - e1 - 1, l3 = e3 - e2 - 1, l4 = e4 - e3 - 1, l5 = e5 - e4 - 1;
+    if (l0 < 1 || l0 > 2 || l1 < 1 || l1 > 2 || l2 < 1 || l2 > 4) return false;
+    if (l3 < 1 || l3 > 2 || l4 < 1 || l4 > 2 || l5 < 1 || l5 > 4) return false;
+
+    from->day   = four_digits_to_int(get_four_bytes_before(text, e0), l0);
+    from->month = four_digits_to_int(get_four_bytes_before(text, e1), l1);
+    from->year  = four_digits_to_int(get_four_bytes_before(text, e2), l2);
+    to->day     = four_digits_to_int(get_four_bytes_before(text, e3), l3);
+    to->month   = four_digits_to_int(get_four_bytes_before(text, e4), l4);
+    to->year    = four_digits_to_int(get_four_bytes_before(text, e5), l5);
+
+    // Every month has the first 28 days, so most dates don't need the whole check.
+    bool from_is_surely_valid = from->day >= 1 && from->day <= 28 && from->month >= 1 && from->month <= 12 && from->year >= 1;
+    bool to_is_surely_valid   = to->day   >= 1 && to->day   <= 28 && to->month   >= 1 && to->month   <= 12 && to->year   >= 1;
+    if (!from_is_surely_valid && !is_valid_date(from->day, from->month, from->year)) return false;
+    if (!to_is_surely_valid   && !is_valid_date(to->day,   to->month,   to->year))   return false;
+
+    return true;
+}
+#endif
+
+static char *find_line_break(char *at, char *end) {
+    char *line_break = (char *)memchr(at, '\n', end - at);
+    return line_break ? line_break : end;
+}
+
 Text_File_Handler::~Text_File_Handler() {
-    delete [] orig_file_data;
+    if (file) fclose(file);
 }
 
 void Text_File_Handler::start_file(char *_short_name, char *_full_path, char *_log_agent) {
@@ -15,81 +158,232 @@ void Text_File_Handler::start_file(char *_short_name, char *_full_path, char *_l
     full_path = _full_path;
     log_agent = _log_agent;
 
-    bool success = false;
-    file_data = os_read_entire_file(full_path);
-    orig_file_data = file_data;
-
-    if (!file_data) {
+    file = fopen(full_path, "rb");
+    if (!file) {
         log_error("[%s] Unable to load file '%s'.\n", log_agent, full_path);
         failed = true;
         return;
     }
 
-    if (do_version_number) {
-        char *line = consume_next_line();
-        assert(line);
-        
-        if (!line) {
-            log_error("[%s] Unable to find a version number at the top of file '%s'!\n", log_agent, full_path);
-            failed = true;
-            return;
+    at  = chunk;
+    end = chunk;
+
+    read_version_number();
+}
+
+void Text_File_Handler::start_memory(char *_short_name, char *data, s64 size, char *_log_agent) {
+    short_name = _short_name;
+    full_path = _short_name;
+    log_agent = _log_agent;
+
+    at  = data;
+    end = data + size;
+
+    read_version_number();
+}
+
+void Text_File_Handler::read_version_number() {
+    if (!do_version_number) return;
+
+    String line = consume_next_line();
+    if (!line.data) {
+        log_error("[%s] Unable to find a version number at the top of file '%s'!\n", log_agent, full_path);
+        failed = true;
+        return;
+    }
+
+    if (line.data[0] != '[') {
+        log_error("[%s] Expected '[' at the top of file '%s', but did not get it!\n", log_agent, full_path);
+        failed = true;
+        return;
+    }
+
+    version = string_to_int(advance(line, 1));
+}
+
+// Moves what is left to the front of the chunk and reads more after it. Returns false
+// if nothing more could be read.
+bool Text_File_Handler::refill() {
+    if (!file) return false;
+
+    s64 remaining = end - at;
+    if (remaining == CHUNK_SIZE) return false;
+
+    memmove(chunk, at, remaining);
+    size_t num_read = fread(chunk + remaining, 1, CHUNK_SIZE - remaining, file);
+
+    at  = chunk;
+    end = chunk + remaining + num_read;
+
+    if (!num_read) {
+        fclose(file);
+        file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+// The next line without its line break, and without its comment if we strip those.
+// The data is NULL at the end of the file.
+String Text_File_Handler::next_raw_line() {
+    // The rest of a comment that went past the end of the last chunk.
+    while (in_comment) {
+        at = find_line_break(at, end);
+        if (at < end) {
+            at += 1;
+            in_comment = false;
+        } else if (!refill()) {
+            in_comment = false;
         }
+    }
+
+    if (at == end && !refill()) return String();
 
-        assert(line);
-        if (line[0] != '[') {
-            log_error("[%s] Expected '[' at the top of file '%s', but did not get it!\n", log_agent, full_path);
-            failed = true;
-            return;
+    // Scan until there's a whole line in the chunk, without going over the same bytes twice.
+    s64 scanned = 0;
+    char *stop;
+    while (true) {
+        if (strip_comments_from_end_of_lines) stop = find_line_break_or(at + scanned, end, comment_character);
+        else                                  stop = find_line_break(at + scanned, end);
+
+        if (stop < end || !file) break;
+
+        scanned = end - at;
+        if (!refill()) {
+            if (file) report_error("Line is longer than %d bytes; the rest of it is read as the next line.", CHUNK_SIZE);
+            stop = end;
+            break;
         }
+    }
 
-        line += 1;
+    String line = make_string(at, stop - at);
 
-        version = atoi(line);
+    if (stop == end) {
+        at = end;
+    } else if (*stop == '\n') {
+        at = stop + 1;
+    } else {
+        // A comment. Skipping it must not refill the chunk, since 'line' points into it.
+        char *line_break = find_line_break(stop, end);
+        if (line_break < end) {
+            at = line_break + 1;
+        } else {
+            at = end;
+            in_comment = (file != NULL);
+        }
     }
+
+    if (line.count && line.data[line.count - 1] == '\r') line.count -= 1;
+
+    return line;
 }
 
-char *Text_File_Handler::consume_next_line() {
+String Text_File_Handler::consume_next_line() {
     while (true) {
-        char *line = ::consume_next_line(&file_data);
-        if (!line) return nullptr;
-        
+        String line = next_raw_line();
+        if (!line.data) return line;
+
         line_number += 1;
 
         if (eat_spaces_before_line) {
             line = eat_spaces(line);
         }
 
-        if (!line || line[0] == 0) continue;
+        if (!line.count) continue;
+
+        if (!strip_comments_from_end_of_lines && line.data[0] == comment_character) continue;
 
-        if (strip_comments_from_end_of_lines) {
-            //char *rhs = find_character_from_left(line, comment_character);
-            char *rhs = strchr(line, comment_character);
-            if (rhs) {
-                char *orig_line = line;
-                line[strlen(orig_line) - strlen(rhs)] = 0;
-                if (strlen(line) == 0) continue;
-            }
-        } else {
-            if (line[0] == comment_character) continue;
-        }
-        
         if (eat_spaces_before_line) {
             line = eat_trailing_spaces(line);
         }
-        
-        assert(strlen(line) > 0);
+
+        if (!line.count) continue;
 
         return line;
     }
 }
 
-void Text_File_Handler::report_error(char *fmt, ...) {
+static void report_error_valist(Text_File_Handler *handler, int line_number, char *fmt, va_list args) {
     char buf[4096];
-    
+    vsnprintf(buf, sizeof(buf), fmt, args);
+
+    log_error("Error in line %d of file '%s': %s\n", line_number, handler->full_path, buf);
+}
+
+void Text_File_Handler::report_error(char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, args);
+    report_error_valist(this, line_number, fmt, args);
     va_end(args);
+}
+
+void Text_File_Handler::report_error_at(int line_number, char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    report_error_valist(this, line_number, fmt, args);
+    va_end(args);
+}
+
+// Called for every field, so it stays away from isspace.
+static String trim_blanks(String s) {
+    while (s.count && (s.data[0] == ' ' || s.data[0] == '\t')) { s.data += 1; s.count -= 1; }
+    while (s.count && (s.data[s.count - 1] == ' ' || s.data[s.count - 1] == '\t')) s.count -= 1;
+    return s;
+}
+
+bool Text_File_Handler::parse_int(String line, int *result) {
+    if (!line.data) {
+        report_error("Expected a number, but the file ended.");
+        return false;
+    }
+
+    String at = trim_blanks(line);
+    if (!::parse_int(&at, result)) {
+        report_error("Expected a number at column %d, but found '%.*s'.", (int)(at.data - line.data) + 1, (int)line.count, line.data);
+        return false;
+    }
+
+    if (at.count) {
+        report_error("Unexpected '%.*s' after the number at column %d.", (int)at.count, at.data, (int)(at.data - line.data) + 1);
+        return false;
+    }
+
+    return true;
+}
+
+bool Text_File_Handler::parse_date_range(String line, Date *from, Date *to) {
+    if (!line.data) {
+        report_error("Expected two dates, but the file ended.");
+        return false;
+    }
+
+    String at = trim_blanks(line);
+
+#if TEXT_FILE_HANDLER_SSE2
+    if (parse_date_range_quickly(at, from, to)) return true;
+#endif
+
+    if (!parse_date(&at, from)) {
+        report_error("Expected a valid D.M.Y date at column %d, but found '%.*s'.", (int)(at.data - line.data) + 1, (int)line.count, line.data);
+        return false;
+    }
+
+    if (at.count && at.data[0] != ' ' && at.data[0] != '\t') {
+        report_error("Expected a space between the dates at column %d, but found '%.*s'.", (int)(at.data - line.data) + 1, (int)line.count, line.data);
+        return false;
+    }
+    at = trim_blanks(at);
+
+    if (!parse_date(&at, to)) {
+        report_error("Expected a valid D.M.Y date at column %d, but found '%.*s'.", (int)(at.data - line.data) + 1, (int)line.count, line.data);
+        return false;
+    }
+
+    if (at.count) {
+        report_error("Unexpected '%.*s' after the dates at column %d.", (int)at.count, at.data, (int)(at.data - line.data) + 1);
+        return false;
+    }
 
-    log_error("Error in line %d of file '%s': %s\n", line_number, full_path, buf);
+    return true;
 }
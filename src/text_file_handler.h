@@ -1,6 +1,19 @@
 #pragma once
 
+#include <stdio.h>
+
+struct Date;
+
+//
+// Reads a file a chunk at a time, so it never has to be loaded whole, and hands out
+// lines as views into the chunk: a line is only good until the next call to
+// consume_next_line. Nothing is allocated per line.
+//
+
 struct Text_File_Handler {
+    // No line can be longer than this; longer ones are reported and split up.
+    static const int CHUNK_SIZE = 32 * 1024;
+
     char *short_name = 0;
     char *full_path = 0;
 
@@ -11,19 +24,34 @@ struct Text_File_Handler {
     bool do_version_number = true;
     bool strip_comments_from_end_of_lines = true;
 
-    char *file_data = 0;
-    char *orig_file_data = 0;
-
     bool eat_spaces_before_line = true;
-    
+
     bool failed = false;
     int version = -1;
 
     int line_number = 0;
 
+    FILE *file = NULL;          // NULL once all of it has been read, or when reading from memory.
+    char *at = NULL;            // What hasn't been handed out yet,
+    char *end = NULL;           // in 'chunk' or in the memory given to start_memory.
+    bool in_comment = false;    // Stopped in the middle of a comment at the end of the chunk.
+    char chunk[CHUNK_SIZE];
+
     ~Text_File_Handler();
 
     void start_file(char *short_name, char *full_path, char *log_agent);
-    char *consume_next_line();
+    void start_memory(char *short_name, char *data, s64 size, char *log_agent); // Doesn't copy 'data'.
+
+    String consume_next_line(); // The data is NULL at the end of the file.
     void report_error(char *fmt, ...);
+    void report_error_at(int line_number, char *fmt, ...); // For something that started on an earlier line.
+
+    // The whole line has to be the field(s), give or take spaces around them. What is
+    // wrong, and in which column, goes through report_error. A NULL line is the end of the file.
+    bool parse_int(String line, int *result);
+    bool parse_date_range(String line, Date *from, Date *to); // "D.M.Y D.M.Y"
+
+    void read_version_number();
+    bool refill();
+    String next_raw_line();
 };
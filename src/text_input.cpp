@@ -72,18 +72,10 @@ bool Text_Input::is_active() {
     return active;
 }
 
-// @ToDo @CleanUp: Find a better solution
-// @ToDo @CleanUp: Find a better solution
-// @ToDo @CleanUp: Find a better solution
-char *Text_Input::get_result(int final_character) {
-    if (final_character == -1) final_character = num_characters;
-    
-    int num_characters_to_alloc = final_character * 4;
-    if (num_characters_to_alloc <= 0) num_characters_to_alloc = 1;
-    char *result = new char[num_characters_to_alloc];
+static void write_utf8(int *input_buffer, int num_characters, char *result) {
     int result_count = 0;
     
-    for (int i = 0; i < final_character; i++) {
+    for (int i = 0; i < num_characters; i++) {
         char utf8[4];
         int text_count = get_utf8(utf8, input_buffer[i]);
         
@@ -95,7 +87,21 @@ char *Text_Input::get_result(int final_character) {
     }
 
     result[result_count] = 0;
+}
+
+char *Text_Input::get_result(int final_character) {
+    if (final_character == -1) final_character = num_characters;
+    
+    char *result = new char[final_character * 4 + 1];
+    write_utf8(input_buffer, final_character, result);
+    return result;
+}
+
+char *Text_Input::get_temporary_result(int final_character) {
+    if (final_character == -1) final_character = num_characters;
     
+    char *result = (char *)temporary_storage.get(final_character * 4 + 1);
+    write_utf8(input_buffer, final_character, result);
     return result;
 }
 
@@ -144,11 +150,7 @@ void Text_Input::draw(Dynamic_Font *font, int text_x, int text_y, int entry_widt
     
     auto sys = globals.display_system;
 
-    // @ToDo @CleanUp: Find a better solution
-    // @ToDo @CleanUp: Find a better solution
-    // @ToDo @CleanUp: Find a better solution
-    char *s = get_result();
-    defer { delete s; };
+    char *s = get_temporary_result();
     
     auto b = (int)(font->character_height * 0.05f);
     if (b < 2) b = 2;
@@ -162,7 +164,7 @@ void Text_Input::draw(Dynamic_Font *font, int text_x, int text_y, int entry_widt
 
     Vector4 cursor_color = get_cursor_color(Vector4(1, 0, 1, 1));
 
-    char *text_to_left_of_cursor = get_result(cursor);
+    char *text_to_left_of_cursor = get_temporary_result(cursor);
     int width = font->get_text_width(text_to_left_of_cursor);
     int cursor_x = text_x + width;
 
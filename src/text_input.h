@@ -21,7 +21,8 @@ struct Text_Input {
     void deactivate();
 
     bool is_active();
-    char *get_result(int final_character = -1);
+    char *get_result(int final_character = -1);           // Yours to delete.
+    char *get_temporary_result(int final_character = -1); // Lasts until the end of the frame.
 
     void reset();
 
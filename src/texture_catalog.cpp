@@ -13,9 +13,15 @@ Texture_Catalog::~Texture_Catalog() {
 }
 
 Texture *Texture_Catalog::get_by_name(char *name) {
-    Texture **_texture = texture_lookup.find(name);
+    return get_by_name(intern_string(name));
+}
+
+Texture *Texture_Catalog::get_by_name(Interned_String interned_name) {
+    Texture **_texture = texture_lookup.find(interned_name);
     if (_texture) return *_texture;
 
+    char *name = get_string(interned_name);
+
     char *extensions[] = {
         "png",
         "jpg",
@@ -54,7 +60,7 @@ Texture *Texture_Catalog::get_by_name(char *name) {
     texture->name = copy_string(name);
     texture->modtime = modtime;
     
-    texture_lookup.add(name, texture);
+    texture_lookup.add(interned_name, texture);
     loaded_textures.add(texture);
     
     return texture;
@@ -5,11 +5,12 @@
 struct Texture;
 
 struct Texture_Catalog {
-    String_Hash_Table <Texture *> texture_lookup;
+    Hash_Table <Interned_String, Texture *> texture_lookup;
     Array <Texture *> loaded_textures;
 
     ~Texture_Catalog();
     
     Texture *get_by_name(char *name);
+    Texture *get_by_name(Interned_String name); // For every frame; this one is an int lookup.
     void do_hotloading();
 };
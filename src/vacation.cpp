@@ -1,7 +1,470 @@
 #include "pch.h"
 #include "vacation.h"
+#include "interval_tree.h"
+#include "overlap_kernel.h"
+#include "occupancy.h"
+#include "job_system.h"
+#include "journal.h"
+#include "save_file.h"
+
+#include <limits.h>
 
 Array <Employee *> all_employees;
+Vacation_Store vacation_store;
+Array <char *> team_names;
+u64 vacation_data_generation = 1;
+
+static u64 collision_state_generation = 0;
+static bool has_collisions_cached = false;
+
+void mark_vacation_data_changed() {
+    vacation_data_generation += 1;
+}
+
+//
+// Day numbers
+//
+// Dates are stored as the number of days since 1.1.1970, so that comparing two of them,
+// or checking whether two vacations overlap, is just integer math. We only go to and
+// from day.month.year when reading input and when displaying or saving.
+// The conversion is the days_from_civil / civil_from_days algorithm by Howard Hinnant.
+//
+
+s32 date_to_day_number(int day, int month, int year) {
+    // Allow months outside of 1..12 so that e.g. 13.2023 means 1.2024.
+    // Days outside of the month just spill over into the next or previous one.
+    month -= 1;
+    year  += (month >= 0) ? (month / 12) : ((month - 11) / 12);
+    month  = ((month % 12) + 12) % 12 + 1;
+    
+    year -= (month <= 2);
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era  = year - era * 400;                                       // [0, 399]
+    int day_of_year  = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5;        // [0, 365] without the day
+    int day_of_era   = year_of_era * 365 + year_of_era/4 - year_of_era/100 + day_of_year; // [0, 146096]
+
+    return era * 146097 + day_of_era - 719468 + (day - 1);
+}
+
+Date day_number_to_date(s32 day_number) {
+    int z = day_number + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int day_of_era  = z - era * 146097;                                                   // [0, 146096]
+    int year_of_era = (day_of_era - day_of_era/1460 + day_of_era/36524 - day_of_era/146096) / 365; // [0, 399]
+    int day_of_year = day_of_era - (365*year_of_era + year_of_era/4 - year_of_era/100);   // [0, 365]
+    int mp = (5*day_of_year + 2) / 153;                                                   // [0, 11]
+
+    Date result;
+    result.day   = day_of_year - (153*mp + 2)/5 + 1;
+    result.month = mp < 10 ? mp + 3 : mp - 9;
+    result.year  = year_of_era + era * 400 + (result.month <= 2);
+    return result;
+}
+
+bool is_valid_date(int day, int month, int year) {
+    static const int days_in_month[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (year < 1 || year > 9999) return false;
+    if (month < 1 || month > 12) return false;
+
+    int num_days = days_in_month[month - 1];
+    if (month == 2 && (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0)) num_days = 29;
+
+    return day >= 1 && day <= num_days;
+}
+
+bool parse_date(String *s, Date *date) {
+    // Only plain digits, no signs or spaces, and not so many that they could overflow.
+    static const int max_digits[3] = { 2, 2, 4 };
+
+    char *at  = s->data;
+    char *end = s->data + s->count;
+
+    int   fields[3];
+    char *field_starts[3];
+    for (int i = 0; i < 3; i++) {
+        if (i) {
+            if (at == end || *at != '.') break;
+            at += 1;
+        }
+
+        char *start = at;
+        char *digits_end = (end - at > max_digits[i]) ? at + max_digits[i] : end;
+
+        int value = 0;
+        while (at < digits_end && (u8)(*at - '0') <= 9) {
+            value = value * 10 + (*at - '0');
+            at += 1;
+        }
+
+        if (at == start || (at < end && (u8)(*at - '0') <= 9)) {
+            at = start;
+            break;
+        }
+
+        fields[i] = value;
+        field_starts[i] = start;
+
+        if (i == 2) {
+            if (!is_valid_date(fields[0], fields[1], fields[2])) {
+                // Point at whichever part is out of range.
+                if (fields[2] < 1)                        at = field_starts[2];
+                else if (fields[1] < 1 || fields[1] > 12) at = field_starts[1];
+                else                                      at = field_starts[0];
+                break;
+            }
+
+            date->day   = fields[0];
+            date->month = fields[1];
+            date->year  = fields[2];
+            s->count -= at - s->data;
+            s->data   = at;
+            return true;
+        }
+    }
+
+    s->count -= at - s->data;
+    s->data   = at;
+    return false;
+}
+
+//
+// Teams
+//
+
+static Hash_Table <Interned_String, int> team_ids_by_name;
+
+int get_team_id(char *name) {
+    if (!name || !name[0]) return 0;
+    if (!team_names.count) team_names.add("");
+
+    Interned_String interned_name = intern_string(name);
+    int *team_id = team_ids_by_name.find(interned_name);
+    if (team_id) return *team_id;
+
+    // The pool keeps the name for as long as the team is around, which is forever.
+    team_names.add(get_string(interned_name));
+    team_ids_by_name.add(interned_name, team_names.count - 1);
+    return team_names.count - 1;
+}
+
+int find_team_id(char *name) {
+    if (!name || !name[0]) return 0;
+
+    Interned_String interned_name;
+    if (!find_interned_string(name, &interned_name)) return -1;
+
+    int *team_id = team_ids_by_name.find(interned_name);
+    return team_id ? *team_id : -1;
+}
+
+char *get_team_name(int team_id) {
+    if (team_id <= 0 || team_id >= team_names.count) return "";
+    return team_names[team_id];
+}
+
+//
+// Vacation table
+//
+
+static void set_row_count(int count) {
+    auto store = &vacation_store;
+    store->count = count;
+    store->start_day.resize(count);
+    store->end_day.resize(count);
+    store->employee_id.resize(count);
+    store->team_id.resize(count);
+    store->flags.resize(count);
+    store->collision_handle.resize(count);
+}
+
+template <typename T>
+static void move_rows(Array <T> *column, int to, int from, int num_rows) {
+    memmove(&column->data[to], &column->data[from], num_rows * sizeof(T));
+}
+
+static void move_rows(int to, int from, int num_rows) {
+    auto store = &vacation_store;
+    move_rows(&store->start_day,        to, from, num_rows);
+    move_rows(&store->end_day,          to, from, num_rows);
+    move_rows(&store->employee_id,      to, from, num_rows);
+    move_rows(&store->team_id,          to, from, num_rows);
+    move_rows(&store->flags,            to, from, num_rows);
+    move_rows(&store->collision_handle, to, from, num_rows);
+}
+
+static void set_row(int row, s32 start, s32 end, int employee_id, int team_id) {
+    auto store = &vacation_store;
+    store->start_day[row]        = start;
+    store->end_day[row]          = end;
+    store->employee_id[row]      = employee_id;
+    store->team_id[row]          = team_id;
+    store->flags[row]            = 0;
+    store->collision_handle[row] = -1;
+}
+
+int Vacation_Store::add(s32 start, s32 end, int employee_id, int team_id) {
+    int row = count;
+    set_row_count(count + 1);
+    set_row(row, start, end, employee_id, team_id);
+
+    return row;
+}
+
+int Vacation_Store::add_many(s32 *starts, s32 *ends, int num_rows, int employee, int team) {
+    int first = count;
+    set_row_count(count + num_rows);
+
+    memcpy(start_day.data + first, starts, num_rows * sizeof(s32));
+    memcpy(end_day.data   + first, ends,   num_rows * sizeof(s32));
+    for (int row = first; row < first + num_rows; row++) {
+        employee_id[row]      = employee;
+        team_id[row]          = team;
+        flags[row]            = 0;
+        collision_handle[row] = -1;
+    }
+
+    return first;
+}
+
+void Vacation_Store::clear() {
+    set_row_count(0);
+    num_unused = 0;
+}
+
+// They belong to nobody afterwards.
+static void clear_rows(int row, int num_rows) {
+    for (int i = row; i < row + num_rows; i++) {
+        set_row(i, 0, 0, -1, 0);
+    }
+}
+
+//
+// Collision index
+//
+// Every vacation is kept in an interval tree, together with the number of vacations
+// of other employees that it overlaps. Adding, editing or removing a vacation only
+// has to look at the vacations that overlap it, instead of recomputing everything.
+// Only people in the same team can collide, so every team gets a tree of its own.
+//
+
+struct Collision_Entry {
+    int row;
+    int num_collisions;
+};
+
+typedef Interval_Tree <s32, Collision_Entry> Collision_Index;
+
+static Array <Collision_Index *> collision_indices; // Indexed by team id.
+
+static Collision_Index *get_collision_index(int team_id) {
+    while (collision_indices.count <= team_id) {
+        collision_indices.add(new Collision_Index());
+    }
+    return collision_indices[team_id];
+}
+
+static Collision_Index *get_collision_index_of_row(int row) {
+    return get_collision_index(vacation_store.team_id[row]);
+}
+
+static void add_collisions(Collision_Entry *entry, int delta) {
+    bool was_colliding = entry->num_collisions > 0;
+    entry->num_collisions += delta;
+    bool is_colliding = entry->num_collisions > 0;
+
+    if (was_colliding == is_colliding) return;
+
+    int row = entry->row;
+    if (is_colliding) vacation_store.flags[row] |= VACATION_IS_COLLIDING;
+    else              vacation_store.flags[row] &= ~VACATION_IS_COLLIDING;
+    
+    auto employee = all_employees[vacation_store.employee_id[row]];
+    employee->num_colliding_vacations += is_colliding ? 1 : -1;
+    employee->has_vacation_that_overlaps = employee->num_colliding_vacations > 0;
+}
+
+// While batching, the index is left alone and rebuilt once when the batch ends.
+static int batched_changes_depth = 0;
+static bool rebuild_after_batch = false;
+
+static bool skip_index_update() {
+    if (!batched_changes_depth) return false;
+
+    rebuild_after_batch = true;
+    return true;
+}
+
+void begin_batched_changes() {
+    if (!batched_changes_depth) invalidate_occupancy(); // So that it doesn't get updated per change either.
+    batched_changes_depth += 1;
+}
+
+void end_batched_changes() {
+    batched_changes_depth -= 1;
+    if (batched_changes_depth || !rebuild_after_batch) return;
+
+    rebuild_after_batch = false;
+    update_collding_for_all_infos();
+}
+
+// These rows have moved, so the index has to be told where they are now.
+static void update_collision_rows(int first, int num_rows) {
+    if (skip_index_update()) return;
+
+    auto store = &vacation_store;
+    for (int row = first; row < first + num_rows; row++) {
+        int handle = store->collision_handle[row];
+        if (handle < 0) continue;
+
+        collision_indices[store->team_id[row]]->get(handle)->value.row = row;
+    }
+}
+
+//
+// Blocks of rows
+//
+// An employee's block has room for vacation_capacity rows. Adding to a full block moves
+// it to the end of the table with twice the room, which only touches that employee's
+// rows; the rows it leaves behind belong to nobody. Once those are half of the table,
+// every block is packed together again, in all_employees order.
+//
+
+template <typename T>
+static void pack_column(Array <T> *column, Array <int> *new_firsts, int count) {
+    static Array <T> packed;
+    packed.resize(count);
+
+    for (auto employee : all_employees) {
+        memcpy(&packed.data[(*new_firsts)[employee->id]], &column->data[employee->first_vacation], employee->num_vacations * sizeof(T));
+    }
+
+    // The old column is kept for next time.
+    Array <T> old = static_cast<Array <T> &&>(*column);
+    *column = static_cast<Array <T> &&>(packed);
+    packed  = static_cast<Array <T> &&>(old);
+}
+
+// Every employee keeps the room they have, and gets room for at least 'num_new[id]' more
+// if that is given.
+static void pack_rows(Array <int> *num_new = NULL) {
+    auto store = &vacation_store;
+
+    static Array <int> new_firsts;
+    new_firsts.resize(all_employees.count);
+
+    int count = 0;
+    for (auto employee : all_employees) {
+        int capacity = Max(employee->vacation_capacity, employee->num_vacations);
+        if (num_new) capacity = Max(capacity, employee->num_vacations + (*num_new)[employee->id]);
+
+        new_firsts[employee->id] = count;
+        employee->vacation_capacity = capacity;
+        count += capacity;
+    }
+
+    pack_column(&store->start_day,        &new_firsts, count);
+    pack_column(&store->end_day,          &new_firsts, count);
+    pack_column(&store->employee_id,      &new_firsts, count);
+    pack_column(&store->team_id,          &new_firsts, count);
+    pack_column(&store->flags,            &new_firsts, count);
+    pack_column(&store->collision_handle, &new_firsts, count);
+    store->count = count;
+    store->num_unused = 0;
+
+    for (auto employee : all_employees) {
+        employee->first_vacation = new_firsts[employee->id];
+        clear_rows(employee->first_vacation + employee->num_vacations, employee->vacation_capacity - employee->num_vacations);
+    }
+
+    update_collision_rows(0, count);
+}
+
+static void leave_rows_unused(int first, int num_rows) {
+    clear_rows(first, num_rows);
+
+    auto store = &vacation_store;
+    store->num_unused += num_rows;
+    if (store->num_unused > store->count / 2) pack_rows();
+}
+
+// Makes room for one more vacation at the end of the employee's block.
+static void grow_vacation_block(Employee *employee) {
+    auto store = &vacation_store;
+
+    int first        = employee->first_vacation;
+    int num          = employee->num_vacations;
+    int old_capacity = Max(employee->vacation_capacity, num);
+    int capacity     = Max(num * 2, 4);
+
+    // The last block can just get longer.
+    if (first + old_capacity == store->count) {
+        set_row_count(first + capacity);
+        clear_rows(first + old_capacity, capacity - old_capacity);
+        employee->vacation_capacity = capacity;
+        return;
+    }
+
+    int new_first = store->count;
+    set_row_count(new_first + capacity);
+    move_rows(new_first, first, num);
+    clear_rows(new_first + num, capacity - num);
+
+    employee->first_vacation    = new_first;
+    employee->vacation_capacity = capacity;
+    update_collision_rows(new_first, num);
+
+    leave_rows_unused(first, old_capacity);
+}
+
+static void register_vacation(int row) {
+    if (skip_index_update()) return;
+
+    s32 start = vacation_store.start_day[row];
+    s32 end   = vacation_store.end_day[row];
+    s32 id    = vacation_store.employee_id[row];
+
+    auto index = get_collision_index_of_row(row);
+
+    int num_collisions = 0;
+    index->for_each_overlapping(start, end, [&](int, auto node) {
+        if (vacation_store.employee_id[node->value.row] == id) return;
+        add_collisions(&node->value, 1);
+        num_collisions += 1;
+    });
+
+    Collision_Entry entry;
+    entry.row            = row;
+    entry.num_collisions = 0;
+
+    vacation_store.flags[row] &= ~VACATION_IS_COLLIDING;
+    
+    int handle = index->insert(start, end, entry);
+    vacation_store.collision_handle[row] = handle;
+    add_collisions(&index->get(handle)->value, num_collisions);
+}
+
+static void unregister_vacation(int row) {
+    if (skip_index_update()) return;
+
+    auto index = get_collision_index_of_row(row);
+    
+    int handle = vacation_store.collision_handle[row];
+    auto node = index->get(handle);
+    
+    s32 start = node->start;
+    s32 end   = node->end;
+    s32 id    = vacation_store.employee_id[row];
+    add_collisions(&node->value, -node->value.num_collisions);
+
+    index->remove(handle);
+    vacation_store.collision_handle[row] = -1;
+
+    index->for_each_overlapping(start, end, [&](int, auto node) {
+        if (vacation_store.employee_id[node->value.row] == id) return;
+        add_collisions(&node->value, -1);
+    });
+}
 
 Employee *add_employee(char *name) {
     Employee *result = new Employee();
@@ -9,133 +472,746 @@ Employee *add_employee(char *name) {
     result->name  = copy_string(name);
     result->draw_all_vacations_on_hud = true;
     result->has_vacation_that_overlaps = false;
+
+    result->id = all_employees.count;
+    result->team_id = 0;
+    result->first_vacation = vacation_store.count;
+    result->num_vacations  = 0;
     
     all_employees.add(result);
+    journal_add_employee(result);
+    mark_vacation_data_changed();
     
     return result;
 }
 
-Vacation_Info *Employee::add_vacation_info(int from_day, int from_month, int from_year, int to_day, int to_month, int to_year) {
-    Vacation_Info *info = vacations.add();
+void remove_employee(Employee *employee) {
+    load_all_vacations(); // The years that aren't loaded refer to employees by id.
+    journal_remove_employee(employee);
+
+    int first = employee->first_vacation;
+    int num   = employee->num_vacations;
     
-    info->from_year    = from_year;
-    info->from_month   = from_month;
-    info->from_day     = from_day;
-    info->to_year      = to_year;
-    info->to_month     = to_month;
-    info->to_day       = to_day;
+    for (int row = first; row < first + num; row++) {
+        unregister_vacation(row);
+    }
 
-    info->is_colliding = false;
+    int id = employee->id;
+    all_employees.ordered_remove_by_index(id);
 
-    return info;
+    // Everybody after the removed employee moved down by one.
+    for (int i = id; i < all_employees.count; i++) {
+        all_employees[i]->id = i;
+    }
+    for (int row = 0; row < vacation_store.count; row++) {
+        if (vacation_store.employee_id[row] > id) vacation_store.employee_id[row] -= 1;
+    }
+    invalidate_occupancy(); // Employee ids moved.
+
+    int capacity = Max(employee->vacation_capacity, num);
+    employee->id = -1;
+    employee->num_vacations = 0;
+    employee->vacation_capacity = 0;
+
+    leave_rows_unused(first, capacity);
+
+    mark_vacation_data_changed();
+}
+
+void set_employee_name(Employee *employee, char *name) {
+    if (employee->name && !employee->name_is_borrowed) delete [] employee->name;
+
+    employee->name = name;
+    employee->name_is_borrowed = false;
+    journal_rename_employee(employee);
+    mark_vacation_data_changed();
 }
 
-struct Date {
-    int year;
-    int month;
-    int day;
+void set_employee_shown_on_hud(Employee *employee, bool shown) {
+    employee->draw_all_vacations_on_hud = shown;
+    journal_set_employee_shown_on_hud(employee);
+}
+
+void set_employee_team(Employee *employee, char *team_name) {
+    int team_id = get_team_id(team_name);
+    if (employee->team_id == team_id) return;
+
+    int first = employee->first_vacation;
+    int num   = employee->num_vacations;
+
+    for (int row = first; row < first + num; row++) {
+        unregister_vacation(row);
+    }
+
+    employee->team_id = team_id;
+    for (int row = first; row < first + num; row++) {
+        vacation_store.team_id[row] = team_id;
+        register_vacation(row);
+    }
+
+    journal_set_employee_team(employee);
+    mark_vacation_data_changed();
+}
+
+// A vacation has to be checked against everything it could collide with, and has to go
+// after the other ones from its year, as it will when they are loaded again.
+int Employee::add_vacation_info(s32 from, s32 to) {
+    load_vacations_near(from, from, to);
+
+    if (num_vacations >= vacation_capacity) grow_vacation_block(this);
+
+    int row = first_vacation + num_vacations;
+    set_row(row, from, to, id, team_id);
+    num_vacations += 1;
+
+    register_vacation(row);
+    occupancy_add_vacation(row);
+    journal_add_vacation(this, from, to);
+    mark_vacation_data_changed();
+
+    return num_vacations - 1;
+}
+
+void Employee::edit_vacation_info(int index, s32 from, s32 to) {
+    load_vacations_near(from, from, to); // Can move the rows, so the row is only worked out after.
+    journal_edit_vacation(this, index, from, to);
+
+    int row = first_vacation + index;
+    unregister_vacation(row);
+    occupancy_remove_vacation(row);
+    
+    vacation_store.start_day[row] = from;
+    vacation_store.end_day[row]   = to;
 
-    Date() = default;
-    Date(Vacation_Info info, bool from) {
-        if (from) {
-            year  = info.from_year;
-            month = info.from_month;
-            day   = info.from_day;
-        } else {
-            year  = info.to_year;
-            month = info.to_month;
-            day   = info.to_day;
+    register_vacation(row);
+    occupancy_add_vacation(row);
+    mark_vacation_data_changed();
+}
+
+void Employee::remove_vacation_info(int index) {
+    journal_remove_vacation(this, index);
+
+    int row = first_vacation + index;
+    unregister_vacation(row);
+    occupancy_remove_vacation(row);
+
+    // The rest of the block moves up, and the room at its end stays the employee's.
+    int num_after = num_vacations - index - 1;
+    move_rows(row, row + 1, num_after);
+    clear_rows(row + num_after, 1);
+    num_vacations -= 1;
+
+    update_collision_rows(row, num_after);
+
+    mark_vacation_data_changed();
+}
+
+void add_vacations(Array <New_Vacation> *vacations, bool from_snapshot) {
+    if (!vacations->count) return;
+
+    // Everything is rebuilt once at the end, so the rows can move without telling anyone.
+    begin_batched_changes();
+    rebuild_after_batch = true;
+
+    if (!from_snapshot) {
+        s32 earliest = INT_MAX, latest = INT_MIN, last_end = INT_MIN;
+        for (auto vacation : *vacations) {
+            earliest = Min(earliest, vacation.start);
+            latest   = Max(latest, vacation.start);
+            last_end = Max(last_end, vacation.end);
         }
+        load_vacations_near(earliest, latest, last_end);
     }
-};
 
-inline bool operator<(Date a, Date b) {
-    if (a.day == b.day && a.month == b.month && a.year == b.year)
-        return false;
+    Array <int> num_new;
+    num_new.resize(all_employees.count);
+    memset(num_new.data, 0, num_new.count * sizeof(int));
+    for (auto vacation : *vacations) num_new[vacation.employee_id] += 1;
 
-    if (a.year > b.year || a.year == b.year && a.month > b.month ||
-        a.year == b.year && a.month == b.month && a.day > b.day)
-        return false;
+    pack_rows(&num_new);
 
-    return true;
+    // The new rows go after the ones the employee already has, in the order they were given.
+    for (auto vacation : *vacations) {
+        auto employee = all_employees[vacation.employee_id];
+        int row = employee->first_vacation + employee->num_vacations;
+        set_row(row, vacation.start, vacation.end, employee->id, employee->team_id);
+        employee->num_vacations += 1;
+
+        if (!from_snapshot) journal_add_vacation(employee, vacation.start, vacation.end);
+    }
+
+    mark_vacation_data_changed();
+    end_batched_changes();
 }
 
-inline bool operator>(Date a, Date b) {
-    if (a.day == b.day && a.month == b.month && a.year == b.year)
-        return false;
+void find_vacations_between(s32 from, s32 to, Array <int> *rows) {
+    load_vacations_between(from, to);
 
-    if (a.year > b.year || a.year == b.year && a.month > b.month ||
-        a.year == b.year && a.month == b.month && a.day > b.day)
-        return true;
+    for (auto index : collision_indices) {
+        index->for_each_overlapping(from, to, [&](int, auto node) {
+            rows->add(node->value.row);
+        });
+    }
+}
 
-    return false;
+void find_vacations_on(s32 day, Array <int> *rows) {
+    find_vacations_between(day, day + 1, rows);
 }
 
-inline bool operator==(Date a, Date b) {
-    if (a.day == b.day && a.month == b.month && a.year == b.year)
-        return true;
+static int compare_rows(const void *a, const void *b) {
+    int row_a = *(int *)a;
+    int row_b = *(int *)b;
+    return (row_a > row_b) - (row_a < row_b);
+}
 
-    return false;
+// Blocks that have moved to the end of the table are out of all_employees order.
+static int compare_rows_by_employee(const void *a, const void *b) {
+    int row_a = *(int *)a;
+    int row_b = *(int *)b;
+    s32 id_a = vacation_store.employee_id[row_a];
+    s32 id_b = vacation_store.employee_id[row_b];
+    if (id_a != id_b) return (id_a > id_b) ? 1 : -1;
+    return (row_a > row_b) - (row_a < row_b);
 }
 
-inline bool operator!=(Date a, Date b) {
-    if (a.day == b.day && a.month == b.month && a.year == b.year)
-        return false;
+void find_employees_off_between(s32 from, s32 to, Array <Employee *> *employees) {
+    static Array <int> rows;
+    rows.count = 0;
+    find_vacations_between(from, to, &rows);
 
-    return true;
+    qsort(rows.data, rows.count, sizeof(int), compare_rows_by_employee);
+
+    s32 last_id = -1;
+    for (int row : rows) {
+        s32 id = vacation_store.employee_id[row];
+        if (id == last_id) continue;
+        
+        employees->add(all_employees[id]);
+        last_id = id;
+    }
 }
 
-inline bool operator<=(Date a, Date b) {
-    if (a < b || a == b)
-        return true;
-    
-    return false;
+void find_employees_off_on(s32 day, Array <Employee *> *employees) {
+    find_employees_off_between(day, day + 1, employees);
+}
+
+void find_team_vacations_between(int team_id, s32 from, s32 to, Array <int> *rows) {
+    load_vacations_between(from, to);
+    if (team_id < 0 || team_id >= collision_indices.count) return;
+
+    collision_indices[team_id]->for_each_overlapping(from, to, [&](int, auto node) {
+        rows->add(node->value.row);
+    });
+}
+
+void find_collisions_between(s32 from, s32 to, int team_id, Array <Vacation_Collision> *collisions) {
+    static Array <int> rows;
+    rows.count = 0;
+    if (team_id >= 0) find_team_vacations_between(team_id, from, to, &rows);
+    else              find_vacations_between(from, to, &rows);
+
+    qsort(rows.data, rows.count, sizeof(int), compare_rows);
+
+    auto store = &vacation_store;
+    for (int row : rows) {
+        if (!(store->flags[row] & VACATION_IS_COLLIDING)) continue; // The index already knows it doesn't collide.
+
+        s32 start = store->start_day[row];
+        s32 end   = store->end_day[row];
+        s32 employee_id = store->employee_id[row];
+
+        collision_indices[store->team_id[row]]->for_each_overlapping(start, end, [&](int, auto node) {
+            int other = node->value.row;
+            if (other <= row || store->employee_id[other] == employee_id) return; // Each pair once, from its first row.
+
+            // Both rows overlap [from, to), but their overlap doesn't have to.
+            s32 overlap_start = Max(start, store->start_day[other]);
+            s32 overlap_end   = Min(end,   store->end_day[other]);
+            if (overlap_end <= from || overlap_start >= to) return;
+
+            Vacation_Collision collision;
+            collision.a = row;
+            collision.b = other;
+            collisions->add(collision);
+        });
+    }
 }
 
-inline bool operator>=(Date a, Date b) {
-    if (a > b || a == b)
-        return true;
+struct Vacation_Ref {
+    s32 start;
+    s32 end;
+
+    s32 employee_id;
+    s32 team_id;
+    s32 row;
     
-    return false;
+    int index;
+};
+
+// Everything is sorted by team first, so that each team ends up in one piece
+// and can be swept on its own. Ties are broken by row, so that the order is the
+// same however the sorting is split up between threads.
+static int compare_vacation_refs_by_start(const void *a, const void *b) {
+    auto ref_a = (Vacation_Ref *)a;
+    auto ref_b = (Vacation_Ref *)b;
+    if (ref_a->team_id != ref_b->team_id) return (ref_a->team_id > ref_b->team_id) ? 1 : -1;
+    if (ref_a->start   != ref_b->start)   return (ref_a->start   > ref_b->start)   ? 1 : -1;
+    return (ref_a->row > ref_b->row) - (ref_a->row < ref_b->row);
+}
+
+static int compare_vacation_refs_by_end(const void *a, const void *b) {
+    auto ref_a = (Vacation_Ref *)a;
+    auto ref_b = (Vacation_Ref *)b;
+    if (ref_a->team_id != ref_b->team_id) return (ref_a->team_id > ref_b->team_id) ? 1 : -1;
+    if (ref_a->end     != ref_b->end)     return (ref_a->end     > ref_b->end)     ? 1 : -1;
+    return (ref_a->row > ref_b->row) - (ref_a->row < ref_b->row);
+}
+
+typedef int (*Compare_Proc)(const void *a, const void *b);
+
+// Sorts, merges and sweeps work on pieces of this many vacations at a time.
+const int PIECE_SIZE = 8192;
+
+static void merge_refs(Vacation_Ref *from, int first, int middle, int last, Vacation_Ref *to, Compare_Proc compare) {
+    int i = first;
+    int j = middle;
+    int k = first;
+
+    while (i < middle && j < last) {
+        if (compare(&from[j], &from[i]) < 0) to[k++] = from[j++];
+        else                                 to[k++] = from[i++];
+    }
+    while (i < middle) to[k++] = from[i++];
+    while (j < last)   to[k++] = from[j++];
 }
 
-static int compare_dates(Date a, Date b) {
-    if (a.day == b.day && a.month == b.month && a.year == b.year)
-        return 0;
+// Pieces are sorted on their own, then merged two at a time, one round after the other.
+static void sort_refs(Array <Vacation_Ref> *refs, Compare_Proc compare) {
+    int count = refs->count;
+    int num_pieces = (count + PIECE_SIZE - 1) / PIECE_SIZE;
 
-    if (a.year > b.year || a.year == b.year && a.month > b.month ||
-        a.year == b.year && a.month == b.month && a.day > b.day)
-        return 1;
+    run_jobs(num_pieces, [&](int piece) {
+        int first = piece * PIECE_SIZE;
+        qsort(refs->data + first, Min(PIECE_SIZE, count - first), sizeof(Vacation_Ref), compare);
+    });
+    if (num_pieces <= 1) return;
 
-    return -1;
+    static Array <Vacation_Ref> scratch;
+    scratch.resize(count);
+
+    Vacation_Ref *from = refs->data;
+    Vacation_Ref *to   = scratch.data;
+
+    for (int width = PIECE_SIZE; width < count; width *= 2) {
+        int num_merges = (count + 2*width - 1) / (2*width);
+        run_jobs(num_merges, [&](int merge) {
+            int first  = merge * 2 * width;
+            int middle = Min(first + width, count);
+            int last   = Min(first + 2*width, count);
+            merge_refs(from, first, middle, last, to, compare);
+        });
+
+        Vacation_Ref *swap = from;
+        from = to;
+        to   = swap;
+    }
+
+    if (from != refs->data) memcpy(refs->data, from, count * sizeof(Vacation_Ref));
+}
+
+// Kept around so that we don't allocate on every sweep.
+static Array <Vacation_Ref> sorted_by_start;
+static Array <Vacation_Ref> sorted_by_end;
+
+// Where each team starts in sorted_by_start; the last one is where the last team ends.
+static Array <int> team_starts;
+
+// Two vacations collide when Max(start) < Min(end), so a vacation that starts
+// and ends on the same day (or ends before it starts) can never collide.
+// We skip those here so that the sweeps don't have to care about them.
+static void gather_vacations_sorted_by_start() {
+    auto store = &vacation_store;
+    
+    sorted_by_start.count = 0;
+    sorted_by_start.reserve(store->count);
+
+    for (int row = 0; row < store->count; row++) {
+        Vacation_Ref ref;
+        ref.start       = store->start_day[row];
+        ref.end         = store->end_day[row];
+        ref.employee_id = store->employee_id[row];
+        ref.team_id     = store->team_id[row];
+        ref.row         = row;
+        ref.index       = -1;
+
+        if (ref.start < ref.end) sorted_by_start.add(ref);
+    }
+
+    sort_refs(&sorted_by_start, compare_vacation_refs_by_start);
+
+    team_starts.count = 0;
+    team_starts.reserve(team_names.count + 2);
+    for (int i = 0; i < sorted_by_start.count; i++) {
+        if (i == 0 || sorted_by_start[i].team_id != sorted_by_start[i - 1].team_id) team_starts.add(i);
+    }
+    team_starts.add(sorted_by_start.count);
+}
+
+static void mark_as_colliding(Vacation_Ref *ref) {
+    vacation_store.flags[ref->row] |= VACATION_IS_COLLIDING;
+    all_employees[ref->employee_id]->has_vacation_that_overlaps = true;
 }
 
 bool are_vacations_colliding() {
+    if (collision_state_generation != vacation_data_generation) {
+        // The index keeps the per-vacation flags up to date, we just have to look at them.
+        has_collisions_cached = false;
+        for (auto employee : all_employees) {
+            if (employee->num_colliding_vacations > 0) {
+                has_collisions_cached = true;
+                break;
+            }
+        }
+
+        collision_state_generation = vacation_data_generation;
+    }
+
+    return has_collisions_cached;
+}
+
+//
+// The sweeps go through a team's vacations in order of their start, carrying some state
+// along. To split a team between threads, every piece first works out what it would
+// add to that state on its own; going through those in order then gives every piece
+// the state it starts with, and the pieces can be swept at the same time.
+//
+
+// Forward sweep: a vacation collides with one that started before it if any of
+// those, belonging to somebody else, ends after it starts. We only need the latest
+// end overall and the latest end of a different employee than that, to answer this
+// for every employee.
+struct Forward_State {
+    s32 latest_employee = -1;
+    s32 latest_end = 0;
+    bool has_second = false;
+    s32 second_end = 0;
+};
+
+// Backward sweep: a vacation collides with one that starts after it if the first
+// of those, belonging to somebody else, starts before it ends.
+struct Backward_State {
+    Vacation_Ref *next = NULL;
+    Vacation_Ref *next_of_other_employee = NULL;
+};
+
+// The state after 'a' followed by 'b'.
+static Forward_State combine_forward_states(Forward_State a, Forward_State b) {
+    if (b.latest_employee < 0) return a;
+    if (a.latest_employee < 0) return b;
+
+    Forward_State result;
+    if (a.latest_employee == b.latest_employee) {
+        result = a;
+        result.latest_end = Max(a.latest_end, b.latest_end);
+        if (b.has_second && (!a.has_second || b.second_end > a.second_end)) {
+            result.has_second = true;
+            result.second_end = b.second_end;
+        }
+        return result;
+    }
+
+    // Everything of the other one belongs to somebody else than the latest.
+    Forward_State *latest = (b.latest_end > a.latest_end) ? &b : &a;
+    Forward_State *other  = (latest == &a) ? &b : &a;
+
+    result = *latest;
+    if (!result.has_second || other->latest_end > result.second_end) {
+        result.has_second = true;
+        result.second_end = other->latest_end;
+    }
+    return result;
+}
+
+// The state before 'a', which comes right before everything 'b' has seen.
+static Backward_State combine_backward_states(Backward_State a, Backward_State b) {
+    if (!a.next) return b;
+    if (a.next_of_other_employee) return a;
+
+    Backward_State result = a;
+    if (b.next && b.next->employee_id != a.next->employee_id) result.next_of_other_employee = b.next;
+    else                                                      result.next_of_other_employee = b.next_of_other_employee;
+    return result;
+}
+
+// Marks go to 'colliding', by position in 'refs'; with colliding == NULL this only
+// works out the state after the refs.
+static void sweep_forward(Vacation_Ref *refs, int count, Forward_State *state, u8 *colliding) {
+    for (int i = 0; i < count; i++) {
+        auto ref = &refs[i];
+
+        if (colliding) {
+            bool has_other = false;
+            s32 other_end = 0;
+            if (state->latest_employee >= 0 && state->latest_employee != ref->employee_id) {
+                has_other = true;
+                other_end = state->latest_end;
+            } else if (state->has_second) {
+                has_other = true;
+                other_end = state->second_end;
+            }
+
+            if (has_other && other_end > ref->start) colliding[i] = 1;
+        }
+
+        if (state->latest_employee < 0) {
+            state->latest_employee = ref->employee_id;
+            state->latest_end = ref->end;
+        } else if (state->latest_employee == ref->employee_id) {
+            if (ref->end > state->latest_end) state->latest_end = ref->end;
+        } else if (ref->end > state->latest_end) {
+            state->has_second = true;
+            state->second_end = state->latest_end;
+                
+            state->latest_employee = ref->employee_id;
+            state->latest_end = ref->end;
+        } else if (!state->has_second || ref->end > state->second_end) {
+            state->has_second = true;
+            state->second_end = ref->end;
+        }
+    }
+}
+
+static void sweep_backward(Vacation_Ref *refs, int count, Backward_State *state, u8 *colliding) {
+    for (int i = count - 1; i >= 0; i--) {
+        auto ref = &refs[i];
+
+        if (colliding) {
+            Vacation_Ref *other = state->next;
+            if (other && other->employee_id == ref->employee_id) other = state->next_of_other_employee;
+
+            if (other && other->start < ref->end) colliding[i] = 1;
+        }
+
+        if (state->next && state->next->employee_id != ref->employee_id) {
+            state->next_of_other_employee = state->next;
+        }
+        state->next = ref;
+    }
+}
+
+struct Sweep_Piece {
+    int first;
+    int count;
+    bool starts_team;
+    bool ends_team;
+
+    Forward_State forward_summary;   // What the piece does on its own.
+    Backward_State backward_summary;
+    Forward_State forward_start;     // What comes before it in its team.
+    Backward_State backward_start;   // What comes after it in its team.
+};
+
+bool sweep_for_colliding_vacations() {
+    gather_vacations_sorted_by_start();
+
+    static Array <Sweep_Piece> pieces;
+    pieces.count = 0;
+    
+    for (int team = 0; team + 1 < team_starts.count; team++) {
+        int team_first = team_starts[team];
+        int team_end   = team_starts[team + 1];
+
+        for (int first = team_first; first < team_end; first += PIECE_SIZE) {
+            Sweep_Piece piece = {};
+            piece.first       = first;
+            piece.count       = Min(PIECE_SIZE, team_end - first);
+            piece.starts_team = first == team_first;
+            piece.ends_team   = first + piece.count == team_end;
+
+            pieces.add(piece);
+        }
+    }
+
+    auto refs = sorted_by_start.data;
+
+    run_jobs(pieces.count, [&](int index) {
+        auto piece = &pieces[index];
+        sweep_forward(refs + piece->first, piece->count, &piece->forward_summary, NULL);
+        sweep_backward(refs + piece->first, piece->count, &piece->backward_summary, NULL);
+    });
+
+    for (int i = 0; i < pieces.count; i++) {
+        if (pieces[i].starts_team) continue;
+        pieces[i].forward_start = combine_forward_states(pieces[i - 1].forward_start, pieces[i - 1].forward_summary);
+    }
+    for (int i = pieces.count - 1; i >= 0; i--) {
+        if (pieces[i].ends_team) continue;
+        pieces[i].backward_start = combine_backward_states(pieces[i + 1].backward_summary, pieces[i + 1].backward_start);
+    }
+
+    // Each piece only marks its own part of this, so the threads never write to the same place.
+    static Array <u8> colliding;
+    colliding.resize(sorted_by_start.count);
+    memset(colliding.data, 0, colliding.count);
+
+    run_jobs(pieces.count, [&](int index) {
+        auto piece = &pieces[index];
+        
+        Forward_State forward = piece->forward_start;
+        sweep_forward(refs + piece->first, piece->count, &forward, colliding.data + piece->first);
+
+        Backward_State backward = piece->backward_start;
+        sweep_backward(refs + piece->first, piece->count, &backward, colliding.data + piece->first);
+    });
+
     bool are_colliding = false;
+    for (int i = 0; i < sorted_by_start.count; i++) {
+        if (!colliding[i]) continue;
+        
+        mark_as_colliding(&refs[i]);
+        are_colliding = true;
+    }
     
-    for (auto employee : all_employees) {
-        for (int i = 0; i < employee->vacations.count; i++) {
-            auto info = &employee->vacations[i];
-            Date employee_start(*info, true);
-            Date employee_end(*info, false);
+    return are_colliding;
+}
+
+void find_colliding_vacations(Array <Vacation_Collision> *collisions) {
+    gather_vacations_sorted_by_start();
+
+    int count = sorted_by_start.count;
+
+    // sorted_by_end refers back into sorted_by_start through 'index', so that an
+    // ending vacation can be taken out of the active set without searching for it.
+    // Both are sorted by team first, so each team covers the same range in both.
+    sorted_by_end.resize(count);
+    for (int i = 0; i < count; i++) {
+        sorted_by_start[i].index = i;
+    }
+    memcpy(sorted_by_end.data, sorted_by_start.data, count * sizeof(Vacation_Ref));
+    sort_refs(&sorted_by_end, compare_vacation_refs_by_end);
+
+    // The vacations that have started, but not yet ended, at the current point of the sweep.
+    Array <int> active;
+    Array <int> active_slot;
+    active.reserve(count);
+    active_slot.resize(count);
+
+    for (int team = 0; team + 1 < team_starts.count; team++) {
+        int team_first = team_starts[team];
+        int team_end   = team_starts[team + 1];
+        
+        active.count = 0;
+        int end_cursor = team_first;
+    
+        for (int i = team_first; i < team_end; i++) {
+            auto ref = &sorted_by_start[i];
+        
+            // Endpoints are exclusive, so everything that ends on the day we start is already gone.
+            while (end_cursor < team_end && sorted_by_end[end_cursor].end <= ref->start) {
+                int ended = sorted_by_end[end_cursor].index;
+                int slot  = active_slot[ended];
+
+                int last = active[active.count - 1];
+                active[slot] = last;
+                active_slot[last] = slot;
+                active.count--;
             
-            for (auto other : all_employees) {
-                if (employee == other) continue;
-
-                for (int j = 0; j < other->vacations.count; j++) {
-                    Vacation_Info *other_info = &other->vacations[j];
-                    Date other_start(*other_info, true);
-                    Date other_end(*other_info, false);
-                    
-                    if (Max(employee_start, other_start) < Min(employee_end, other_end)) {
-                        employee->has_vacation_that_overlaps = true;
-                        other->has_vacation_that_overlaps = true;
-
-                        info->is_colliding = true;
-                        other_info->is_colliding = true;
-                        
-                        are_colliding = true;
-                    }
+                end_cursor++;
+            }
+
+            for (auto index : active) {
+                auto other = &sorted_by_start[index];
+                if (other->employee_id == ref->employee_id) continue;
+
+                Vacation_Collision collision;
+                collision.a = other->row;
+                collision.b = ref->row;
+                collisions->add(collision);
+            }
+
+            active_slot[i] = active.count;
+            active.add(i);
+        }
+    }
+}
+
+//
+// The vacations of each team, one after the other, with a column per field
+// like vacation_store, so that the overlap kernel and the rebuild can go
+// through one team at a time. Rows of a team stay in vacation_store order.
+//
+struct Team_Partition {
+    Array <s32> start_day;
+    Array <s32> end_day;
+    Array <s32> employee_id;
+    Array <s32> row;
+
+    Array <int> team_first; // Where each team starts; one more than there are teams.
+};
+
+static void partition_by_team(Team_Partition *partition) {
+    auto store = &vacation_store;
+    int num_teams = Max(team_names.count, 1);
+
+    partition->team_first.resize(num_teams + 1);
+    memset(partition->team_first.data, 0, partition->team_first.count * sizeof(int));
+
+    for (int row = 0; row < store->count; row++) {
+        if (store->employee_id[row] < 0) continue;
+        partition->team_first[store->team_id[row] + 1] += 1;
+    }
+    for (int team = 0; team < num_teams; team++) {
+        partition->team_first[team + 1] += partition->team_first[team];
+    }
+
+    partition->start_day.resize(store->count);
+    partition->end_day.resize(store->count);
+    partition->employee_id.resize(store->count);
+    partition->row.resize(store->count);
+
+    static Array <int> cursors;
+    cursors.resize(num_teams);
+    memcpy(cursors.data, partition->team_first.data, num_teams * sizeof(int));
+
+    for (int row = 0; row < store->count; row++) {
+        if (store->employee_id[row] < 0) continue;
+
+        int i = cursors[store->team_id[row]]++;
+        partition->start_day[i]   = store->start_day[row];
+        partition->end_day[i]     = store->end_day[row];
+        partition->employee_id[i] = store->employee_id[row];
+        partition->row[i]         = row;
+    }
+}
+
+// Every pair of vacations in a team, one at a time, marking both of a colliding pair.
+bool are_vacations_colliding_brute_force() {
+    static Team_Partition partition;
+    partition_by_team(&partition);
+
+    bool are_colliding = false;
+
+    for (int team = 0; team + 1 < partition.team_first.count; team++) {
+        int first = partition.team_first[team];
+        int last  = partition.team_first[team + 1];
+
+        for (int i = first; i < last; i++) {
+            s32 start = partition.start_day[i];
+            s32 end   = partition.end_day[i];
+            s32 id    = partition.employee_id[i];
+
+            for (int j = first; j < last; j++) {
+                s32 other_id = partition.employee_id[j];
+                if (other_id == id) continue;
+
+                if (Max(start, partition.start_day[j]) < Min(end, partition.end_day[j])) {
+                    all_employees[id]->has_vacation_that_overlaps = true;
+                    all_employees[other_id]->has_vacation_that_overlaps = true;
+
+                    vacation_store.flags[partition.row[i]] |= VACATION_IS_COLLIDING;
+                    vacation_store.flags[partition.row[j]] |= VACATION_IS_COLLIDING;
+
+                    are_colliding = true;
                 }
             }
         }
@@ -144,14 +1220,196 @@ bool are_vacations_colliding() {
     return are_colliding;
 }
 
+// Every vacation against the rest of its team, which the overlap kernel does several at a time.
+// Overlapping goes both ways, so each vacation only has to mark itself, and can stop at the
+// first vacation it overlaps.
+bool are_vacations_colliding_with_kernel() {
+    static Team_Partition partition;
+    partition_by_team(&partition);
+    
+    bool are_colliding = false;
+
+    for (int team = 0; team + 1 < partition.team_first.count; team++) {
+        int first = partition.team_first[team];
+        int count = partition.team_first[team + 1] - first;
+
+        s32 *starts       = partition.start_day.data + first;
+        s32 *ends         = partition.end_day.data + first;
+        s32 *employee_ids = partition.employee_id.data + first;
+        
+        for (int i = 0; i < count; i++) {
+            s32 id = employee_ids[i];
+            
+            if (overlaps_any_other_employee(starts[i], ends[i], id, starts, ends, employee_ids, count)) {
+                all_employees[id]->has_vacation_that_overlaps = true;
+                vacation_store.flags[partition.row[first + i]] |= VACATION_IS_COLLIDING;
+                are_colliding = true;
+            }
+        }
+    }
+
+    return are_colliding;
+}
+
+static int compare_day_numbers(const void *a, const void *b) {
+    s32 day_a = *(s32 *)a;
+    s32 day_b = *(s32 *)b;
+    return (day_a > day_b) - (day_a < day_b);
+}
+
+// Number of days in the sorted array that are before 'day'.
+static int count_days_before(s32 *days, int count, s32 day) {
+    int low  = 0;
+    int high = count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (days[mid] < day) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Number of days in the sorted array that are before or on 'day'.
+static int count_days_up_to(s32 *days, int count, s32 day) {
+    int low  = 0;
+    int high = count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (days[mid] <= day) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Starts and ends of 'num' rows, skipping the ones that can't collide.
+// Returns how many there are.
+static int gather_endpoints(s32 *row_starts, s32 *row_ends, int num, s32 *starts, s32 *ends) {
+    int count = 0;
+    for (int i = 0; i < num; i++) {
+        if (!(row_starts[i] < row_ends[i])) continue;
+
+        starts[count] = row_starts[i];
+        ends[count]   = row_ends[i];
+        count += 1;
+    }
+    return count;
+}
+
+// Going through register_vacation() for everything would touch every colliding pair,
+// which is a lot when everybody is off at the same time. Instead we count, for every
+// vacation, how many vacations start before it ends minus how many end before it
+// starts; once over the employee's team and once over the employee's own vacations.
 void update_collding_for_all_infos() {
+    if (skip_index_update()) return;
+
+    mark_vacation_data_changed();
+    invalidate_occupancy();
+    
+    for (auto index : collision_indices) {
+        index->clear();
+    }
+
+    auto store = &vacation_store;
+    
     for (auto employee : all_employees) {
         employee->has_vacation_that_overlaps = false;
-        for (int j = 0; j < employee->vacations.count; j++) {
-            auto info = &employee->vacations[j];
-            info->is_colliding = false;
-        }
+        employee->num_colliding_vacations = 0;
+    }
+    for (int row = 0; row < store->count; row++) {
+        store->flags[row] &= ~VACATION_IS_COLLIDING;
+    }
+
+    static Team_Partition partition;
+    partition_by_team(&partition);
+
+    static Array <s32> starts_by_team;
+    static Array <s32> ends_by_team;
+    starts_by_team.resize(store->count);
+    ends_by_team.resize(store->count);
+
+    int num_teams = partition.team_first.count - 1;
+    
+    static Array <int> team_counts;
+    team_counts.resize(num_teams);
+    for (int team = 0; team < num_teams; team++) {
+        int first = partition.team_first[team];
+        int num   = partition.team_first[team + 1] - first;
+        team_counts[team] = gather_endpoints(partition.start_day.data + first, partition.end_day.data + first, num,
+                                             starts_by_team.data + first, ends_by_team.data + first);
     }
 
-    are_vacations_colliding(); // Update infos
+    // The starts and the ends of every team get sorted at the same time.
+    run_jobs(num_teams * 2, [&](int job) {
+        int team = job / 2;
+        s32 *days = ((job % 2) ? ends_by_team.data : starts_by_team.data) + partition.team_first[team];
+        qsort(days, team_counts[team], sizeof(s32), compare_day_numbers);
+    });
+
+    // Employees only look at their own vacations and the sorted days of their team,
+    // so they can be counted in any order, each into its own rows.
+    static Array <s32> num_collisions_by_row;
+    num_collisions_by_row.resize(store->count);
+
+    const int EMPLOYEES_PER_JOB = 256;
+    int num_employee_jobs = (all_employees.count + EMPLOYEES_PER_JOB - 1) / EMPLOYEES_PER_JOB;
+    
+    run_jobs(num_employee_jobs, [&](int job) {
+        Array <s32> own_starts;
+        Array <s32> own_ends;
+
+        int last_employee = Min((job + 1) * EMPLOYEES_PER_JOB, all_employees.count);
+        for (int i = job * EMPLOYEES_PER_JOB; i < last_employee; i++) {
+            auto employee = all_employees[i];
+            
+            int first = employee->first_vacation;
+            int num   = employee->num_vacations;
+
+            int team = employee->team_id;
+            s32 *all_starts = starts_by_team.data + partition.team_first[team];
+            s32 *all_ends   = ends_by_team.data + partition.team_first[team];
+            int num_all     = team_counts[team];
+        
+            own_starts.resize(num);
+            own_ends.resize(num);
+            int num_own = gather_endpoints(store->start_day.data + first, store->end_day.data + first, num,
+                                           own_starts.data, own_ends.data);
+            qsort(own_starts.data, num_own, sizeof(s32), compare_day_numbers);
+            qsort(own_ends.data,   num_own, sizeof(s32), compare_day_numbers);
+
+            for (int row = first; row < first + num; row++) {
+                s32 start = store->start_day[row];
+                s32 end   = store->end_day[row];
+
+                int num_collisions = 0;
+                if (start < end) {
+                    int overlapping_all = count_days_before(all_starts, num_all, end) - count_days_up_to(all_ends, num_all, start);
+                    int overlapping_own = count_days_before(own_starts.data, num_own, end) - count_days_up_to(own_ends.data, num_own, start);
+                    num_collisions = overlapping_all - overlapping_own;
+                }
+                num_collisions_by_row[row] = num_collisions;
+            }
+        }
+    });
+
+    // Every team has a tree of its own, and the employees and rows it touches
+    // belong to that team only, so the trees can be filled at the same time.
+    // Rows go in in the same order either way, so the trees come out the same.
+    if (num_teams) get_collision_index(num_teams - 1);
+    
+    run_jobs(num_teams, [&](int team) {
+        auto index = collision_indices[team];
+        
+        int last = partition.team_first[team + 1];
+        for (int i = partition.team_first[team]; i < last; i++) {
+            int row = partition.row[i];
+            
+            Collision_Entry entry;
+            entry.row            = row;
+            entry.num_collisions = 0;
+
+            int handle = index->insert(store->start_day[row], store->end_day[row], entry);
+            store->collision_handle[row] = handle;
+            add_collisions(&index->get(handle)->value, num_collisions_by_row[row]);
+        }
+    });
 }
@@ -1,38 +1,139 @@
 #pragma once
 
-struct Vacation_Info {
-    int from_year;
-    int from_month;
-    int from_day;
-    int to_year;
-    int to_month;
-    int to_day;
-
-    bool is_colliding;
+struct Date {
+    int day;
+    int month;
+    int year;
 };
 
-inline bool operator==(Vacation_Info a, Vacation_Info b) {
-    return ((a.from_year  == b.from_year) &&
-            (a.from_month == b.from_month) &&
-            (a.from_day   == b.from_day) &&
-            (a.to_year    == b.to_year) &&
-            (a.to_month   == b.to_month) &&
-            (a.to_day     == b.to_day));
-}
+s32 date_to_day_number(int day, int month, int year);
+Date day_number_to_date(s32 day_number);
+
+bool is_valid_date(int day, int month, int year); // Unlike date_to_day_number, nothing spills over.
+
+// Reads D.M.Y from the start of 's' and advances past it. Only valid dates are taken;
+// on failure 's' is left at the field that is wrong.
+bool parse_date(String *s, Date *date);
+
+enum Vacation_Flags : u8 {
+    VACATION_IS_COLLIDING = 0x1,
+};
+
+//
+// All vacations live in one table, with one array per field, so that the collision
+// checks, the HUD and saving only go through the fields they actually need.
+// The vacations of an employee are next to each other, in a block that can have room
+// for more after them; an Employee only knows where its rows start and how many there are.
+// Blocks are in all_employees order after loading, but one that runs out of room moves
+// to the end. Rows that belong to nobody have an employee_id of -1 and end on the day
+// they start, so they never collide; anything going through every row has to skip them.
+//
+// Dates are day numbers (see date_to_day_number); the end is exclusive when checking for collisions.
+//
+struct Vacation_Store {
+    Array <s32> start_day;
+    Array <s32> end_day;
+    Array <s32> employee_id;      // Index of the employee in all_employees.
+    Array <s32> team_id;          // The employee's team, see get_team_id.
+    Array <u8>  flags;            // Vacation_Flags.
+    Array <s32> collision_handle; // Where the vacation lives in the collision index.
+
+    int count = 0;
+    int num_unused = 0; // Rows between the blocks that belong to nobody.
+
+    // Appends a row without going through the collision index; only for building
+    // the table in order, e.g. when loading. Call update_collding_for_all_infos() after.
+    int add(s32 start, s32 end, int employee_id, int team_id);
+    int add_many(s32 *starts, s32 *ends, int num_rows, int employee_id, int team_id); // Returns the first row.
+    void clear();
+};
+
+extern Vacation_Store vacation_store;
 
 struct Employee {
-    char *name = NULL;
-    Array <Vacation_Info> vacations;
+    char *name = NULL;             // Change it with set_employee_name.
+    bool name_is_borrowed = false; // Points into the loaded snapshot, so it isn't ours to free.
+
+    int id = -1;            // Index in all_employees.
+    int team_id = 0;        // Change it with set_employee_team.
+    int first_vacation = 0; // Row in vacation_store.
+    int num_vacations  = 0;
+    int vacation_capacity = 0; // The rows of the block, used or not.
 
     bool has_vacation_that_overlaps = false;
-    bool draw_all_vacations_on_hud = true;
-    
-    Vacation_Info *add_vacation_info(int from_day, int from_month, int from_year, int to_day, int to_month, int to_year);
+    bool draw_all_vacations_on_hud = true; // Change it with set_employee_shown_on_hud.
+
+    int num_colliding_vacations = 0;
+
+    // These keep the table and the collision flags up to date, so don't change vacation_store directly.
+    // 'index' counts from the employee's first vacation.
+    int add_vacation_info(s32 from, s32 to);
+    void edit_vacation_info(int index, s32 from, s32 to);
+    void remove_vacation_info(int index);
+};
+
+// Rows in vacation_store.
+struct Vacation_Collision {
+    int a;
+    int b;
 };
 
 extern Array <Employee *> all_employees;
 
+// Bumped whenever an employee or a vacation changes, so that anything derived
+// from them only has to be recomputed when this differs from what it was made from.
+extern u64 vacation_data_generation;
+void mark_vacation_data_changed(); // For changes made without going through the calls below, e.g. renames.
+
 Employee *add_employee(char *name);
+void remove_employee(Employee *employee);
+void set_employee_team(Employee *employee, char *team_name);
+void set_employee_name(Employee *employee, char *name); // Takes ownership of 'name'.
+void set_employee_shown_on_hud(Employee *employee, bool shown);
+
+struct New_Vacation {
+    int employee_id;
+    s32 start;
+    s32 end;
+};
+
+// For lots of vacations at once, e.g. imports: one pass over vacation_store and one
+// rebuild, instead of moving rows and updating the index for every vacation. Each goes
+// after the ones its employee already has, in the order they are given.
+// 'from_snapshot' is for vacations that are saved already, like the years loaded after
+// startup: they aren't written to the journal.
+void add_vacations(Array <New_Vacation> *vacations, bool from_snapshot = false);
+
+// Only people in the same team can have colliding vacations. Team 0 is everybody
+// without a team, so until teams are set up, everybody is checked against everybody.
+extern Array <char *> team_names; // Indexed by team id.
+int get_team_id(char *name); // Adds the team if there is none with that name yet.
+int find_team_id(char *name); // -1 if there is no team with that name.
+char *get_team_name(int team_id);
+
+bool are_vacations_colliding(); // Cached; cheap enough to call every frame.
+bool sweep_for_colliding_vacations(); // Sets the flags by sorting and sweeping over everything, without the index.
+bool are_vacations_colliding_brute_force(); // The O(n^2) check of every pair; used as a reference by the benchmarks.
+bool are_vacations_colliding_with_kernel(); // The same, through the overlap kernel, which stops at the first overlap. For the benchmarks.
+void find_colliding_vacations(Array <Vacation_Collision> *collisions);
+void update_collding_for_all_infos(); // Rebuilds the collision index from scratch, e.g. after loading.
+
+// Between these the collision index and the collision flags go stale, and everything is
+// rebuilt once at the end, instead of after every change. For making lots of changes at
+// once, e.g. replaying the journal. They nest.
+void begin_batched_changes();
+void end_batched_changes();
+
+// Queries over the collision index, in O(log n + k). Vacations that end on or before
+// they start are never returned. The results are added to what is already in the array.
+// Years that aren't loaded yet and have anything in the range are loaded first, which
+// moves rows, so don't hold on to rows from before a query.
+void find_vacations_between(s32 from, s32 to, Array <int> *rows); // Rows in vacation_store that share a day with [from, to).
+void find_vacations_on(s32 day, Array <int> *rows);
+void find_employees_off_between(s32 from, s32 to, Array <Employee *> *employees); // Each employee only once, in all_employees order.
+void find_employees_off_on(s32 day, Array <Employee *> *employees);
+void find_team_vacations_between(int team_id, s32 from, s32 to, Array <int> *rows); // Only goes through that team's tree.
 
-bool are_vacations_colliding();
-void update_collding_for_all_infos();
+// Pairs of colliding vacations whose overlap shares a day with [from, to), in one team,
+// or in all of them if 'team_id' is -1. Each pair comes once, with a < b, sorted by a.
+void find_collisions_between(s32 from, s32 to, int team_id, Array <Vacation_Collision> *collisions);